@@ -0,0 +1,126 @@
+#include "melatonin_test_helpers/melatonin_test_helpers.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+// Run with the RunBenchmarks target, or pass Catch2 a reporter yourself, e.g.
+//   Benchmarks --reporter xml::out=benchmarks.xml --reporter console::out=-
+// Filter by helper with tags, e.g. Benchmarks "[rms]"
+
+using namespace melatonin;
+
+namespace
+{
+    constexpr float sampleRate = 48000.f;
+
+    // 16 channels of 10 minutes of double is 3.6GB, so the biggest blocks are skipped above this
+    constexpr size_t maxBenchmarkBytes = 512 * 1024 * 1024;
+
+    template <typename SampleType>
+    struct BenchmarkBlock
+    {
+        juce::HeapBlock<char> data;
+        AudioBlock<SampleType> block;
+
+        // rendered straight from an Oscillator, so the SignalCache isn't part of the picture
+        BenchmarkBlock (size_t numChannels, size_t numSamples) : block (data, numChannels, numSamples)
+        {
+            Oscillator<SampleType> (440.f, sampleRate).renderSine (block);
+        }
+
+        explicit BenchmarkBlock (const AudioBlock<SampleType>& source) : block (data, source.getNumChannels(), source.getNumSamples())
+        {
+            block.copyFrom (source);
+        }
+    };
+
+    // 64 samples up to 10 minutes, 1 to 16 channels
+    template <typename SampleType, typename Function>
+    void benchmarkSizes (const std::string& name, Function&& function)
+    {
+        auto numChannels = GENERATE (1, 2, 16);
+        auto numSamples = GENERATE (64, 512, 48000, 48000 * 60 * 10);
+
+        if ((size_t) numChannels * (size_t) numSamples * sizeof (SampleType) > maxBenchmarkBytes)
+            return;
+
+        BenchmarkBlock<SampleType> input ((size_t) numChannels, (size_t) numSamples);
+        BENCHMARK (name + " " + std::to_string (numChannels) + "ch " + std::to_string (numSamples))
+        {
+            return function (input.block);
+        };
+    }
+
+    // Same sizes, for helpers that change the block in place.
+    // Every run gets its own fresh copy, made outside the timed part.
+    template <typename SampleType, typename Function>
+    void benchmarkSizesOnCopies (const std::string& name, Function&& function)
+    {
+        auto numChannels = GENERATE (1, 2, 16);
+        auto numSamples = GENERATE (64, 512, 48000, 48000 * 60 * 10);
+
+        if ((size_t) numChannels * (size_t) numSamples * sizeof (SampleType) > maxBenchmarkBytes)
+            return;
+
+        BenchmarkBlock<SampleType> input ((size_t) numChannels, (size_t) numSamples);
+        BENCHMARK_ADVANCED (name + " " + std::to_string (numChannels) + "ch " + std::to_string (numSamples)) (Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::unique_ptr<BenchmarkBlock<SampleType>>> copies;
+            for (int i = 0; i < meter.runs(); ++i)
+                copies.push_back (std::make_unique<BenchmarkBlock<SampleType>> (input.block));
+
+            meter.measure ([&] (int i) { return function (copies[(size_t) i]->block); });
+        };
+    }
+}
+
+TEMPLATE_TEST_CASE ("rms", "[benchmarks][rms]", float, double)
+{
+    benchmarkSizes<TestType> ("rms", [] (auto& block) { return rms (block); });
+}
+
+TEMPLATE_TEST_CASE ("validAudio", "[benchmarks][validAudio]", float, double)
+{
+    benchmarkSizes<TestType> ("validAudio", [] (auto& block) { return validAudio (block); });
+}
+
+TEMPLATE_TEST_CASE ("maxMagnitude", "[benchmarks][maxMagnitude]", float, double)
+{
+    benchmarkSizes<TestType> ("maxMagnitude", [] (auto& block) { return maxMagnitude (block); });
+}
+
+TEMPLATE_TEST_CASE ("isEqualTo", "[benchmarks][isEqualTo]", float, double)
+{
+    auto numChannels = GENERATE (1, 2, 16);
+    auto numSamples = GENERATE (64, 512, 48000, 48000 * 60 * 10);
+
+    if ((size_t) numChannels * (size_t) numSamples * sizeof (TestType) > maxBenchmarkBytes)
+        return;
+
+    // a separate copy made outside the timed part, so every run streams two blocks like a real comparison
+    BenchmarkBlock<TestType> input ((size_t) numChannels, (size_t) numSamples);
+    BenchmarkBlock<TestType> expected (input.block);
+    BENCHMARK ("isEqualTo " + std::to_string (numChannels) + "ch " + std::to_string (numSamples))
+    {
+        return isEqualTo<TestType> (expected.block).match (input.block);
+    };
+}
+
+TEMPLATE_TEST_CASE ("magnitudeOfFrequency", "[benchmarks][magnitudeOfFrequency]", float, double)
+{
+    benchmarkSizes<TestType> ("magnitudeOfFrequency", [] (auto& block) { return magnitudeOfFrequency (block, 440.f, sampleRate); });
+}
+
+TEMPLATE_TEST_CASE ("FFT constructor", "[benchmarks][FFT]", float, double)
+{
+    benchmarkSizes<TestType> ("FFT", [] (auto& block) { return FFT<TestType> (block, sampleRate).getNumBins(); });
+}
+
+TEMPLATE_TEST_CASE ("reverse", "[benchmarks][reverse]", float, double)
+{
+    benchmarkSizesOnCopies<TestType> ("reverse", [] (auto& block) { return reverse (block).getNumSamples(); });
+}
+
+TEMPLATE_TEST_CASE ("normalized", "[benchmarks][normalized]", float, double)
+{
+    benchmarkSizesOnCopies<TestType> ("normalized", [] (auto& block) { return normalized (block).getNumSamples(); });
+}
@@ -2,39 +2,134 @@
 
 namespace melatonin
 {
-    template<typename SampleType>
-    class FFT
+    using WindowingMethod = juce::dsp::WindowingFunction<float>::WindowingMethod;
+
+    // FFT engines and window tables are expensive to build, so they are made once and reused.
+    // Window tables never change once built and are shared between threads.
+    // Engines are made once per order *per thread*: JUCE's fallback engine locks around its scratch
+    // space inside perform, so threads sharing one would take turns. Only use an engine on the thread
+    // that asked for it (call getEngine inside parallelFor jobs, not before).
+    class FFTPlanCache
     {
     public:
-        FFT (AudioBlock<SampleType>& b, float rate, bool scale = true, bool debug = false) : block (b), sampleRate (rate)
+        static FFTPlanCache& getInstance()
         {
-            // fill up all 1024 samples
-            for (size_t i = 0; i < fftSize; i++)
-                fftData[i] = block.getSample (0, (int) (i % block.getNumSamples()));
+            static FFTPlanCache cache;
+            return cache;
+        }
 
-            // Hann is best for sinusoids
-            window.multiplyWithWindowingTable (fftData.getData(), fftSize);
-            fft.performFrequencyOnlyForwardTransform (fftData.getData());
+        std::shared_ptr<const juce::dsp::FFT> getEngine (int order)
+        {
+            thread_local std::map<int, std::shared_ptr<const juce::dsp::FFT>> engines;
+            auto& engine = engines[order];
+            if (engine == nullptr)
+                engine = std::make_shared<juce::dsp::FFT> (order);
+            return engine;
+        }
 
-            SampleType maxValue = 0.0;
+        std::shared_ptr<const std::vector<float>> getWindow (int order, WindowingMethod method, bool normalise = true)
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            auto& table = windows[std::make_tuple (order, (int) method, normalise)];
+            if (table == nullptr)
+            {
+                auto newTable = std::make_shared<std::vector<float>> ((size_t) 1 << order);
+                juce::dsp::WindowingFunction<float>::fillWindowingTables (newTable->data(), newTable->size(), method, normalise);
+                table = newTable;
+            }
+            return table;
+        }
 
-            // Normalize from fftSize magnitudes down to a 0-1 magnitude range
-            for (size_t i = 0; i < fftSize; i++)
+        // For windows JUCE doesn't have, built by fill (data, size) the first time they're asked for
+        template <typename FillFunction>
+        std::shared_ptr<const std::vector<float>> getWindow (int order, const std::string& name, FillFunction&& fill)
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            auto& table = customWindows[std::make_pair (order, name)];
+            if (table == nullptr)
             {
-                fftData[i] = fftData[i] / fftSize;
-                maxValue = fftData[i] > maxValue ? fftData[i] : maxValue;
-                if (debug)
-                    DBG (fftData[i]);
+                auto newTable = std::make_shared<std::vector<float>> ((size_t) 1 << order);
+                fill (newTable->data(), newTable->size());
+                table = newTable;
             }
+            return table;
+        }
 
-            // Different tests use different amplitudes...
-            if (scale)
+    private:
+        std::mutex mutex;
+        std::map<std::tuple<int, int, bool>, std::shared_ptr<const std::vector<float>>> windows;
+        std::map<std::pair<int, std::string>, std::shared_ptr<const std::vector<float>>> customWindows;
+    };
+
+    // A periodic cosine-sum window (the family Hann and Blackman-Harris belong to), for use with an FFT of the same size
+    static inline void fillCosineSumWindow (float* data, size_t size, std::initializer_list<double> coefficients)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            double value = 0, sign = 1;
+            size_t term = 0;
+            for (auto coefficient : coefficients)
             {
-                for (size_t i = 0; i < fftSize; i++)
-                {
-                    fftData[i] = fftData[i] * (SampleType) 0.5 / maxValue; // 0.5 is our arbitrary max value for a bin
-                }
+                value += sign * coefficient * std::cos (juce::MathConstants<double>::twoPi * (double) (term++ * i) / (double) size);
+                sign = -sign;
             }
+            data[i] = (float) value;
+        }
+    }
+
+    // 7 term Blackman-Harris. Its sidelobes are below -180dB on paper, but float coefficients and a float FFT
+    // put the real floor around -140dB. Tones spread 7 bins either side.
+    static inline std::shared_ptr<const std::vector<float>> getBlackmanHarris7Window (int order)
+    {
+        return FFTPlanCache::getInstance().getWindow (order, "blackmanHarris7", [] (float* data, size_t size) {
+            fillCosineSumWindow (data, size, { 0.27105140069342, 0.43329793923448, 0.21812299954311, 0.06592544638803, 0.01081174209837, 0.00077658482522, 0.00001388721735 });
+        });
+    }
+
+    // Copies the start of a channel into an fft buffer, zero-padding when the channel is short
+    template <typename SampleType>
+    static inline void copyForFFT (float* destination, const SampleType* source, size_t numSourceSamples, size_t fftSize)
+    {
+        const auto numToCopy = juce::jmin (numSourceSamples, fftSize);
+        if constexpr (std::is_same_v<SampleType, float>)
+            juce::FloatVectorOperations::copy (destination, source, (int) numToCopy);
+        else
+            for (size_t i = 0; i < numToCopy; ++i)
+                destination[i] = (float) source[i];
+
+        juce::FloatVectorOperations::clear (destination + numToCopy, (int) (fftSize - numToCopy));
+    }
+
+    template <typename SampleType>
+    class FFT
+    {
+    public:
+        // order 11 is a size of 2048
+        FFT (AudioBlock<SampleType>& b, float rate, bool scale = true, bool debug = false, int order = 11, WindowingMethod windowingMethod = WindowingMethod::hann)
+            : block (b),
+              sampleRate (rate),
+              fftSize ((size_t) 1 << order),
+              numberOfBins (fftSize / 2),
+              fft (FFTPlanCache::getInstance().getEngine (order))
+        {
+            copyForFFT (fftData.getData(), block.getChannelPointer (0), block.getNumSamples(), fftSize);
+
+            // Hann is best for sinusoids
+            auto window = FFTPlanCache::getInstance().getWindow (order, windowingMethod);
+            juce::FloatVectorOperations::multiply (fftData.getData(), window->data(), (int) fftSize);
+            fft->performFrequencyOnlyForwardTransform (fftData.getData());
+
+            // Normalize from fftSize magnitudes down to a 0-1 magnitude range
+            juce::FloatVectorOperations::multiply (fftData.getData(), 1.0f / (float) fftSize, (int) fftSize);
+            auto maxValue = juce::FloatVectorOperations::findMaximum (fftData.getData(), (int) fftSize);
+
+            if (debug)
+                for (size_t i = 0; i < fftSize; i++)
+                    DBG (fftData[i]);
+
+            // Different tests use different amplitudes...
+            if (scale && maxValue > 0)
+                juce::FloatVectorOperations::multiply (fftData.getData(), 0.5f / maxValue, (int) fftSize); // 0.5 is our arbitrary max value for a bin
         }
 
         // VORSICHT!: This will only return the strongest *single* bin
@@ -121,13 +216,16 @@ namespace melatonin
             }
         }
 
+        [[nodiscard]] size_t getSize() const { return fftSize; }
+        [[nodiscard]] size_t getNumBins() const { return numberOfBins; }
+        [[nodiscard]] float getMagnitude (size_t bin) const { return fftData[bin]; }
+
     private:
         AudioBlock<SampleType>& block;
         float sampleRate;
-        const size_t fftSize = 2048;
-        const size_t numberOfBins = fftSize / 2;
+        size_t fftSize;
+        size_t numberOfBins;
+        std::shared_ptr<const juce::dsp::FFT> fft;
         juce::HeapBlock<float> fftData { fftSize * 2, true }; // Even though we aren't calculating negative freqs, still needs to be 2x the size
-        juce::dsp::WindowingFunction<float> window { fftSize, juce::dsp::WindowingFunction<float>::WindowingMethod::hann };
-        juce::dsp::FFT fft { 11 }; // 2^10 (10th order) is the same as a size of 1024
     };
 }
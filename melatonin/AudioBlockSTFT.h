@@ -0,0 +1,140 @@
+#pragma once
+
+namespace melatonin
+{
+    // Short-time FFT of every channel of a block, for checking how the spectrum changes over time.
+    //
+    // Magnitudes are stored contiguously as [channel][frame][bin] and are in linear amplitude,
+    // so a full scale sine centered in a bin reads as ~1.0 (the FFT class instead scales each frame to 0.5).
+    // Frames are analyzed in parallel on the analysis thread pool.
+    template <typename SampleType>
+    class STFT
+    {
+    public:
+        // A hop size of 0 means a quarter of the FFT size (75% overlap)
+        STFT (const AudioBlock<SampleType>& block, float rate, int order = 11, size_t hop = 0, WindowingMethod windowingMethod = WindowingMethod::hann)
+            : sampleRate (rate),
+              fftSize ((size_t) 1 << order),
+              numberOfBins (fftSize / 2),
+              hopSize (hop > 0 ? hop : fftSize / 4),
+              numChannels (block.getNumChannels()),
+              numFrames (numberOfFramesFor (block.getNumSamples())),
+              magnitudes (numChannels * numFrames * numberOfBins)
+        {
+            auto window = FFTPlanCache::getInstance().getWindow (order, windowingMethod);
+            const auto normalisation = 2.0f / (float) fftSize;
+
+            parallelFor (numChannels * numFrames, [&] (size_t begin, size_t end) {
+                auto engine = FFTPlanCache::getInstance().getEngine (order);
+                juce::HeapBlock<float> scratch (fftSize * 2, true);
+                for (size_t job = begin; job < end; ++job)
+                {
+                    const auto channel = job / numFrames;
+                    const auto frame = job % numFrames;
+                    const auto start = frame * hopSize;
+                    const auto available = start < block.getNumSamples() ? block.getNumSamples() - start : 0;
+
+                    copyForFFT (scratch.getData(), block.getChannelPointer (channel) + start, available, fftSize);
+                    juce::FloatVectorOperations::multiply (scratch.getData(), window->data(), (int) fftSize);
+                    engine->performFrequencyOnlyForwardTransform (scratch.getData());
+                    juce::FloatVectorOperations::copyWithMultiply (frameData (channel, frame), scratch.getData(), normalisation, (int) numberOfBins);
+                }
+            });
+        }
+
+        [[nodiscard]] size_t getNumChannels() const { return numChannels; }
+        [[nodiscard]] size_t getNumFrames() const { return numFrames; }
+        [[nodiscard]] size_t getNumBins() const { return numberOfBins; }
+        [[nodiscard]] size_t getFFTSize() const { return fftSize; }
+        [[nodiscard]] size_t getHopSize() const { return hopSize; }
+
+        // numberOfBins magnitudes for one frame of one channel
+        [[nodiscard]] const float* getFrame (size_t channel, size_t frame) const { return magnitudes.data() + (channel * numFrames + frame) * numberOfBins; }
+        [[nodiscard]] float getMagnitude (size_t channel, size_t frame, size_t bin) const { return getFrame (channel, frame)[bin]; }
+
+        // time in seconds at the center of a frame
+        [[nodiscard]] double timeOfFrame (size_t frame) const { return ((double) (frame * hopSize) + (double) fftSize * 0.5) / sampleRate; }
+
+        [[nodiscard]] size_t frequencyBinFor (float frequency) const
+        {
+            // add 0.5 so that the implicit truncation behaves as rounding
+            return (size_t) ((frequency / sampleRate * (float) fftSize) + 0.5f);
+        }
+
+        [[nodiscard]] float frequencyForBin (size_t bin) const { return (float) bin * sampleRate / (float) fftSize; }
+
+        [[nodiscard]] size_t strongestFrequencyBin (size_t channel, size_t frame) const
+        {
+            auto data = getFrame (channel, frame);
+            return (size_t) (std::max_element (data, data + numberOfBins) - data);
+        }
+
+        [[nodiscard]] bool strongestFrequencyIs (size_t channel, size_t frame, float frequency, size_t binTolerance = 0) const
+        {
+            auto strongest = strongestFrequencyBin (channel, frame);
+            auto expected = frequencyBinFor (frequency);
+            return (strongest > expected ? strongest - expected : expected - strongest) <= binTolerance;
+        }
+
+        // bins above 10% of the frame's strongest bin (the same ratio the FFT class uses)
+        [[nodiscard]] std::vector<size_t> strongFrequencyBins (size_t channel, size_t frame) const
+        {
+            auto data = getFrame (channel, frame);
+            auto threshold = 0.1f * data[strongestFrequencyBin (channel, frame)];
+            std::vector<size_t> bins;
+            for (size_t i = 0; i < numberOfBins; ++i)
+                if (data[i] > threshold && data[i] > 0)
+                    bins.push_back (i);
+            return bins;
+        }
+
+        // under 4% of the frame's strongest bin, or silent
+        [[nodiscard]] bool frequencyNotPresent (size_t channel, size_t frame, float frequency) const
+        {
+            auto data = getFrame (channel, frame);
+            return data[frequencyBinFor (frequency)] <= 0.04f * data[strongestFrequencyBin (channel, frame)];
+        }
+
+        // The strongest frequency of every frame, handy for following sweeps and glides
+        [[nodiscard]] std::vector<float> strongestFrequencies (size_t channel) const
+        {
+            std::vector<float> frequencies;
+            frequencies.reserve (numFrames);
+            for (size_t frame = 0; frame < numFrames; ++frame)
+                frequencies.push_back (frequencyForBin (strongestFrequencyBin (channel, frame)));
+            return frequencies;
+        }
+
+        // Lets you assert things like "the strongest frequency moves from 100Hz to 10kHz in under 2 seconds":
+        //
+        //   auto start = stft.firstFrameWhereStrongestFrequencyIs (0, 100.f, 1);
+        //   auto end = stft.firstFrameWhereStrongestFrequencyIs (0, 10000.f, 1, *start);
+        //   REQUIRE (stft.timeOfFrame (*end) - stft.timeOfFrame (*start) < 2.0);
+        [[nodiscard]] std::optional<size_t> firstFrameWhereStrongestFrequencyIs (size_t channel, float frequency, size_t binTolerance = 0, size_t fromFrame = 0) const
+        {
+            for (size_t frame = fromFrame; frame < numFrames; ++frame)
+                if (strongestFrequencyIs (channel, frame, frequency, binTolerance))
+                    return frame;
+            return std::nullopt;
+        }
+
+    private:
+        float sampleRate;
+        size_t fftSize;
+        size_t numberOfBins;
+        size_t hopSize;
+        size_t numChannels;
+        size_t numFrames;
+        std::vector<float> magnitudes;
+
+        // The last frame is zero-padded, so every sample lands in at least one frame
+        [[nodiscard]] size_t numberOfFramesFor (size_t numSamples) const
+        {
+            if (numSamples <= fftSize)
+                return 1;
+            return 1 + (numSamples - fftSize + hopSize - 1) / hopSize;
+        }
+
+        float* frameData (size_t channel, size_t frame) { return magnitudes.data() + (channel * numFrames + frame) * numberOfBins; }
+    };
+}
@@ -3,6 +3,7 @@
 
 // This teaches Catch how to convert an AudioBlock to a string
 // This allows us to print out detail about the AudioBlock on matcher failure
+// (short blocks get a sparkline, long ones a bounded summary, see describeBlock)
 namespace Catch
 {
     template <>
@@ -10,7 +11,7 @@ namespace Catch
     {
         static std::string convert (juce::dsp::AudioBlock<float> const& value)
         {
-            return melatonin::sparkline (value).toStdString();
+            return melatonin::describeBlock (value);
         }
     };
 
@@ -19,25 +20,25 @@ namespace Catch
     {
         static std::string convert (juce::dsp::AudioBlock<double> const& value)
         {
-            return melatonin::sparkline (value).toStdString();
+            return melatonin::describeBlock (value);
         }
     };
 
     template <>
     struct StringMaker<juce::AudioBuffer<float>>
     {
-        static std::string convert (juce::AudioBuffer<float> value)
+        static std::string convert (juce::AudioBuffer<float> const& value)
         {
-            return melatonin::sparkline (value).toStdString();
+            return melatonin::describeBlock (value);
         }
     };
 
     template <>
     struct StringMaker<juce::AudioBuffer<double>>
     {
-        static std::string convert (juce::AudioBuffer<double>& value)
+        static std::string convert (juce::AudioBuffer<double> const& value)
         {
-            return melatonin::sparkline (value).toStdString();
+            return melatonin::describeBlock (value);
         }
     };
 
@@ -48,85 +49,194 @@ namespace melatonin
 
     struct isValidAudio : Catch::Matchers::MatcherGenericBase
     {
+        mutable std::string problem = "";
+
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return validAudio (block);
+            auto firstInvalid = findFirstInvalidSample (block);
+            if (!firstInvalid.has_value())
+                return true;
+
+            auto counts = classifySamples (block);
+            std::ostringstream ss;
+            ss << "First invalid sample is " << sampleClassName (firstInvalid->sampleClass) << " (" << firstInvalid->value << ")"
+               << " on channel " << firstInvalid->channel << " at sample " << firstInvalid->sample << "\n"
+               << "Found " << counts.nan << " NaNs, " << counts.infinite << " INFs, " << counts.subnormal << " subnormals, "
+               << counts.zero << " zeros and " << counts.normal << " normal samples\n";
+            problem = ss.str();
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            if (stream.isValid())
+                return true;
+
+            auto& counts = stream.getClassCounts();
+            auto& firstInvalid = stream.getFirstInvalidSample();
+            std::ostringstream ss;
+            if (firstInvalid.has_value())
+                ss << "First invalid sample is " << sampleClassName (firstInvalid->sampleClass) << " (" << firstInvalid->value << ")"
+                   << " on channel " << firstInvalid->channel << " at sample " << firstInvalid->sample << "\n";
+            ss << "Found " << counts.nan << " NaNs, " << counts.infinite << " INFs and " << counts.subnormal << " subnormals\n";
+            problem = ss.str();
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
         {
-            return validAudio (buffer);
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockStats<SampleType>& stats) const
+        {
+            if (validAudio (stats))
+                return true;
+
+            std::ostringstream ss;
+            ss << "Found " << stats.numNaNs() << " NaNs, " << stats.numInfs() << " INFs and " << stats.numSubnormals() << " subnormals\n";
+            problem = ss.str();
+            return false;
         }
 
         [[nodiscard]] std::string describe() const override
         {
-            return "Block is free of NaNs, INFs and subnormals\n";
+            return "Block is free of NaNs, INFs and subnormals\n" + problem;
         }
     };
 
+    static inline std::string describeGap (const std::optional<ZeroRun>& gap)
+    {
+        if (!gap.has_value())
+            return "";
+        std::ostringstream ss;
+        ss << "\nFound " << gap->length << " consecutive zeros on channel " << gap->channel << " starting at sample " << gap->start;
+        return ss.str();
+    }
+
+    static inline std::string describeNonZero (const std::optional<NonZeroSample>& nonZero)
+    {
+        if (!nonZero.has_value())
+            return "";
+        std::ostringstream ss;
+        ss << "\nFound a non-zero sample on channel " << nonZero->channel << " at sample " << nonZero->sample;
+        return ss.str();
+    }
+
     struct isFilled : Catch::Matchers::MatcherGenericBase
     {
+        mutable std::string problem = "";
+
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsFilled (block);
+            if (blockIsFilled (block))
+                return true;
+            problem = describeGap (firstGap (block));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsFilled (block);
+            return match (AudioBlock<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            auto gap = stream.getFirstGap();
+            problem = describeGap (gap);
+            return !gap.has_value();
         }
 
         [[nodiscard]] std::string describe() const override
         {
-            return "Block is completely filled";
+            return "Block is completely filled" + problem;
         }
     };
 
     struct isEmpty : Catch::Matchers::MatcherGenericBase
     {
+        mutable std::string problem = "";
+
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsEmpty (block);
+            if (blockIsEmpty (block))
+                return true;
+            problem = describeNonZero (findFirstNonZeroSample (block));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsEmpty (block);
+            return match (AudioBlock<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockIndex<SampleType>& index) const
+        {
+            if (index.isSilent())
+                return true;
+            problem = describeNonZero (index.firstNonZeroSample());
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockStats<SampleType>& stats) const
+        {
+            if (blockIsEmpty (stats))
+                return true;
+            std::ostringstream ss;
+            ss << "\nFound " << stats.getNumSamples() * stats.getNumChannels() - stats.numZeros() << " non-zero samples";
+            problem = ss.str();
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            problem = describeNonZero (stream.getFirstNonZeroSample());
+            return !stream.getFirstNonZeroSample().has_value();
         }
 
         [[nodiscard]] std::string describe() const override
         {
-            return "Block is completely empty";
+            return "Block is completely empty" + problem;
         }
     };
 
     struct isFilledUntil : Catch::Matchers::MatcherGenericBase
     {
         size_t boundary = 0;
+        mutable std::string problem = "";
         explicit isFilledUntil (size_t sampleNum) : boundary (sampleNum) {}
 
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsFilledUntil (block, (int) boundary);
+            if (blockIsFilledUntil (block, (int) boundary))
+                return true;
+            problem = describeGap (firstGap (block, 0, boundary, std::numeric_limits<SampleType>::min()));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsFilledUntil (block, (int) boundary);
+            return match (AudioBlock<SampleType> (block));
         }
 
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
-            ss << "Block is filled to sample " << boundary;
+            ss << "Block is filled to sample " << boundary << problem;
             return ss.str();
         }
     };
@@ -134,24 +244,28 @@ namespace melatonin
     struct isFilledAfter : Catch::Matchers::MatcherGenericBase
     {
         size_t boundary;
+        mutable std::string problem = "";
         explicit isFilledAfter (size_t sampleNum) : boundary (sampleNum) {}
 
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsFilledAfter (block, (int) boundary);
+            if (blockIsFilledAfter (block, (int) boundary))
+                return true;
+            problem = block.getNumSamples() == boundary ? "\nThe block ends at this sample" : describeGap (firstGap (block, boundary));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsFilledAfter (block, (int) boundary);
+            return match (AudioBlock<SampleType> (block));
         }
 
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
-            ss << "Block is filled after sample " << boundary;
+            ss << "Block is filled after sample " << boundary << problem;
             return ss.str();
         }
     };
@@ -160,24 +274,36 @@ namespace melatonin
     {
         size_t start;
         size_t end;
+        mutable std::string problem = "";
         isFilledBetween (size_t s, size_t e) : start (s), end (e) {}
 
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsFilledBetween (block, start, end);
+            if (blockIsFilledBetween (block, (int) start, (int) end))
+                return true;
+            problem = describeGap (firstGap (block, start, end));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsFilledBetween (block, start, end);
+            return match (AudioBlock<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockIndex<SampleType>& index) const
+        {
+            auto gap = index.firstGap (start, end);
+            problem = describeGap (gap);
+            return !gap.has_value();
         }
 
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
-            ss << "Block is filled between samples " << start << " and " << end;
+            ss << "Block is filled between samples " << start << " and " << end << problem;
             return ss.str();
         }
     };
@@ -185,25 +311,48 @@ namespace melatonin
     struct isEmptyAfter : Catch::Matchers::MatcherGenericBase
     {
         size_t boundary = 0;
+        mutable std::string problem = "";
 
         explicit isEmptyAfter (size_t sampleNum) : boundary (sampleNum) {}
 
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsEmptyAfter (block, boundary);
+            if (blockIsEmptyAfter (block, boundary))
+                return true;
+            problem = describeNonZero (findFirstNonZeroSample (block, boundary));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsEmptyAfter (block, boundary);
+            return match (AudioBlock<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockIndex<SampleType>& index) const
+        {
+            if (blockIsEmptyAfter (index, boundary))
+                return true;
+            problem = describeNonZero (index.firstNonZeroSample (boundary));
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            auto last = stream.getLastNonZeroSample();
+            if (!last.has_value() || last->sample < boundary)
+                return true;
+            problem = "\nThe last non-zero sample was on channel " + std::to_string (last->channel) + " at sample " + std::to_string (last->sample);
+            return false;
         }
 
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
-            ss << "Block is empty after sample " << boundary;
+            ss << "Block is empty after sample " << boundary << problem;
             return ss.str();
         }
     };
@@ -211,24 +360,47 @@ namespace melatonin
     struct isEmptyUntil : Catch::Matchers::MatcherGenericBase
     {
         size_t boundary = 0;
+        mutable std::string problem = "";
         explicit isEmptyUntil (size_t sampleNum) : boundary (sampleNum) {}
 
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return blockIsEmptyUntil (block, boundary);
+            if (blockIsEmptyUntil (block, boundary))
+                return true;
+            problem = describeNonZero (findFirstNonZeroSample (block, 0, boundary));
+            return false;
         }
 
         template <typename SampleType>
         [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& block) const
         {
-            return bufferIsEmptyUntil (block, boundary);
+            return match (AudioBlock<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockIndex<SampleType>& index) const
+        {
+            if (blockIsEmptyUntil (index, boundary))
+                return true;
+            problem = describeNonZero (index.firstNonZeroSample (0, boundary));
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            auto first = stream.getFirstNonZeroSample();
+            if (!first.has_value() || first->sample >= boundary)
+                return true;
+            problem = describeNonZero (first);
+            return false;
         }
 
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
-            ss << "Block is empty until sample " << boundary;
+            ss << "Block is empty until sample " << boundary << problem;
             return ss.str();
         }
     };
@@ -243,7 +415,26 @@ namespace melatonin
         template <typename SampleType>
         [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            actualRMS = rms (block);
+            return match (BlockStats<SampleType> (block));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (BlockStats<SampleType> (buffer));
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockStats<SampleType>& stats) const
+        {
+            actualRMS = stats.rms();
+            return std::abs (actualRMS - expectedRMS) < tolerance;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            actualRMS = stream.rms();
             return std::abs (actualRMS - expectedRMS) < tolerance;
         }
 
@@ -255,98 +446,268 @@ namespace melatonin
         }
     };
 
-    // supports audioblock and std::vector
+    // Checks a set of frequencies in one pass, either for presence or for an expected magnitude:
+    //
+    //   REQUIRE_THAT (block, hasFrequencies ({ 440.f, 880.f }, 48000.f));
+    //   REQUIRE_THAT (block, hasFrequencies ({ 440.f, 880.f }, { 1.0f, 0.5f }, 48000.f, 0.01f));
+    struct hasFrequencies : Catch::Matchers::MatcherGenericBase
+    {
+        std::vector<float> frequencies;
+        std::vector<float> expectedMagnitudes;
+        float sampleRate;
+        float tolerance = 0;
+        float minimumMagnitude = 0;
+        mutable std::vector<float> actualMagnitudes = {};
+
+        // each frequency must have at least this magnitude
+        hasFrequencies (std::vector<float> f, float rate, float minimum = 0.1f)
+            : frequencies (std::move (f)), sampleRate (rate), minimumMagnitude (minimum) {}
+
+        // each frequency must be within tolerance of its magnitude
+        hasFrequencies (std::vector<float> f, std::vector<float> magnitudes, float rate, float t = 0.01f)
+            : frequencies (std::move (f)), expectedMagnitudes (std::move (magnitudes)), sampleRate (rate), tolerance (t)
+        {
+            jassert (frequencies.size() == expectedMagnitudes.size());
+        }
+
+        // without this, a single braced magnitude like { 0.5f } would bind to the rate above
+        hasFrequencies (std::vector<float> f, std::initializer_list<float> magnitudes, float rate, float t = 0.01f)
+            : hasFrequencies (std::move (f), std::vector<float> (magnitudes), rate, t) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            actualMagnitudes = magnitudesOfFrequencies (block, frequencies, sampleRate);
+            for (size_t i = 0; i < frequencies.size(); ++i)
+                if (!frequencyMatches (i))
+                    return false;
+            return true;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        // the stream must have been told to track these frequencies (in the same order)
+        template <typename SampleType>
+        [[nodiscard]] bool match (const StreamingStats<SampleType>& stream) const
+        {
+            jassert (stream.getFrequencies() == frequencies);
+            actualMagnitudes = stream.magnitudesOfFrequencies();
+            for (size_t i = 0; i < frequencies.size(); ++i)
+                if (!frequencyMatches (i))
+                    return false;
+            return true;
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "Block has frequencies:";
+            for (size_t i = 0; i < frequencies.size(); ++i)
+            {
+                ss << "\n  " << frequencies[i] << "Hz ";
+                if (expectedMagnitudes.empty())
+                    ss << "at least " << minimumMagnitude;
+                else
+                    ss << "within " << tolerance << " of " << expectedMagnitudes[i];
+                if (i < actualMagnitudes.size())
+                    ss << " (was " << actualMagnitudes[i] << (frequencyMatches (i) ? ")" : ") <--");
+            }
+            return ss.str();
+        }
+
+    private:
+        [[nodiscard]] bool frequencyMatches (size_t i) const
+        {
+            if (expectedMagnitudes.empty())
+                return actualMagnitudes[i] >= minimumMagnitude;
+            return std::abs (actualMagnitudes[i] - expectedMagnitudes[i]) <= tolerance;
+        }
+    };
+
+    // Compares every channel and sample against an expected block (or vector) within a tolerance.
+    // Absolute by default, or pass a Tolerance::relative or Tolerance::ulps
     template <typename SampleType>
     struct isEqualTo : Catch::Matchers::MatcherGenericBase
     {
-        juce::HeapBlock<char> expectedData;
-        AudioBlock<SampleType> expected = {};
+        // Where the first sample out of tolerance was, captured only when a match fails
+        struct Mismatch
+        {
+            size_t channel = 0;
+            size_t sample = 0;
+            double actual = 0; // doubles hold float and double samples exactly
+            double expected = 0;
+            size_t windowStart = 0;
+            std::vector<double> actualWindow;
+            std::vector<double> expectedWindow;
+            std::vector<size_t> outOfTolerancePerChannel;
+            size_t numOutOfTolerance = 0;
+            double worstDeviation = 0;
+            size_t worstChannel = 0;
+            size_t worstSample = 0;
+        };
+
+        AudioBlock<const SampleType> expected = {};
         std::vector<SampleType> expectedVector = {};
-        mutable std::vector<float> testedVector = {};
-        const float tolerance = 0;
-        mutable size_t sampleNumber = 0;
-        mutable double blockValue = 0;
-        mutable double expectedValue = 0;
+        Tolerance tolerance;
+        mutable std::optional<Mismatch> mismatch;
+        mutable std::string problem = "";
         mutable std::string descriptionOfOther = "";
 
-        explicit isEqualTo (const AudioBlock<SampleType>& e, float t = std::numeric_limits<float>::epsilon() * 100)
+        explicit isEqualTo (const AudioBlock<const SampleType>& e, Tolerance t)
             : expected (e), tolerance (t) {}
 
+        explicit isEqualTo (const AudioBlock<const SampleType>& e, float t = std::numeric_limits<float>::epsilon() * 100)
+            : isEqualTo (e, Tolerance::absolute (t)) {}
+
+        explicit isEqualTo (const AudioBlock<SampleType>& e, Tolerance t)
+            : isEqualTo (AudioBlock<const SampleType> (e), t) {}
+
+        explicit isEqualTo (const AudioBlock<SampleType>& e, float t = std::numeric_limits<float>::epsilon() * 100)
+            : isEqualTo (AudioBlock<const SampleType> (e), Tolerance::absolute (t)) {}
+
         // allow us to easily compare vector to vector
         // needed because Catch::Matchers::Approx<float> for std::vector is broken around 0.0
         // convenient for test writing
+        explicit isEqualTo (const std::vector<SampleType>& vector, Tolerance t)
+            : expectedVector (vector), tolerance (t) {}
+
         explicit isEqualTo (const std::vector<SampleType>& vector, float t = std::numeric_limits<float>::epsilon() * 100)
-            : expected(), expectedVector (vector), tolerance (t)
-        {
-            // also populate the expected block in case we want to compare incoming vector against blocks
-            expected = AudioBlock<SampleType> (expectedData, 1, expectedVector.size());
-            for (int i = 0; i < (int) expectedVector.size(); ++i)
-                expected.setSample (0, i, expectedVector[(size_t) i]);
-        }
+            : isEqualTo (vector, Tolerance::absolute (t)) {}
 
-        [[nodiscard]] bool match (AudioBlock<SampleType>& block) const
+        [[nodiscard]] bool match (const AudioBlock<const SampleType>& block) const
         {
-            jassert (expected.getNumSamples() == block.getNumSamples());
-            for (int channel = 0; channel < (int) block.getNumChannels(); ++channel)
+            // the expected vector can move along with the matcher, so only point at it here
+            const SampleType* vectorChannels[] = { expectedVector.data() };
+            const auto expectation = expectedVector.empty() ? expected : AudioBlock<const SampleType> (vectorChannels, 1, expectedVector.size());
+
+            mismatch.reset();
+            problem.clear();
+            if (block.getNumChannels() != expectation.getNumChannels() || block.getNumSamples() != expectation.getNumSamples())
             {
-                // TODO: clean this up!
-                for (int i = 0; i < (int) block.getNumSamples(); ++i)
-                {
-                    testedVector.push_back (block.getSample (channel, i));
-                }
-                for (int i = 0; i < (int) block.getNumSamples(); ++i)
+                std::ostringstream ss;
+                ss << "Expected " << expectation.getNumChannels() << " channels of " << expectation.getNumSamples()
+                   << " samples, got " << block.getNumChannels() << " channels of " << block.getNumSamples();
+                problem = ss.str();
+                return false;
+            }
+
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                const auto first = findFirstMismatch (block.getChannelPointer (c), expectation.getChannelPointer (c), block.getNumSamples(), tolerance);
+                if (first < block.getNumSamples())
                 {
-                    // juce::approximatelyEqual was not quite tolerant enough for my needs
-                    // if you are doing things like adding deltas 100 times vs. multiplying a delta by 1000, you'll need more
-                    if (!juce::isWithin (expected.getSample (channel, i), block.getSample (channel, i), tolerance))
-                    {
-                        sampleNumber = (size_t) i;
-                        blockValue = block.getSample (channel, i);
-                        expectedValue = expected.getSample (channel, i);
-                        return false;
-                    }
+                    describeMismatch (block, expectation, c, first);
+                    return false;
                 }
             }
             return true;
         }
 
-        [[nodiscard]] bool
-            match (juce::AudioBuffer<SampleType>& block) const
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
         {
-            return match (AudioBlock<SampleType> (block));
+            return match (AudioBlock<const SampleType> (block));
+        }
+
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<const SampleType> (AudioBlock<SampleType> (buffer)));
         }
 
         [[nodiscard]] bool match (const std::vector<SampleType>& vector) const
         {
-            // hi, you have to write your expectation for the exact number of elements!
-            if (vector.size() != expectedVector.size())
-                jassertfalse;
+            const SampleType* channels[] = { vector.data() };
+            return match (AudioBlock<const SampleType> (channels, 1, vector.size()));
+        }
 
-            testedVector = vector;
+        // Just the details of what went wrong, without drawing the expected block
+        [[nodiscard]] std::string describeMismatch() const
+        {
+            if (!mismatch.has_value())
+                return problem;
 
-            for (auto& value : vector)
-            {
-                if (!juce::isWithin (expectedVector[sampleNumber], value, tolerance))
-                {
-                    expectedValue = expectedVector[sampleNumber];
-                    return false;
-                }
-                sampleNumber++;
-            }
-            return true;
+            auto& m = *mismatch;
+            std::ostringstream ss;
+            ss << std::setprecision (std::numeric_limits<SampleType>::max_digits10);
+            ss << "Channel " << m.channel << " sample " << m.sample << " was " << m.actual
+               << ", expected " << m.expected << "\n";
+
+            ss << "Around sample " << m.windowStart << ":\n"
+               << "Expected: " << windowToString (m.expectedWindow) << "\n"
+               << "Actual:   " << windowToString (m.actualWindow) << "\n";
+
+            ss << m.numOutOfTolerance << " samples out of tolerance (";
+            for (size_t c = 0; c < m.outOfTolerancePerChannel.size(); ++c)
+                ss << (c > 0 ? ", " : "") << "channel " << c << ": " << m.outOfTolerancePerChannel[c];
+            ss << ")\n";
+
+            ss << "Worst deviation " << m.worstDeviation << (tolerance.mode == Tolerance::Mode::ulps ? " ULPs" : "")
+               << " at channel " << m.worstChannel << " sample " << m.worstSample;
+            return ss.str();
         }
 
         std::string describe() const override
         {
-            if (descriptionOfOther.empty())
-                descriptionOfOther = sparkline (expected).toStdString();
+            // bounded however long the expected block is (the samples around the mismatch are printed below)
+            if (descriptionOfOther.empty() && expectedVector.empty() && expected.getNumChannels() > 0)
+                descriptionOfOther = describeBlock (expected);
+
+            std::ostringstream ss;
+            ss << "is equal to (" << tolerance.describe() << ")\n";
+            if (!descriptionOfOther.empty())
+                ss << descriptionOfOther << "\n";
+            ss << describeMismatch();
+            return ss.str();
+        }
+
+    private:
+        static constexpr size_t windowRadius = 8;
 
-            auto expectedString = expectedVector.empty() ? blockToString(expected) : vectorToString (expectedVector);
+        static std::string windowToString (const std::vector<double>& window)
+        {
             std::ostringstream ss;
-            ss << "is equal to \n"
-               << descriptionOfOther << "\n";
-            ss << "Expected: " << expectedString << "\nActual:   " << melatonin::vectorToString (testedVector);
+            ss << std::setprecision (std::numeric_limits<SampleType>::max_digits10);
+            ss << "[";
+            for (size_t i = 0; i < window.size(); ++i)
+                ss << (i > 0 ? ", " : "") << window[i];
+            ss << "]";
             return ss.str();
         }
+
+        // Only runs on failure: copies a few samples either side of the first mismatch
+        // and then tallies how many samples were out of tolerance on each channel
+        void describeMismatch (const AudioBlock<const SampleType>& block, const AudioBlock<const SampleType>& expectation, size_t channel, size_t sample) const
+        {
+            Mismatch m;
+            m.channel = channel;
+            m.sample = sample;
+            m.actual = (double) block.getSample ((int) channel, (int) sample);
+            m.expected = (double) expectation.getSample ((int) channel, (int) sample);
+
+            m.windowStart = sample > windowRadius ? sample - windowRadius : 0;
+            const auto windowEnd = juce::jmin (block.getNumSamples(), sample + windowRadius + 1);
+            for (auto i = m.windowStart; i < windowEnd; ++i)
+            {
+                m.actualWindow.push_back ((double) block.getSample ((int) channel, (int) i));
+                m.expectedWindow.push_back ((double) expectation.getSample ((int) channel, (int) i));
+            }
+
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                auto summary = summarizeMismatches (block.getChannelPointer (c), expectation.getChannelPointer (c), block.getNumSamples(), tolerance);
+                m.outOfTolerancePerChannel.push_back (summary.numOutOfTolerance);
+                m.numOutOfTolerance += summary.numOutOfTolerance;
+                if (summary.numOutOfTolerance > 0 && (summary.worstDeviation > m.worstDeviation || m.numOutOfTolerance == summary.numOutOfTolerance))
+                {
+                    m.worstDeviation = summary.worstDeviation;
+                    m.worstChannel = c;
+                    m.worstSample = summary.worstSample;
+                }
+            }
+            mismatch = std::move (m);
+        }
     };
 }
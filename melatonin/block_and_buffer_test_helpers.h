@@ -7,18 +7,27 @@ namespace melatonin
 
     // Ensures there's no INF, NaN or subnormals in the block
     template <typename SampleType>
+    static inline bool validAudio (const BlockStats<SampleType>& stats)
+    {
+        return stats.isValid();
+    }
+
+    // stops at the first bad sample, use findFirstInvalidSample if you need to know where it is
+    template <typename SampleType>
     static inline bool validAudio (const AudioBlock<SampleType>& block)
     {
         for (size_t c = 0; c < block.getNumChannels(); ++c)
-            for (size_t i = 0; i < block.getNumSamples(); ++i)
-            {
-                auto value = std::fpclassify (block.getSample ((int) c, (int) i));
-                if (value == FP_SUBNORMAL || value == FP_INFINITE || value == FP_NAN)
-                    return false;
-            }
+            if (findFirstInvalidSample (block.getChannelPointer (c), block.getNumSamples()) < block.getNumSamples())
+                return false;
         return true;
     }
 
+    template <typename SampleType>
+    static inline bool validAudio (const StreamingStats<SampleType>& stream)
+    {
+        return stream.isValid();
+    }
+
     template <typename SampleType>
     static inline bool validAudio (juce::AudioBuffer<SampleType>& buffer)
     {
@@ -72,34 +81,42 @@ namespace melatonin
         return channelsAreIdentical (block);
     }
 
+    // peak absolute value on any channel
+    template <typename SampleType>
+    static inline SampleType maxMagnitude (const BlockStats<SampleType>& stats)
+    {
+        return stats.peak();
+    }
+
+    template <typename SampleType>
+    static inline SampleType maxMagnitude (const StreamingStats<SampleType>& stream)
+    {
+        return stream.peak();
+    }
+
+    // One-shot helpers use single-purpose kernels, make a BlockStats when asking several questions
     template <typename SampleType>
     static inline SampleType maxMagnitude (const AudioBlock<SampleType>& block)
     {
-        float max = 0.0;
+        SampleType max = 0;
         for (size_t c = 0; c < block.getNumChannels(); ++c)
         {
-            auto channel_max = juce::FloatVectorOperations::findMaximum (block.getChannelPointer (c), block.getNumSamples());
-            auto channel_abs_min = abs (juce::FloatVectorOperations::findMinimum (block.getChannelPointer (c), block.getNumSamples()));
-            if (channel_max > max)
-                max = channel_max;
-            else if (channel_abs_min > max)
-                max = channel_abs_min;
+            auto range = juce::FloatVectorOperations::findMinAndMax (block.getChannelPointer (c), (int) block.getNumSamples());
+            max = juce::jmax (max, std::abs (range.getStart()), std::abs (range.getEnd()));
         }
         return max;
     }
 
+    // smallest absolute value on any channel
     template <typename SampleType>
     static inline SampleType minMagnitude (const AudioBlock<SampleType>& block)
     {
-        float min = std::numeric_limits<float>::max(); // a very large number
+        auto min = std::numeric_limits<SampleType>::max();
         for (size_t c = 0; c < block.getNumChannels(); ++c)
         {
-            auto channel_min = juce::FloatVectorOperations::findMinimum (block.getChannelPointer (c), block.getNumSamples());
-            auto channel_abs_max = abs (juce::FloatVectorOperations::findMaximum (block.getChannelPointer (c), block.getNumSamples()));
-            if (channel_min < min)
-                min = channel_min;
-            else if (channel_abs_max < min)
-                min = channel_abs_max;
+            auto* data = block.getChannelPointer (c);
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                min = juce::jmin (min, std::abs (data[i]));
         }
         return min;
     }
@@ -111,25 +128,38 @@ namespace melatonin
         return maxMagnitude (block);
     }
 
+    // every sample's absolute value is between min and max
     template <typename SampleType>
-    static inline bool betweenMagnitudes(const AudioBlock<SampleType>& block, SampleType min, SampleType max)
+    static inline bool betweenMagnitudes (const AudioBlock<SampleType>& block, SampleType min, SampleType max)
     {
         return minMagnitude (block) >= min && maxMagnitude (block) <= max;
     }
 
+    template <typename SampleType>
+    static inline SampleType rms (const BlockStats<SampleType>& stats)
+    {
+        return static_cast<SampleType> (stats.rms());
+    }
+
+    template <typename SampleType>
+    static inline SampleType rms (const StreamingStats<SampleType>& stream)
+    {
+        return static_cast<SampleType> (stream.rms());
+    }
+
     template <typename SampleType>
     static inline SampleType rms (const AudioBlock<SampleType>& block)
     {
-        float sum = 0.0;
-        for (int c = 0; c < (int) block.getNumChannels(); ++c)
+        double sum = 0.0;
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
         {
-            for (int i = 0; i < (int) block.getNumSamples(); ++i)
-            {
-                sum += (float) block.getSample (c, i) * (float) block.getSample (c, i);
-            }
+            auto* data = block.getChannelPointer (c);
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                sum += (double) data[i] * (double) data[i];
         }
 
-        return static_cast<SampleType> (std::sqrt (sum / float (block.getNumSamples() * block.getNumChannels())));
+        const auto numSamples = block.getNumSamples() * block.getNumChannels();
+        return numSamples > 0 ? static_cast<SampleType> (std::sqrt (sum / (double) numSamples)) : SampleType (0);
     }
 
     template <typename SampleType>
@@ -139,6 +169,12 @@ namespace melatonin
         return rms (block);
     }
 
+    template <typename SampleType>
+    static inline SampleType rmsInDB (const BlockStats<SampleType>& stats)
+    {
+        return static_cast<SampleType> (juce::Decibels::gainToDecibels (rms (stats)));
+    }
+
     template <typename SampleType>
     static inline SampleType rmsInDB (const AudioBlock<SampleType>& block)
     {
@@ -163,81 +199,73 @@ namespace melatonin
         }
     }
 
-    template <typename SampleType>
-    static inline AudioBlock<SampleType>& fillBlockWithFunction (AudioBlock<SampleType>& block, const std::function<float (float)>& function, float frequency, float sampleRate, float gain = 1.0f, bool accumulate = false)
+    // function is called with an angle in radians between -pi and pi, starting at 0
+    // Use Oscillator directly if you need the phase to continue across blocks
+    template <typename SampleType, typename Function>
+    static inline AudioBlock<SampleType>& fillBlockWithFunction (AudioBlock<SampleType>& block, Function&& function, float frequency, float sampleRate, float gain = 1.0f, bool accumulate = false)
     {
-        auto angleDelta = juce::MathConstants<float>::twoPi * frequency / sampleRate;
-        for (int c = 0; c < (int) block.getNumChannels(); ++c)
-        {
-            auto currentAngle = 0.0f;
-            for (int i = 0; i < (int) block.getNumSamples(); ++i)
-            {
-                auto sampleValue = gain * function (currentAngle);
-                block.setSample (c, i, accumulate ? block.getSample (c, i) + sampleValue : sampleValue);
-                currentAngle += angleDelta;
-                if (currentAngle >= juce::MathConstants<float>::pi)
-                    currentAngle -= juce::MathConstants<float>::twoPi;
-            }
-        }
-        return block;
+        return Oscillator<SampleType> (frequency, sampleRate, gain).render (block, std::forward<Function> (function), accumulate);
     }
 
-    template <typename SampleType>
-    static inline juce::AudioBuffer<SampleType>& fillBufferWithFunction (juce::AudioBuffer<SampleType>& buffer, const std::function<float (float)>& function, float frequency, float sampleRate, float gain = 1.0f)
+    template <typename SampleType, typename Function>
+    static inline juce::AudioBuffer<SampleType>& fillBufferWithFunction (juce::AudioBuffer<SampleType>& buffer, Function&& function, float frequency, float sampleRate, float gain = 1.0f)
     {
-        const auto block = AudioBlock<SampleType> (buffer);
-        return fillBlockWithFunction (block, function, frequency, sampleRate, gain);
+        auto block = AudioBlock<SampleType> (buffer);
+        fillBlockWithFunction (block, std::forward<Function> (function), frequency, sampleRate, gain);
+        return buffer;
     }
 
-    // assumes mono for now
+    // every channel gets the same sine
+    // The signal is generated once and then served from the SignalCache
     template <typename SampleType>
     static inline AudioBlock<SampleType>& fillWithSine (AudioBlock<SampleType>& block, float frequency, float sampleRate, float gain = 1.0f)
     {
-        return fillBlockWithFunction (
-            block, [] (float angle) { return juce::dsp::FastMathApproximations::sin (angle); }, frequency, sampleRate, gain);
+        auto signal = SignalCache::getInstance().get<SampleType> (Waveform::sine, frequency, sampleRate, block.getNumSamples(), gain);
+        return copySignalToBlock (block, signal);
     }
 
     template <typename SampleType>
     static inline AudioBlock<SampleType>& addSineToBlock (AudioBlock<SampleType>& block, float frequency, float sampleRate, float gain = 1.0f)
     {
-        return fillBlockWithFunction (
-            block, [] (float angle) { return juce::dsp::FastMathApproximations::sin (angle); }, frequency, sampleRate, gain, true);
+        auto signal = SignalCache::getInstance().get<SampleType> (Waveform::sine, frequency, sampleRate, block.getNumSamples(), gain);
+        return copySignalToBlock (block, signal, true);
     }
 
     template <typename SampleType>
     static inline juce::AudioBuffer<SampleType>& fillBufferWithSine (juce::AudioBuffer<SampleType>& buffer, float frequency, float sampleRate, float gain = 1.0f)
     {
-        const auto block = AudioBlock<SampleType> (buffer);
-        return fillWithSine (block, frequency, sampleRate, gain);
+        auto block = AudioBlock<SampleType> (buffer);
+        fillWithSine (block, frequency, sampleRate, gain);
+        return buffer;
     }
 
-    // assumes mono for now
+    // every channel gets the same cosine
     template <typename SampleType>
     static inline AudioBlock<SampleType>& fillWithCosine (AudioBlock<SampleType>& block, float frequency, float sampleRate, float gain = 1.0f)
     {
-        return fillBlockWithFunction (
-            block, [] (float angle) { return juce::dsp::FastMathApproximations::cos (angle); }, frequency, sampleRate, gain);
+        auto signal = SignalCache::getInstance().get<SampleType> (Waveform::cosine, frequency, sampleRate, block.getNumSamples(), gain);
+        return copySignalToBlock (block, signal);
     }
 
     template <typename SampleType>
     static inline juce::AudioBuffer<SampleType>& fillBufferWithCosine (juce::AudioBuffer<SampleType>& buffer, float frequency, float sampleRate, float gain = 1.0f)
     {
-        const auto block = AudioBlock<SampleType> (buffer);
-        return fillWithCosine (block, frequency, sampleRate, gain);
+        auto block = AudioBlock<SampleType> (buffer);
+        fillWithCosine (block, frequency, sampleRate, gain);
+        return buffer;
     }
 
     // all zeros
+    template <typename SampleType>
+    static inline bool blockIsEmpty (const BlockStats<SampleType>& stats)
+    {
+        return stats.isEmpty();
+    }
+
     template <typename SampleType>
     static inline bool blockIsEmpty (const AudioBlock<SampleType>& block)
     {
-        for (size_t i = 0; i < block.getNumChannels(); ++i)
-        {
-            if (!juce::FloatVectorOperations::findMinAndMax (block.getChannelPointer (i), (int) block.getNumSamples()).isEmpty())
-            {
-                return false;
-            }
-        }
-        return true;
+        return !findFirstNonZeroSample (block).has_value();
     }
 
     template <typename SampleType>
@@ -251,15 +279,7 @@ namespace melatonin
     static inline bool blockIsEmptyUntil (const AudioBlock<SampleType>& block, size_t numSamples)
     {
         jassert (block.getNumSamples() >= numSamples);
-
-        for (size_t i = 0; i < block.getNumChannels(); ++i)
-        {
-            if (!juce::FloatVectorOperations::findMinAndMax (block.getChannelPointer (i), (int) numSamples).isEmpty())
-            {
-                return false;
-            }
-        }
-        return true;
+        return !findFirstNonZeroSample (block, 0, numSamples).has_value();
     }
 
     template <typename SampleType>
@@ -273,20 +293,7 @@ namespace melatonin
     static inline bool blockIsEmptyAfter (const AudioBlock<SampleType>& block, size_t firstZeroAt)
     {
         jassert (block.getNumSamples() >= firstZeroAt);
-
-        if (block.getNumSamples() == firstZeroAt)
-            return true;
-
-        auto numSamples = block.getNumSamples() - firstZeroAt;
-        auto subBlock = block.getSubBlock (firstZeroAt, numSamples);
-        for (size_t i = 0; i < subBlock.getNumChannels(); ++i)
-        {
-            if (!juce::FloatVectorOperations::findMinAndMax (subBlock.getChannelPointer (i), (int) numSamples).isEmpty())
-            {
-                return false;
-            }
-        }
-        return true;
+        return !findFirstNonZeroSample (block, firstZeroAt).has_value();
     }
 
     template <typename SampleType>
@@ -296,16 +303,28 @@ namespace melatonin
         return blockIsEmptyAfter (block, firstZeroAt);
     }
 
+    // "Filled" means there's never more than 1 zero in a row
+    // Returns the number of samples that belong to runs of 2 or more zeros
+    template <typename SampleType>
+    static inline size_t numberOfConsecutiveZeros (const AudioBlock<SampleType>& block)
+    {
+        size_t total = 0;
+        for (auto& run : findZeroRuns (block, 2))
+            total += run.length;
+        return total;
+    }
+
+    // the first place where a block stops being filled, if any
+    template <typename SampleType>
+    static inline std::optional<ZeroRun> firstGap (const AudioBlock<SampleType>& block, size_t start = 0, size_t end = std::numeric_limits<size_t>::max(), SampleType threshold = 0)
+    {
+        return findFirstZeroRun (block, 2, threshold, start, end);
+    }
+
     template <typename SampleType>
     static inline bool blockIsFilled (const AudioBlock<SampleType>& block)
     {
-        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
-        {
-            auto channelBlock = block.getSingleChannelBlock (ch);
-            if (numberOfConsecutiveZeros (channelBlock) > 0)
-                return false;
-        }
-        return true;
+        return !firstGap (block).has_value();
     }
 
     template <typename SampleType>
@@ -315,20 +334,12 @@ namespace melatonin
         return blockIsFilled (block);
     }
 
+    // Samples within std::numeric_limits<SampleType>::min() of zero count as zero here
     template <typename SampleType>
     static inline bool blockIsFilledUntil (const AudioBlock<SampleType>& block, int sampleNum)
     {
         jassert ((int) block.getNumSamples() >= sampleNum);
-
-        for (int c = 0; c < (int) block.getNumChannels(); ++c)
-        {
-            for (int i = 0; i < sampleNum; ++i)
-            {
-                if (i > 0 && (juce::approximatelyEqual (block.getSample (c, i), {}) && juce::approximatelyEqual (block.getSample (c, i - 1), {})))
-                    return false;
-            }
-        }
-        return true;
+        return !firstGap (block, 0, (size_t) sampleNum, std::numeric_limits<SampleType>::min()).has_value();
     }
 
     template <typename SampleType>
@@ -346,15 +357,7 @@ namespace melatonin
         if ((int) block.getNumSamples() == sampleNum)
             return false;
 
-        for (int c = 0; c < (int) block.getNumChannels(); ++c)
-        {
-            for (int i = sampleNum; i < (int) block.getNumSamples(); ++i)
-            {
-                if (i > sampleNum && ((block.getSample (c, i) == 0) && (block.getSample (c, i - 1) == 0)))
-                    return false;
-            }
-        }
-        return true;
+        return !firstGap (block, (size_t) sampleNum).has_value();
     }
 
     template <typename SampleType>
@@ -364,19 +367,13 @@ namespace melatonin
         return blockIsFilledAfter (block, sampleNum);
     }
 
+    // checks samples from start up to (but not including) end
     template <typename SampleType>
     static inline bool blockIsFilledBetween (const AudioBlock<SampleType>& block, int start, int end)
     {
         jassert (end > start);
-        for (int c = 0; c < (int) block.getNumChannels(); ++c)
-        {
-            for (int i = start; i < (end - start); ++i)
-            {
-                if (i > start && ((block.getSample (c, i) == 0) && (block.getSample (c, i - 1) == 0)))
-                    return false;
-            }
-        }
-        return true;
+        jassert ((int) block.getNumSamples() >= end);
+        return !firstGap (block, (size_t) start, (size_t) end).has_value();
     }
 
     template <typename SampleType>
@@ -386,44 +383,44 @@ namespace melatonin
         return blockIsFilledBetween (block, start, end);
     }
 
-    // MONO FOR NOW
-    // Manual frequency correlation using a known frequency
-    // https://github.com/juce-framework/JUCE/blob/master/modules/juce_dsp/frequency/juce_FFT_test.cpp#L59-L82
+    // Manual frequency correlation using a known frequency (Goertzel)
+    // Returns the strongest magnitude of this frequency found on any channel
     template <typename SampleType>
     static inline float magnitudeOfFrequency (const AudioBlock<SampleType>& block, float freq, float sampleRate)
     {
-        // happy to allocate memory here, this is a test, not real time audio
-        juce::HeapBlock<char> sineData;
-        juce::HeapBlock<char> cosineData;
-
-        const size_t length = block.getNumSamples();
-
-        // we can get more accurate results by assuming the block is full with the frequency
-        // and only taking an integer number of cycles out of the block
-        const int lastFullCycle = (int) length - ((int) length % (int) (sampleRate / freq));
-
-        auto sineBlock = juce::dsp::AudioBlock<SampleType> (sineData, block.getNumChannels(), length);
-        auto cosineBlock = juce::dsp::AudioBlock<SampleType> (cosineData, block.getNumChannels(), length);
-
-        fillWithSine (sineBlock, freq, sampleRate).multiplyBy (block);
-        fillWithCosine (cosineBlock, freq, sampleRate).multiplyBy (block);
+        float magnitude = 0;
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+            magnitude = juce::jmax (magnitude, goertzelMagnitude (block.getChannelPointer (c), block.getNumSamples(), freq, sampleRate));
+        return magnitude;
+    }
 
-        float sineSum = 0;
-        float cosineSum = 0;
+    template <typename SampleType>
+    static inline float magnitudeOfFrequency (juce::AudioBuffer<SampleType>& buffer, float freq, float sampleRate)
+    {
+        const auto block = AudioBlock<SampleType> (buffer);
+        return magnitudeOfFrequency (block, freq, sampleRate);
+    }
 
-        for (int i = 0; i < lastFullCycle; ++i)
+    // Like magnitudeOfFrequency, but checks all the frequencies in one pass over each channel
+    template <typename SampleType>
+    static inline std::vector<float> magnitudesOfFrequencies (const AudioBlock<SampleType>& block, const std::vector<float>& frequencies, float sampleRate)
+    {
+        std::vector<float> magnitudes (frequencies.size(), 0.0f);
+        std::vector<float> channelMagnitudes (frequencies.size());
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
         {
-            sineSum += sineBlock.getSample (0, i);
-            cosineSum += cosineBlock.getSample (0, i);
+            goertzelMagnitudes (block.getChannelPointer (c), block.getNumSamples(), frequencies, sampleRate, channelMagnitudes.data());
+            for (size_t i = 0; i < frequencies.size(); ++i)
+                magnitudes[i] = juce::jmax (magnitudes[i], channelMagnitudes[i]);
         }
-        return std::sqrt ((float) juce::square (sineSum / (float) lastFullCycle) + juce::square (cosineSum / (float) lastFullCycle)) * 2.0f;
+        return magnitudes;
     }
 
     template <typename SampleType>
-    static inline float magnitudeOfFrequency (juce::AudioBuffer<SampleType>& buffer, float freq, float sampleRate)
+    static inline std::vector<float> magnitudesOfFrequencies (juce::AudioBuffer<SampleType>& buffer, const std::vector<float>& frequencies, float sampleRate)
     {
         const auto block = AudioBlock<SampleType> (buffer);
-        return magnitudeOfFrequency (block, freq, sampleRate);
+        return magnitudesOfFrequencies (block, frequencies, sampleRate);
     }
 
     template <typename SampleType>
@@ -471,59 +468,34 @@ namespace melatonin
         return reverse (block);
     }
 
+    // Every channel, binned over the block's range, with bars scaled to 60 characters
     template <typename SampleType>
-    void printHistogram (AudioBlock<SampleType>& block)
+    void printHistogram (AudioBlock<SampleType>& block, size_t numBins = 10)
     {
-        // Calculate the range of the samples
-        float rangeStart = juce::FloatVectorOperations::findMinimum (block.getChannelPointer (0), block.getNumSamples());
-        double rangeEnd = juce::FloatVectorOperations::findMaximum (block.getChannelPointer (0), block.getNumSamples());
+        const auto histogram = Histogram::of (block, numBins);
+        const auto largest = juce::jmax ((size_t) 1, histogram.largestCount());
 
-        // Calculate the histogram of the samples
-        const size_t numBins = 10; // Number of bins for histogram
-        std::vector<size_t> histogram (numBins, 0);
-        const double binSize = (rangeEnd - rangeStart) / numBins;
-
-        for (auto i = 0; i < block.getNumSamples(); ++i)
-        {
-            size_t binIndex = static_cast<size_t> ((block.getSample (0, i) - rangeStart) / binSize);
-            histogram[binIndex]++;
-        }
-
-        // Print the histogram
         for (size_t i = 0; i < numBins; ++i)
         {
-            std::cout << "[" << rangeStart + i * binSize << ", " << rangeStart + (i + 1) * binSize << "): ";
-            for (size_t j = 0; j < histogram[i]; ++j)
-                std::cout << "|";
-            std::cout << std::endl;
+            std::cout << "[" << histogram.binStart (i) << ", " << histogram.binEnd (i) << (i + 1 == numBins ? "]: " : "): ");
+            std::cout << std::string (histogram.count (i) * 60 / largest, '|') << " " << histogram.count (i) << std::endl;
         }
     }
 
+    // A rough check over the block's own range (every channel), each of 10 bins within 30% of the average.
+    // isDistributed (Uniform (low, high)) is the rigorous version.
     template <typename SampleType>
     bool isUniformlyDistributed (AudioBlock<SampleType>& block)
     {
         const double epsilon = 0.3; // lol, this is pretty accepting...
-
-        // Calculate the range of the samples
-        float rangeStart = juce::FloatVectorOperations::findMinimum (block.getChannelPointer (0), block.getNumSamples());
-        double rangeEnd = juce::FloatVectorOperations::findMaximum (block.getChannelPointer (0), block.getNumSamples());
-
-        // Calculate the histogram of the samples
-        const size_t numBins = 10; // Number of bins for histogram
-        std::vector<size_t> histogram (numBins, 0);
-        const double binSize = (rangeEnd - rangeStart) / numBins;
-
-        for (auto i = 0; i < block.getNumSamples(); ++i)
-        {
-            auto binIndex = juce::jlimit(size_t(0), numBins - 1, static_cast<size_t> ((block.getSample (0, i) - rangeStart) / binSize));
-            histogram[binIndex]++;
-        }
+        const size_t numBins = 10;
+        const auto histogram = Histogram::of (block, numBins);
 
         // Check if the histogram values are relatively equal
-        const double expectedCount = block.getNumSamples() / static_cast<double> (numBins);
-        for (const size_t& count : histogram)
+        const double expectedCount = (double) histogram.total() / static_cast<double> (numBins);
+        for (size_t i = 0; i < numBins; ++i)
         {
-            if (std::abs (count - expectedCount) > epsilon * expectedCount)
+            if (std::abs ((double) histogram.count (i) - expectedCount) > epsilon * expectedCount)
             {
                 return false;
             }
@@ -531,13 +503,11 @@ namespace melatonin
         return true;
     }
 
+    // MONO: the mean of the first channel
     template <typename SampleType>
     float average (AudioBlock<SampleType>& block)
     {
-        float sum = 0;
-        for (int i = 0; i < block.getNumSamples(); ++i)
-            sum += block.getSample (0, i);
-        return sum / (float) block.getNumSamples();
+        return (float) BlockStats<SampleType> (block.getSingleChannelBlock (0)).dcOffset();
     }
 
 }
@@ -0,0 +1,300 @@
+#pragma once
+
+namespace melatonin
+{
+    // Stats of two neighbouring stretches of one channel, as if they'd been calculated in one go
+    template <typename SampleType>
+    static inline ChannelStats<SampleType> combineChannelStats (const ChannelStats<SampleType>& a, const ChannelStats<SampleType>& b)
+    {
+        if (a.numSamples == 0)
+            return b;
+        if (b.numSamples == 0)
+            return a;
+
+        ChannelStats<SampleType> combined;
+        combined.numSamples = a.numSamples + b.numSamples;
+        combined.min = juce::jmin (a.min, b.min);
+        combined.max = juce::jmax (a.max, b.max);
+        combined.sum = a.sum + b.sum;
+        combined.sumOfSquares = a.sumOfSquares + b.sumOfSquares;
+        combined.numNaNs = a.numNaNs + b.numNaNs;
+        combined.numInfs = a.numInfs + b.numInfs;
+        combined.numSubnormals = a.numSubnormals + b.numSubnormals;
+        combined.numZeros = a.numZeros + b.numZeros;
+        return combined;
+    }
+
+    // A min/max/energy pyramid over a block, for asking many range questions about one long render.
+    // Building it is one pass over the samples; after that the peak, RMS, silence and bounds of any
+    // range come from O(log n) precomputed nodes plus at most two partial leaves.
+    //
+    //   auto index = BlockIndex<float> (render);
+    //   REQUIRE_THAT (index, isEmptyUntil (latency));
+    //   REQUIRE (index.peak (attackStart, attackEnd) > 0.9f);
+    //   REQUIRE (index.isSilent (releaseEnd, index.getNumSamples()));
+    //
+    // Like BlockStats it's a snapshot, and like an AudioBlock it doesn't own the samples:
+    // the block has to outlive the index, and a new index is needed if the block changes.
+    template <typename SampleType>
+    class BlockIndex
+    {
+    public:
+        // Samples per leaf. Partial leaves at either end of a range are scanned directly.
+        static constexpr size_t leafSize = 256;
+
+        explicit BlockIndex (const AudioBlock<const SampleType>& blockToIndex)
+            : block (blockToIndex),
+              numLeaves ((block.getNumSamples() + leafSize - 1) / leafSize)
+        {
+            // mip-map layout: every level of a channel's pyramid sits after the one below it
+            for (auto levelSize = numLeaves; levelSize > 0; levelSize = levelSize == 1 ? 0 : (levelSize + 1) / 2)
+            {
+                levelOffsets.push_back (nodesPerChannel);
+                levelSizes.push_back (levelSize);
+                nodesPerChannel += levelSize;
+            }
+            nodes.resize (nodesPerChannel * block.getNumChannels());
+
+            auto buildLeaves = [&] (size_t begin, size_t end) {
+                for (size_t job = begin; job < end; ++job)
+                {
+                    const auto channel = job / numLeaves;
+                    const auto start = (job % numLeaves) * leafSize;
+                    const auto length = juce::jmin (leafSize, block.getNumSamples() - start);
+                    nodes[channel * nodesPerChannel + job % numLeaves] = calculateChannelStats (block.getChannelPointer (channel) + start, length);
+                }
+            };
+            // 64 leaves is 16k samples, below that the threads cost more than they save
+            parallelFor (numLeaves * block.getNumChannels(), buildLeaves, 64);
+
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+                for (size_t level = 1; level < levelSizes.size(); ++level)
+                    for (size_t i = 0; i < levelSizes[level]; ++i)
+                    {
+                        auto& left = node (channel, level - 1, 2 * i);
+                        nodes[channel * nodesPerChannel + levelOffsets[level] + i] = 2 * i + 1 < levelSizes[level - 1]
+                                                                                         ? combineChannelStats (left, node (channel, level - 1, 2 * i + 1))
+                                                                                         : left;
+                    }
+        }
+
+        explicit BlockIndex (const AudioBlock<SampleType>& blockToIndex)
+            : BlockIndex (AudioBlock<const SampleType> (blockToIndex)) {}
+
+        explicit BlockIndex (const juce::AudioBuffer<SampleType>& buffer)
+            : BlockIndex (AudioBlock<const SampleType> (buffer.getArrayOfReadPointers(), (size_t) buffer.getNumChannels(), (size_t) buffer.getNumSamples())) {}
+
+        [[nodiscard]] size_t getNumChannels() const { return block.getNumChannels(); }
+        [[nodiscard]] size_t getNumSamples() const { return block.getNumSamples(); }
+        [[nodiscard]] size_t getNumLevels() const { return levelSizes.size(); }
+        [[nodiscard]] const AudioBlock<const SampleType>& getBlock() const { return block; }
+
+        // Everything ChannelStats knows about samples begin up to (but not including) end of one channel
+        [[nodiscard]] ChannelStats<SampleType> stats (size_t channel, size_t begin, size_t end) const
+        {
+            end = juce::jmin (end, getNumSamples());
+            if (begin >= end)
+                return {};
+
+            const auto* data = block.getChannelPointer (channel);
+            auto firstLeaf = (begin + leafSize - 1) / leafSize;
+            auto lastLeaf = end / leafSize;
+
+            // the range sits inside a single leaf
+            if (firstLeaf > lastLeaf)
+                return calculateChannelStats (data + begin, end - begin);
+
+            auto result = calculateChannelStats (data + begin, firstLeaf * leafSize - begin);
+            auto tail = calculateChannelStats (data + lastLeaf * leafSize, end - lastLeaf * leafSize);
+
+            // climb the pyramid, taking whole nodes off either edge of the range
+            ChannelStats<SampleType> right;
+            for (size_t level = 0; firstLeaf < lastLeaf; ++level, firstLeaf /= 2, lastLeaf /= 2)
+            {
+                if (firstLeaf % 2 == 1)
+                    result = combineChannelStats (result, node (channel, level, firstLeaf++));
+                if (lastLeaf % 2 == 1)
+                    right = combineChannelStats (node (channel, level, --lastLeaf), right);
+            }
+            return combineChannelStats (combineChannelStats (result, right), tail);
+        }
+
+        // highest absolute value on any channel
+        [[nodiscard]] SampleType peak (size_t begin = 0, size_t end = std::numeric_limits<size_t>::max()) const
+        {
+            SampleType result = 0;
+            for (size_t c = 0; c < getNumChannels(); ++c)
+                result = juce::jmax (result, stats (c, begin, end).peak());
+            return result;
+        }
+
+        // RMS across all channels of the range
+        [[nodiscard]] double rms (size_t begin = 0, size_t end = std::numeric_limits<size_t>::max()) const
+        {
+            double sumOfSquares = 0;
+            size_t numSamples = 0;
+            for (size_t c = 0; c < getNumChannels(); ++c)
+            {
+                auto channelStats = stats (c, begin, end);
+                sumOfSquares += channelStats.sumOfSquares;
+                numSamples += channelStats.numSamples;
+            }
+            return numSamples > 0 ? std::sqrt (sumOfSquares / (double) numSamples) : 0.0;
+        }
+
+        // every sample on every channel is exactly zero
+        [[nodiscard]] bool isSilent (size_t begin = 0, size_t end = std::numeric_limits<size_t>::max()) const
+        {
+            for (size_t c = 0; c < getNumChannels(); ++c)
+                if (!stats (c, begin, end).isEmpty())
+                    return false;
+            return true;
+        }
+
+        // every sample on every channel is within min and max (NaNs never are)
+        [[nodiscard]] bool isBetween (size_t begin, size_t end, SampleType min, SampleType max) const
+        {
+            for (size_t c = 0; c < getNumChannels(); ++c)
+            {
+                auto channelStats = stats (c, begin, end);
+                if (channelStats.numNaNs > 0 || channelStats.min < min || channelStats.max > max)
+                    return false;
+            }
+            return true;
+        }
+
+        // Same answer as findFirstNonZeroSample on the block: the earliest one on the first channel that has one.
+        // Descends the pyramid, skipping every node that is all zeros.
+        [[nodiscard]] std::optional<NonZeroSample> firstNonZeroSample (size_t begin = 0, size_t end = std::numeric_limits<size_t>::max()) const
+        {
+            end = juce::jmin (end, getNumSamples());
+            for (size_t c = 0; c < getNumChannels() && begin < end; ++c)
+            {
+                auto leaf = findLeaf (c, begin / leafSize, (end + leafSize - 1) / leafSize, [] (const ChannelStats<SampleType>& s) { return !s.isEmpty(); });
+                while (leaf.has_value())
+                {
+                    const auto start = juce::jmax (begin, *leaf * leafSize);
+                    const auto length = juce::jmin (end, (*leaf + 1) * leafSize) - start;
+                    const auto index = findFirstNonZeroSample (block.getChannelPointer (c) + start, length);
+                    if (index < length)
+                        return NonZeroSample { c, start + index };
+
+                    // the edge leaf's non-zeros were outside the range
+                    leaf = findLeaf (c, *leaf + 1, (end + leafSize - 1) / leafSize, [] (const ChannelStats<SampleType>& s) { return !s.isEmpty(); });
+                }
+            }
+            return std::nullopt;
+        }
+
+        // Same answer as firstGap on the block: the earliest run of 2 or more exact zeros on any channel.
+        // Only leaves that contain a zero are scanned.
+        [[nodiscard]] std::optional<ZeroRun> firstGap (size_t begin = 0, size_t end = std::numeric_limits<size_t>::max()) const
+        {
+            end = juce::jmin (end, getNumSamples());
+            std::optional<ZeroRun> found;
+            for (size_t c = 0; c < getNumChannels(); ++c)
+            {
+                // later channels only matter if their gap starts earlier
+                const auto scanEnd = found.has_value() ? juce::jmin (end, found->start + 1) : end;
+                if (begin >= scanEnd)
+                    break;
+                if (auto gap = firstGapOnChannel (c, begin, scanEnd, end))
+                    found = gap;
+            }
+            return found;
+        }
+
+    private:
+        AudioBlock<const SampleType> block;
+        size_t numLeaves = 0;
+        size_t nodesPerChannel = 0;
+        std::vector<size_t> levelOffsets;
+        std::vector<size_t> levelSizes;
+        std::vector<ChannelStats<SampleType>> nodes;
+
+        [[nodiscard]] const ChannelStats<SampleType>& node (size_t channel, size_t level, size_t index) const
+        {
+            return nodes[channel * nodesPerChannel + levelOffsets[level] + index];
+        }
+
+        // The first gap that starts before scanEnd, followed until it ends or reaches end
+        [[nodiscard]] std::optional<ZeroRun> firstGapOnChannel (size_t channel, size_t begin, size_t scanEnd, size_t end) const
+        {
+            const auto* data = block.getChannelPointer (channel);
+            auto hasZeros = [] (const ChannelStats<SampleType>& s) { return s.numZeros > 0; };
+            const auto lastLeaf = (scanEnd + leafSize - 1) / leafSize;
+            for (auto leaf = findLeaf (channel, begin / leafSize, lastLeaf, hasZeros); leaf.has_value(); leaf = findLeaf (channel, *leaf + 1, lastLeaf, hasZeros))
+            {
+                // one sample of overlap catches gaps that straddle two leaves
+                const auto start = juce::jmax (begin, *leaf * leafSize);
+                const auto leafEnd = juce::jmin (scanEnd, (*leaf + 1) * leafSize + 1);
+                if (start >= leafEnd)
+                    break;
+
+                std::optional<ZeroRun> found;
+                scanZeroRuns (data + start, leafEnd - start, channel, start, SampleType (0), 2, [&] (const ZeroRun& run) {
+                    found = run;
+                    return false;
+                });
+
+                if (found.has_value())
+                {
+                    // a gap can run on past the leaf
+                    while (found->end() < end && data[found->end()] == 0)
+                        ++found->length;
+                    return found;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // The first leaf from firstLeaf up to (not including) lastLeaf whose node passes predicate.
+        // Starts at the top and only descends into nodes that overlap the range and pass.
+        template <typename Predicate>
+        [[nodiscard]] std::optional<size_t> findLeaf (size_t channel, size_t firstLeaf, size_t lastLeaf, Predicate&& predicate) const
+        {
+            if (firstLeaf >= lastLeaf || levelSizes.empty())
+                return std::nullopt;
+            return findLeaf (channel, levelSizes.size() - 1, 0, firstLeaf, lastLeaf, predicate);
+        }
+
+        template <typename Predicate>
+        [[nodiscard]] std::optional<size_t> findLeaf (size_t channel, size_t level, size_t index, size_t firstLeaf, size_t lastLeaf, Predicate& predicate) const
+        {
+            const auto coveredStart = index << level;
+            const auto coveredEnd = (index + 1) << level;
+            if (coveredEnd <= firstLeaf || coveredStart >= lastLeaf || !predicate (node (channel, level, index)))
+                return std::nullopt;
+            if (level == 0)
+                return index;
+
+            for (auto child = 2 * index; child < juce::jmin (2 * index + 2, levelSizes[level - 1]); ++child)
+                if (auto found = findLeaf (channel, level - 1, child, firstLeaf, lastLeaf, predicate))
+                    return found;
+            return std::nullopt;
+        }
+    };
+
+    template <typename SampleType>
+    static inline bool blockIsEmptyUntil (const BlockIndex<SampleType>& index, size_t numSamples)
+    {
+        jassert (index.getNumSamples() >= numSamples);
+        return index.isSilent (0, numSamples);
+    }
+
+    template <typename SampleType>
+    static inline bool blockIsEmptyAfter (const BlockIndex<SampleType>& index, size_t firstZeroAt)
+    {
+        jassert (index.getNumSamples() >= firstZeroAt);
+        return index.isSilent (firstZeroAt);
+    }
+
+    // checks samples from start up to (but not including) end
+    template <typename SampleType>
+    static inline bool blockIsFilledBetween (const BlockIndex<SampleType>& index, int start, int end)
+    {
+        jassert (end > start);
+        jassert ((int) index.getNumSamples() >= end);
+        return !index.firstGap ((size_t) start, (size_t) end).has_value();
+    }
+}
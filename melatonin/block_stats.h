@@ -0,0 +1,182 @@
+#pragma once
+
+namespace melatonin
+{
+    // Everything the helpers want to know about one channel, gathered in a single pass
+    template <typename SampleType>
+    struct ChannelStats
+    {
+        size_t numSamples = 0;
+        SampleType min = 0;
+        SampleType max = 0;
+        double sum = 0;
+        double sumOfSquares = 0;
+        size_t numNaNs = 0;
+        size_t numInfs = 0;
+        size_t numSubnormals = 0;
+        size_t numZeros = 0;
+
+        [[nodiscard]] SampleType peak() const { return juce::jmax (std::abs (min), std::abs (max)); }
+        [[nodiscard]] double rms() const { return numSamples > 0 ? std::sqrt (sumOfSquares / (double) numSamples) : 0.0; }
+        [[nodiscard]] double dcOffset() const { return numSamples > 0 ? sum / (double) numSamples : 0.0; }
+        [[nodiscard]] bool isValid() const { return numNaNs == 0 && numInfs == 0 && numSubnormals == 0; }
+        [[nodiscard]] bool isEmpty() const { return numZeros == numSamples; }
+    };
+
+    // The fused kernel: min, max, sum, sum of squares and classification in one walk of memory.
+    // Each lane keeps its own accumulators so the compiler can keep them in vector registers,
+    // and the sums are kept in double so hour-long renders don't lose precision.
+    template <typename SampleType>
+    static inline ChannelStats<SampleType> calculateChannelStats (const SampleType* data, size_t numSamples)
+    {
+        constexpr size_t lanes = 8;
+        constexpr auto smallestNormal = std::numeric_limits<SampleType>::min();
+        constexpr auto infinity = std::numeric_limits<SampleType>::infinity();
+
+        ChannelStats<SampleType> stats;
+        stats.numSamples = numSamples;
+        if (numSamples == 0)
+            return stats;
+
+        SampleType mins[lanes], maxes[lanes];
+        double sums[lanes] = {}, squares[lanes] = {};
+        size_t nans[lanes] = {}, infs[lanes] = {}, subnormals[lanes] = {}, zeros[lanes] = {};
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            mins[lane] = infinity;
+            maxes[lane] = -infinity;
+        }
+
+        auto accumulate = [&] (size_t lane, SampleType value) {
+            auto magnitude = std::abs (value);
+            mins[lane] = value < mins[lane] ? value : mins[lane];
+            maxes[lane] = value > maxes[lane] ? value : maxes[lane];
+            sums[lane] += (double) value;
+            squares[lane] += (double) value * (double) value;
+            nans[lane] += value != value;
+            infs[lane] += magnitude == infinity;
+            subnormals[lane] += magnitude < smallestNormal && value != 0;
+            zeros[lane] += value == 0;
+        };
+
+        const size_t vectorizedSamples = numSamples - (numSamples % lanes);
+        for (size_t i = 0; i < vectorizedSamples; i += lanes)
+            for (size_t lane = 0; lane < lanes; ++lane)
+                accumulate (lane, data[i + lane]);
+
+        for (size_t i = vectorizedSamples; i < numSamples; ++i)
+            accumulate (i - vectorizedSamples, data[i]);
+
+        stats.min = infinity;
+        stats.max = -infinity;
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            stats.min = juce::jmin (stats.min, mins[lane]);
+            stats.max = juce::jmax (stats.max, maxes[lane]);
+            stats.sum += sums[lane];
+            stats.sumOfSquares += squares[lane];
+            stats.numNaNs += nans[lane];
+            stats.numInfs += infs[lane];
+            stats.numSubnormals += subnormals[lane];
+            stats.numZeros += zeros[lane];
+        }
+
+        // a channel made only of NaNs never updates min/max
+        if (stats.min > stats.max)
+            stats.min = stats.max = 0;
+
+        return stats;
+    }
+
+    // Computes stats for every channel of a block in one pass per channel.
+    // Make one of these when you want several assertions about the same block:
+    //
+    //   auto stats = BlockStats (myBlock);
+    //   REQUIRE_THAT (stats, isValidAudio());
+    //   REQUIRE (rms (stats) > 0.5f);
+    //
+    // The stats are a snapshot. Make a new one if you change the block.
+    template <typename SampleType>
+    class BlockStats
+    {
+    public:
+        explicit BlockStats (const juce::dsp::AudioBlock<SampleType>& block)
+        {
+            channels.reserve (block.getNumChannels());
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+                channels.push_back (calculateChannelStats (block.getChannelPointer (c), block.getNumSamples()));
+        }
+
+        explicit BlockStats (const juce::AudioBuffer<SampleType>& buffer)
+        {
+            channels.reserve ((size_t) buffer.getNumChannels());
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                channels.push_back (calculateChannelStats (buffer.getReadPointer (c), (size_t) buffer.getNumSamples()));
+        }
+
+        [[nodiscard]] size_t getNumChannels() const { return channels.size(); }
+        [[nodiscard]] size_t getNumSamples() const { return channels.empty() ? 0 : channels[0].numSamples; }
+        [[nodiscard]] const ChannelStats<SampleType>& channel (size_t c) const { return channels[c]; }
+
+        // lowest sample value on any channel
+        [[nodiscard]] SampleType min() const
+        {
+            return accumulated ([] (SampleType a, const ChannelStats<SampleType>& s) { return juce::jmin (a, s.min); }, channels.empty() ? SampleType (0) : channels[0].min);
+        }
+
+        // highest sample value on any channel
+        [[nodiscard]] SampleType max() const
+        {
+            return accumulated ([] (SampleType a, const ChannelStats<SampleType>& s) { return juce::jmax (a, s.max); }, channels.empty() ? SampleType (0) : channels[0].max);
+        }
+
+        // highest absolute value on any channel
+        [[nodiscard]] SampleType peak() const
+        {
+            return accumulated ([] (SampleType a, const ChannelStats<SampleType>& s) { return juce::jmax (a, s.peak()); }, SampleType (0));
+        }
+
+        // RMS across all channels and samples
+        [[nodiscard]] double rms() const
+        {
+            auto total = totalSamples();
+            return total > 0 ? std::sqrt (accumulated ([] (double a, const ChannelStats<SampleType>& s) { return a + s.sumOfSquares; }, 0.0) / (double) total) : 0.0;
+        }
+
+        // mean sample value across all channels
+        [[nodiscard]] double dcOffset() const
+        {
+            auto total = totalSamples();
+            return total > 0 ? accumulated ([] (double a, const ChannelStats<SampleType>& s) { return a + s.sum; }, 0.0) / (double) total : 0.0;
+        }
+
+        [[nodiscard]] size_t numNaNs() const { return count (&ChannelStats<SampleType>::numNaNs); }
+        [[nodiscard]] size_t numInfs() const { return count (&ChannelStats<SampleType>::numInfs); }
+        [[nodiscard]] size_t numSubnormals() const { return count (&ChannelStats<SampleType>::numSubnormals); }
+        [[nodiscard]] size_t numZeros() const { return count (&ChannelStats<SampleType>::numZeros); }
+
+        [[nodiscard]] bool isValid() const { return numNaNs() == 0 && numInfs() == 0 && numSubnormals() == 0; }
+        [[nodiscard]] bool isEmpty() const { return numZeros() == totalSamples(); }
+
+    private:
+        std::vector<ChannelStats<SampleType>> channels;
+
+        [[nodiscard]] size_t totalSamples() const { return getNumSamples() * getNumChannels(); }
+
+        [[nodiscard]] size_t count (size_t ChannelStats<SampleType>::*member) const
+        {
+            size_t total = 0;
+            for (auto& c : channels)
+                total += c.*member;
+            return total;
+        }
+
+        template <typename Result, typename Function>
+        [[nodiscard]] Result accumulated (Function&& function, Result initial) const
+        {
+            for (auto& c : channels)
+                initial = function (initial, c);
+            return initial;
+        }
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+namespace melatonin
+{
+    // Blocks up to this many samples per channel are still drawn in full with sparklines
+    static constexpr size_t maxSamplesForSparkline = 512;
+
+    namespace detail
+    {
+        // Draws one row of columns per channel, asking columnStats (channel, start, end) for each column's numbers.
+        // When the columns are sampled, so is every number under the row, and it says so.
+        template <typename SampleType, typename ColumnStats>
+        static inline std::string summarizeColumns (const AudioBlock<const SampleType>& block,
+            size_t numColumns,
+            std::optional<size_t> focusSample,
+            const std::string& note,
+            bool sampled,
+            ColumnStats&& columnStats)
+        {
+            static const char* levels[] = { "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+            constexpr size_t focusRadius = 8;
+
+            const auto numChannels = block.getNumChannels();
+            const auto numSamples = block.getNumSamples();
+
+            std::ostringstream ss;
+            ss << numChannels << " channel" << (numChannels == 1 ? "" : "s") << " of " << numSamples << " samples" << note << "\n";
+
+            for (size_t c = 0; c < numChannels; ++c)
+            {
+                const auto* data = block.getChannelPointer (c);
+                ChannelStats<SampleType> total;
+
+                ss << c << ": ";
+                for (size_t column = 0; column < numColumns; ++column)
+                {
+                    const auto stats = columnStats (c, column * numSamples / numColumns, (column + 1) * numSamples / numColumns);
+                    total = combineChannelStats (total, stats);
+
+                    const auto peak = (double) stats.peak();
+                    if (stats.numNaNs > 0 || stats.numInfs > 0)
+                        ss << "E";
+                    else if (peak == 0)
+                        ss << "_";
+                    else if (peak > 1.0)
+                        ss << "!";
+                    else
+                        ss << levels[juce::jlimit (0, 7, (int) std::ceil (peak * 8.0) - 1)];
+                }
+
+                // sampled counts are always shown, as finding none doesn't mean there are none
+                ss << "\n   min " << total.min << ", max " << total.max << ", rms " << total.rms() << ", dc " << total.dcOffset()
+                   << ", zeros " << total.numZeros;
+                if (sampled || !total.isValid())
+                    ss << ", NaNs " << total.numNaNs << ", infs " << total.numInfs << ", subnormals " << total.numSubnormals;
+                ss << (sampled ? " (sampled)" : "") << "\n";
+
+                if (focusSample.has_value() && *focusSample < numSamples)
+                {
+                    const auto windowStart = *focusSample > focusRadius ? *focusSample - focusRadius : 0;
+                    const auto windowEnd = juce::jmin (numSamples, *focusSample + focusRadius + 1);
+                    ss << "   from sample " << windowStart << ": [" << std::setprecision (std::numeric_limits<SampleType>::max_digits10);
+                    for (auto i = windowStart; i < windowEnd; ++i)
+                        ss << (i > windowStart ? ", " : "") << data[i];
+                    ss << "]\n" << std::setprecision (6);
+                }
+            }
+            return ss.str();
+        }
+    }
+
+    // A failure report for a block of any length, built without copying it and at a capped cost:
+    // each channel is min/max decimated to width columns and followed by its stats.
+    // Past maxSamplesToScan samples in total, each column only reads an even share of the budget from
+    // the start of its range (and says so), so a 10 minute render reports as fast as a 10 second one.
+    // The stats under each channel then come from those samples too and are marked (sampled):
+    // summarize a BlockIndex instead for exact totals.
+    // Pass focusSample to also print the samples either side of it.
+    //
+    // Columns show the peak of their range: _ is silence, ▁ to █ are eighths of full scale,
+    // ! is over full scale and E is a NaN or inf.
+    template <typename SampleType>
+    static inline std::string summarizeBlock (const AudioBlock<const SampleType>& block,
+        size_t width = 80,
+        std::optional<size_t> focusSample = std::nullopt,
+        size_t maxSamplesToScan = (size_t) 1 << 24)
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numColumns = juce::jmax ((size_t) 1, juce::jmin (width, numSamples));
+        const auto perColumnBudget = juce::jmax ((size_t) 1, maxSamplesToScan / juce::jmax ((size_t) 1, numColumns * block.getNumChannels()));
+
+        const auto sampled = numSamples > perColumnBudget * numColumns;
+        const auto note = sampled ? " (each column sampled from its first " + std::to_string (perColumnBudget) + " samples)" : std::string();
+
+        return detail::summarizeColumns (block, numColumns, focusSample, note, sampled, [&] (size_t c, size_t start, size_t end) {
+            return calculateChannelStats (block.getChannelPointer (c) + start, juce::jmin (end - start, perColumnBudget));
+        });
+    }
+
+    // The same summary drawn from a BlockIndex, which makes every column exact at O(log n) each
+    template <typename SampleType>
+    static inline std::string summarizeBlock (const BlockIndex<SampleType>& index,
+        size_t width = 80,
+        std::optional<size_t> focusSample = std::nullopt)
+    {
+        const auto numColumns = juce::jmax ((size_t) 1, juce::jmin (width, index.getNumSamples()));
+        return detail::summarizeColumns (index.getBlock(), numColumns, focusSample, "", false, [&] (size_t c, size_t start, size_t end) {
+            return index.stats (c, start, end);
+        });
+    }
+
+    // A sparkline for short blocks, a bounded summary for long ones
+    template <typename SampleType>
+    static inline std::string describeBlock (const AudioBlock<const SampleType>& block)
+    {
+        if (block.getNumSamples() > maxSamplesForSparkline)
+            return summarizeBlock (block);
+
+        // sparklines only read from the block
+        std::vector<SampleType*> channels;
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+            channels.push_back (const_cast<SampleType*> (block.getChannelPointer (c)));
+        return sparkline (AudioBlock<SampleType> (channels.data(), channels.size(), block.getNumSamples())).toStdString();
+    }
+
+    template <typename SampleType>
+    static inline std::string describeBlock (const AudioBlock<SampleType>& block)
+    {
+        return describeBlock (AudioBlock<const SampleType> (block));
+    }
+
+    template <typename SampleType>
+    static inline std::string describeBlock (const juce::AudioBuffer<SampleType>& buffer)
+    {
+        return describeBlock (AudioBlock<const SampleType> (buffer.getArrayOfReadPointers(), (size_t) buffer.getNumChannels(), (size_t) buffer.getNumSamples()));
+    }
+}
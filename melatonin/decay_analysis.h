@@ -0,0 +1,280 @@
+#pragma once
+
+namespace melatonin
+{
+    // The index just past the last sample louder than threshold, or 0 when nothing is.
+    // Walks backwards from the end in branch-free chunks (which vectorizes), so a tail that
+    // went quiet long ago is found without touching the loud start of the render.
+    template <typename SampleType>
+    static inline size_t tailEndOf (const SampleType* data, size_t numSamples, SampleType threshold)
+    {
+        constexpr size_t chunkSize = 64;
+        auto chunkEnd = numSamples;
+        while (chunkEnd > 0)
+        {
+            const auto chunkStart = chunkEnd > chunkSize ? chunkEnd - chunkSize : 0;
+            bool anyAbove = false;
+            for (auto i = chunkStart; i < chunkEnd; ++i)
+                anyAbove |= std::abs (data[i]) > threshold;
+
+            if (anyAbove)
+                for (auto i = chunkEnd; i > chunkStart; --i)
+                    if (std::abs (data[i - 1]) > threshold)
+                        return i;
+
+            chunkEnd = chunkStart;
+        }
+        return 0;
+    }
+
+    // How a tail dies away, from its Schroeder energy decay curve (the energy still to come at each sample).
+    // Decay times are in seconds and 0 when the curve never got low enough to measure them.
+    struct DecayAnalysis
+    {
+        double sampleRate = 0;
+        double edt = 0; // early decay time, from the first 10dB of decay
+        double t20 = 0; // from the fit between -5 and -25dB
+        double t30 = 0; // from the fit between -5 and -35dB
+        double slope = 0; // dB per second, from the T30 fit (or T20 when there isn't enough range)
+        double thresholdInDB = -90.0;
+        size_t tailEnd = 0; // the sample after which every channel stays below the threshold
+
+        // The standard reverb time, from T30 when available, extrapolated to 60dB of decay
+        [[nodiscard]] double rt60() const { return t30 > 0 ? t30 : t20; }
+        [[nodiscard]] double tailEndInSeconds() const { return sampleRate > 0 ? (double) tailEnd / sampleRate : 0; }
+    };
+
+    namespace detail
+    {
+        // The energy still to come at every sample before end, summed over every channel, in one reverse pass
+        template <typename SampleType>
+        static inline void schroederIntegral (const AudioBlock<const SampleType>& block, size_t end, std::vector<double>& remaining)
+        {
+            std::vector<const SampleType*> channels;
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+                channels.push_back (block.getChannelPointer (c));
+
+            remaining.resize (end);
+            double sum = 0;
+            for (auto i = end; i > 0; --i)
+            {
+                for (auto* data : channels)
+                    sum += (double) data[i - 1] * (double) data[i - 1];
+                remaining[i - 1] = sum;
+            }
+        }
+
+        // least squares line through (sample, dB) pairs, built up one point at a time
+        struct DecayFit
+        {
+            double n = 0, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+
+            void add (double x, double y)
+            {
+                n += 1;
+                sumX += x;
+                sumY += y;
+                sumXX += x * x;
+                sumXY += x * y;
+            }
+
+            // in dB per sample
+            [[nodiscard]] double slope() const
+            {
+                const auto denominator = n * sumXX - sumX * sumX;
+                return n > 1 && denominator > 0 ? (n * sumXY - sumX * sumY) / denominator : 0;
+            }
+
+            // samples for the fitted line to fall 60dB
+            [[nodiscard]] double decayTime (double sampleRate) const
+            {
+                return slope() < 0 ? -60.0 / slope() / sampleRate : 0;
+            }
+        };
+    }
+
+    // The Schroeder curve for every channel combined, in dB relative to the total energy
+    template <typename SampleType>
+    static inline std::vector<float> energyDecayCurve (const AudioBlock<const SampleType>& block)
+    {
+        std::vector<double> remaining;
+        detail::schroederIntegral (block, block.getNumSamples(), remaining);
+
+        const auto total = remaining.empty() ? 0.0 : remaining.front();
+        std::vector<float> curve (remaining.size(), -400.0f);
+        if (total > 0)
+            for (size_t i = 0; i < remaining.size(); ++i)
+                curve[i] = (float) juce::Decibels::gainToDecibels (std::sqrt (remaining[i] / total), -400.0);
+        return curve;
+    }
+
+    template <typename SampleType>
+    static inline std::vector<float> energyDecayCurve (const AudioBlock<SampleType>& block)
+    {
+        return energyDecayCurve (AudioBlock<const SampleType> (block));
+    }
+
+    // Measure the impulse response (or any tail, started at sample 0) of a reverb or delay.
+    // The audio is read once, in reverse from tailEnd. Whatever comes after it (a noise floor below the threshold)
+    // is left out, so it can't stretch the decay. The total energy is only known at the end of that pass,
+    // so the integral is kept (8 bytes a sample) and the fit ranges are found in it by binary search.
+    // Only the points inside a fit need a log.
+    template <typename SampleType>
+    static inline DecayAnalysis analyzeDecay (const AudioBlock<const SampleType>& block, double sampleRate, double thresholdInDB = -90.0)
+    {
+        DecayAnalysis result;
+        result.sampleRate = sampleRate;
+        result.thresholdInDB = thresholdInDB;
+
+        const auto threshold = (SampleType) juce::Decibels::decibelsToGain (thresholdInDB, -400.0);
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+            result.tailEnd = juce::jmax (result.tailEnd, tailEndOf (block.getChannelPointer (c), block.getNumSamples(), threshold));
+
+        // reused between analyses on the same thread
+        thread_local std::vector<double> remaining;
+        detail::schroederIntegral (block, result.tailEnd, remaining);
+        const auto total = remaining.empty() ? 0.0 : remaining.front();
+        if (total <= 0)
+            return result;
+
+        // the integral only falls, so each fit is a run of samples between two levels
+        const auto firstBelow = [&] (double dB) {
+            const auto level = total * std::pow (10.0, dB / 10.0);
+            return (size_t) (std::partition_point (remaining.begin(), remaining.end(), [=] (double v) { return v >= level; }) - remaining.begin());
+        };
+        const auto firstAtOrBelow = [&] (double dB) {
+            const auto level = total * std::pow (10.0, dB / 10.0);
+            return (size_t) (std::partition_point (remaining.begin(), remaining.end(), [=] (double v) { return v > level; }) - remaining.begin());
+        };
+        const auto earlyEnd = firstBelow (-10.0), fitStart = firstAtOrBelow (-5.0);
+        const auto end25 = firstBelow (-25.0), end35 = firstBelow (-35.0);
+
+        // in dB relative to the running sum: taking out the total would only shift the lines, not their slopes
+        detail::DecayFit early, fit20, fit30;
+        for (size_t i = 0; i < juce::jmax (earlyEnd, end35); ++i)
+        {
+            const auto x = (double) i;
+            const auto dB = 10.0 * std::log10 (remaining[i]);
+            if (i < earlyEnd)
+                early.add (x, dB);
+            if (i >= fitStart && i < end35)
+                fit30.add (x, dB);
+            if (i >= fitStart && i < end25)
+                fit20.add (x, dB);
+        }
+
+        const auto reached25 = end25 < remaining.size(), reached35 = end35 < remaining.size();
+        result.edt = early.decayTime (sampleRate);
+        result.t20 = reached25 ? fit20.decayTime (sampleRate) : 0;
+        result.t30 = reached35 ? fit30.decayTime (sampleRate) : 0;
+        result.slope = (reached35 ? fit30.slope() : fit20.slope()) * sampleRate;
+        return result;
+    }
+
+    template <typename SampleType>
+    static inline DecayAnalysis analyzeDecay (const AudioBlock<SampleType>& block, double sampleRate, double thresholdInDB = -90.0)
+    {
+        return analyzeDecay (AudioBlock<const SampleType> (block), sampleRate, thresholdInDB);
+    }
+
+    // Passes when every channel stays below the threshold (in dBFS) from some point on, which real IIR tails do
+    // long before they reach exact zeros. Add within to put a limit on when:
+    //
+    //   REQUIRE_THAT (reverbOutput, decaysBelow (-90_dB).within (48000 * 3));
+    struct decaysBelow : Catch::Matchers::MatcherGenericBase
+    {
+        double thresholdInDB;
+        size_t limit = std::numeric_limits<size_t>::max();
+        mutable size_t tailEnd = 0;
+        mutable size_t loudestChannel = 0;
+        mutable double lastLevel = 0;
+        mutable size_t numSamples = 0;
+
+        explicit decaysBelow (double dB) : thresholdInDB (dB) {}
+
+        [[nodiscard]] decaysBelow within (size_t samples) const
+        {
+            auto copy = *this;
+            copy.limit = samples;
+            return copy;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            const auto threshold = (std::remove_const_t<SampleType>) juce::Decibels::decibelsToGain (thresholdInDB, -400.0);
+            tailEnd = 0;
+            numSamples = block.getNumSamples();
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                const auto end = tailEndOf (block.getChannelPointer (c), block.getNumSamples(), threshold);
+                if (end > tailEnd)
+                {
+                    tailEnd = end;
+                    loudestChannel = c;
+                    lastLevel = juce::Decibels::gainToDecibels (std::abs ((double) block.getChannelPointer (c)[end - 1]), -400.0);
+                }
+            }
+            return tailEnd < numSamples && tailEnd <= limit;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "decays below " << thresholdInDB << " dB";
+            if (limit != std::numeric_limits<size_t>::max())
+                ss << " within " << limit << " samples";
+            ss << "\n";
+            if (tailEnd == 0)
+                ss << "Every sample is below " << thresholdInDB << " dB";
+            else if (tailEnd >= numSamples)
+                ss << "Channel " << loudestChannel << " is still at " << lastLevel << " dB at the last sample (" << numSamples - 1 << ")";
+            else
+                ss << "Channel " << loudestChannel << " is at " << lastLevel << " dB at sample " << tailEnd - 1;
+            return ss.str();
+        }
+    };
+
+    // Checks the reverb time (T30, or T20 when the tail doesn't decay far enough)
+    //
+    //   REQUIRE_THAT (impulseResponse, hasRT60Between (1.8, 2.2, sampleRate));
+    struct hasRT60Between : Catch::Matchers::MatcherGenericBase
+    {
+        double lowest;
+        double highest;
+        double sampleRate;
+        mutable DecayAnalysis analysis;
+
+        hasRT60Between (double minSeconds, double maxSeconds, double rate) : lowest (minSeconds), highest (maxSeconds), sampleRate (rate) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            analysis = analyzeDecay (block, sampleRate);
+            return analysis.rt60() > 0 && analysis.rt60() >= lowest && analysis.rt60() <= highest;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has an RT60 between " << lowest << "s and " << highest << "s\n";
+            if (analysis.rt60() > 0)
+                ss << "RT60 is " << analysis.rt60() << "s (EDT " << analysis.edt << "s, decaying at " << analysis.slope << " dB/s)";
+            else
+                ss << "The tail doesn't decay 25dB, so there's no RT60 to measure";
+            return ss.str();
+        }
+    };
+}
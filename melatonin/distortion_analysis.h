@@ -0,0 +1,267 @@
+#pragma once
+
+namespace melatonin
+{
+    // So thresholds read like they do on a spec sheet: hasTHDBelow (-80_dB, sampleRate)
+    // Pull in just these with using namespace melatonin::literals
+    inline namespace literals
+    {
+        constexpr double operator""_dB (long double value) { return (double) value; }
+        constexpr double operator""_dB (unsigned long long value) { return (double) value; }
+    }
+
+    // Distortion and noise measured against a single sine. Levels are in dBFS, where a full scale sine is 0 dBFS.
+    // Ratios (THD, THD+N, SNR) are in dB relative to the fundamental.
+    struct DistortionAnalysis
+    {
+        double fundamentalFrequency = 0;
+        double fundamentalLevel = -400.0;
+        std::vector<double> harmonicLevels; // the 2nd harmonic first, only those below nyquist
+        double thd = 0;
+        double thdPlusNoise = 0;
+        double snr = 0;
+        double noiseLevel = -400.0; // everything that isn't DC, the fundamental or a harmonic
+
+        [[nodiscard]] double thdPercent() const { return std::pow (10.0, thd / 20.0) * 100.0; }
+        [[nodiscard]] double sinad() const { return -thdPlusNoise; }
+    };
+
+    // The spectrum is unscaled and windowed with a 7 term Blackman-Harris (a floor around -140dB in float),
+    // with each bin holding the mean square power it contributes, so bins can be summed into
+    // real levels regardless of the window's equivalent noise bandwidth.
+    // The last fftSize samples are analyzed, skipping any start up transient.
+    template <typename SampleType>
+    static inline DistortionAnalysis analyzeDistortion (const AudioBlock<const SampleType>& block,
+        double sampleRate,
+        size_t channel = 0,
+        int maxOrder = 16,
+        size_t numHarmonics = 9,
+        double fundamentalFrequency = 0)
+    {
+        DistortionAnalysis result;
+        const auto numSamples = block.getNumSamples();
+        if (numSamples < 64 || channel >= block.getNumChannels())
+            return result;
+
+        const auto order = juce::jmin (maxOrder, (int) std::floor (std::log2 ((double) numSamples)));
+        const auto fftSize = (size_t) 1 << order;
+        const auto numBins = fftSize / 2 + 1;
+
+        // reused between analyses on the same thread, so big FFTs don't page fault every time
+        thread_local std::vector<float> data;
+        thread_local std::vector<double> power;
+        data.resize (fftSize * 2);
+        power.resize (numBins);
+
+        const auto window = getBlackmanHarris7Window (order);
+        copyForFFT (data.data(), block.getChannelPointer (channel) + (numSamples - fftSize), fftSize, fftSize);
+        juce::FloatVectorOperations::multiply (data.data(), window->data(), (int) fftSize);
+        FFTPlanCache::getInstance().getEngine (order)->performRealOnlyForwardTransform (data.data(), true);
+
+        double sumOfSquares = 0;
+        for (auto w : *window)
+            sumOfSquares += (double) w * (double) w;
+
+        // white noise of variance v lands as 2v/N in every bin, a sine's bins add up to its mean square
+        const auto normalisation = 1.0 / ((double) fftSize * sumOfSquares);
+        for (size_t k = 0; k < numBins; ++k)
+        {
+            const auto re = (double) data[2 * k], im = (double) data[2 * k + 1];
+            const bool isEdge = k == 0 || k == numBins - 1;
+            power[k] = (re * re + im * im) * normalisation * (isEdge ? 1.0 : 2.0);
+        }
+
+        // the window puts a tone's energy within 7 bins either side of it, plus one bin of margin
+        constexpr size_t lobe = 8;
+        std::vector<bool> claimed (numBins, false);
+        const auto claim = [&] (size_t centre) {
+            double total = 0;
+            for (auto k = centre > lobe ? centre - lobe : 0; k <= juce::jmin (centre + lobe, numBins - 1); ++k)
+            {
+                if (!claimed[k])
+                    total += power[k];
+                claimed[k] = true;
+            }
+            return total;
+        };
+        const auto strongestBinBetween = [&] (size_t low, size_t high) {
+            auto strongest = low;
+            for (auto k = low; k <= juce::jmin (high, numBins - 1); ++k)
+                if (power[k] > power[strongest])
+                    strongest = k;
+            return strongest;
+        };
+
+        const auto binWidth = sampleRate / (double) fftSize;
+        claim (0); // DC
+
+        size_t fundamentalBin;
+        if (fundamentalFrequency > 0)
+        {
+            const auto expected = (size_t) std::llround (fundamentalFrequency / binWidth);
+            fundamentalBin = strongestBinBetween (expected > lobe + 2 ? expected - 2 : lobe + 1, expected + 2);
+        }
+        else
+        {
+            fundamentalBin = strongestBinBetween (lobe + 1, numBins - 1);
+        }
+
+        // the centre of the fundamental's main lobe is a better frequency estimate than its strongest bin
+        double weightedBins = 0, fundamentalPower = 0;
+        for (auto k = fundamentalBin - lobe; k <= juce::jmin (fundamentalBin + lobe, numBins - 1); ++k)
+        {
+            weightedBins += (double) k * power[k];
+            fundamentalPower += power[k];
+        }
+        if (fundamentalPower <= 0)
+            return result;
+
+        claim (fundamentalBin);
+        const auto fundamentalPosition = weightedBins / fundamentalPower;
+        result.fundamentalFrequency = fundamentalPosition * binWidth;
+
+        double harmonicPower = 0;
+        for (size_t h = 2; h < numHarmonics + 2; ++h)
+        {
+            const auto expected = (size_t) std::llround (fundamentalPosition * (double) h);
+            if (expected + 2 >= numBins)
+                break;
+
+            const auto thisHarmonic = claim (strongestBinBetween (expected - 2, expected + 2));
+            harmonicPower += thisHarmonic;
+            result.harmonicLevels.push_back (juce::Decibels::gainToDecibels (std::sqrt (2.0 * thisHarmonic), -400.0));
+        }
+
+        double noisePower = 0;
+        for (size_t k = 0; k < numBins; ++k)
+            if (!claimed[k])
+                noisePower += power[k];
+
+        const auto ratioInDB = [&] (double p) { return juce::Decibels::gainToDecibels (std::sqrt (p / fundamentalPower), -400.0); };
+        result.fundamentalLevel = juce::Decibels::gainToDecibels (std::sqrt (2.0 * fundamentalPower), -400.0);
+        result.noiseLevel = juce::Decibels::gainToDecibels (std::sqrt (2.0 * noisePower), -400.0);
+        result.thd = ratioInDB (harmonicPower);
+        result.thdPlusNoise = ratioInDB (harmonicPower + noisePower);
+        result.snr = -ratioInDB (noisePower);
+        return result;
+    }
+
+    template <typename SampleType>
+    static inline DistortionAnalysis analyzeDistortion (const AudioBlock<SampleType>& block,
+        double sampleRate,
+        size_t channel = 0,
+        int maxOrder = 16,
+        size_t numHarmonics = 9,
+        double fundamentalFrequency = 0)
+    {
+        return analyzeDistortion (AudioBlock<const SampleType> (block), sampleRate, channel, maxOrder, numHarmonics, fundamentalFrequency);
+    }
+
+    // Shared by the distortion matchers: analyzes every channel and keeps the worst one
+    struct DistortionMatcherBase : Catch::Matchers::MatcherGenericBase
+    {
+        double threshold;
+        double sampleRate;
+        mutable DistortionAnalysis worst;
+        mutable size_t worstChannel = 0;
+
+        DistortionMatcherBase (double t, double rate) : threshold (t), sampleRate (rate) {}
+
+        template <typename SampleType, typename Badness>
+        bool matchAllChannels (const AudioBlock<const SampleType>& block, Badness badness) const
+        {
+            bool first = true;
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                auto analysis = analyzeDistortion (block, sampleRate, c);
+                if (first || badness (analysis) > badness (worst))
+                {
+                    worst = std::move (analysis);
+                    worstChannel = c;
+                    first = false;
+                }
+            }
+            return !first && worst.fundamentalLevel > -400.0 && badness (worst) <= threshold;
+        }
+
+        [[nodiscard]] std::string describeWorst() const
+        {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision (1)
+               << "Channel " << worstChannel << ": fundamental " << worst.fundamentalFrequency << "Hz at " << worst.fundamentalLevel << " dBFS, "
+               << "THD " << worst.thd << " dB, THD+N " << worst.thdPlusNoise << " dB, SNR " << worst.snr << " dB\nHarmonics (dBFS):";
+            for (size_t h = 0; h < worst.harmonicLevels.size(); ++h)
+                ss << " H" << h + 2 << " " << worst.harmonicLevels[h];
+            return ss.str();
+        }
+    };
+
+    // Feed a sine in, check what comes out:
+    //
+    //   REQUIRE_THAT (output, hasTHDBelow (-80_dB, sampleRate));
+    struct hasTHDBelow : DistortionMatcherBase
+    {
+        hasTHDBelow (double dB, double rate) : DistortionMatcherBase (dB, rate) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            return matchAllChannels (AudioBlock<const SampleType> (block), [] (const DistortionAnalysis& a) { return a.thd; });
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            return "has THD below " + std::to_string (threshold) + " dB\n" + describeWorst();
+        }
+    };
+
+    struct hasTHDPlusNoiseBelow : DistortionMatcherBase
+    {
+        hasTHDPlusNoiseBelow (double dB, double rate) : DistortionMatcherBase (dB, rate) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            return matchAllChannels (AudioBlock<const SampleType> (block), [] (const DistortionAnalysis& a) { return a.thdPlusNoise; });
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            return "has THD+N below " + std::to_string (threshold) + " dB\n" + describeWorst();
+        }
+    };
+
+    struct hasSNRAbove : DistortionMatcherBase
+    {
+        hasSNRAbove (double dB, double rate) : DistortionMatcherBase (-dB, rate) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            return matchAllChannels (AudioBlock<const SampleType> (block), [] (const DistortionAnalysis& a) { return -a.snr; });
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            return "has SNR above " + std::to_string (-threshold) + " dB\n" + describeWorst();
+        }
+    };
+}
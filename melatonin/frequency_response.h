@@ -0,0 +1,332 @@
+#pragma once
+
+namespace melatonin
+{
+    // An exponential (Farina) sine sweep. It spends equal time in every octave and, once deconvolved,
+    // pushes harmonic distortion out before the linear impulse response where it can be cut away.
+    struct LogSweep
+    {
+        double sampleRate;
+        double startFrequency;
+        double endFrequency;
+        double seconds;
+        double amplitude;
+
+        // endFrequency defaults to just under nyquist
+        explicit LogSweep (double rate, double start = 10.0, double end = 0, double lengthInSeconds = 2.0, double gain = 0.5)
+            : sampleRate (rate), startFrequency (start), endFrequency (end > 0 ? end : rate * 0.48), seconds (lengthInSeconds), amplitude (gain) {}
+
+        [[nodiscard]] size_t getNumSamples() const { return (size_t) std::llround (seconds * sampleRate); }
+
+        [[nodiscard]] double valueAt (size_t i) const
+        {
+            const auto rate = std::log (endFrequency / startFrequency);
+            const auto t = (double) i / sampleRate;
+            const auto phase = juce::MathConstants<double>::twoPi * startFrequency * seconds / rate * (std::exp (t / seconds * rate) - 1.0);
+
+            // 5ms fades stop the ends from clicking
+            const auto fadeLength = 0.005 * sampleRate;
+            const auto fadePosition = juce::jmin ((double) i, (double) (getNumSamples() - 1 - i)) / fadeLength;
+            const auto fade = fadePosition < 1.0 ? 0.5 - 0.5 * std::cos (juce::MathConstants<double>::pi * fadePosition) : 1.0;
+            return amplitude * fade * std::sin (phase);
+        }
+
+        // Fills every channel with the sweep, followed by silence
+        template <typename SampleType>
+        void fill (AudioBlock<SampleType>& block) const
+        {
+            block.clear();
+            for (size_t i = 0; i < juce::jmin (getNumSamples(), block.getNumSamples()); ++i)
+            {
+                const auto value = (SampleType) valueAt (i);
+                for (size_t c = 0; c < block.getNumChannels(); ++c)
+                    block.setSample ((int) c, (int) i, value);
+            }
+        }
+    };
+
+    // The linear response of one channel, recovered from a sweep
+    struct FrequencyResponse
+    {
+        double sampleRate = 0;
+        double startFrequency = 0; // only frequencies the sweep covered are meaningful
+        double endFrequency = 0;
+        size_t delay = 0; // where the impulse response peaks, in samples
+        std::vector<float> impulseResponse;
+        std::vector<std::complex<double>> spectrum; // bins from 0Hz to nyquist
+
+        [[nodiscard]] double binWidth() const { return sampleRate / (double) ((spectrum.size() - 1) * 2); }
+
+        [[nodiscard]] std::complex<double> at (double frequency) const
+        {
+            if (spectrum.empty())
+                return {};
+            const auto position = juce::jlimit (0.0, (double) (spectrum.size() - 1), frequency / binWidth());
+            const auto bin = juce::jmin ((size_t) position, spectrum.size() - 2);
+            const auto fraction = position - (double) bin;
+            return spectrum[bin] * (1.0 - fraction) + spectrum[bin + 1] * fraction;
+        }
+
+        [[nodiscard]] double magnitudeAt (double frequency) const
+        {
+            return juce::Decibels::gainToDecibels (std::abs (at (frequency)), -400.0);
+        }
+
+        // In degrees, from -180 to 180. By default the delay is taken out first,
+        // so a plain delay (or a processor's latency) reads as 0 everywhere.
+        [[nodiscard]] double phaseAt (double frequency, bool removeDelay = true) const
+        {
+            auto value = at (frequency);
+            if (removeDelay)
+                value *= std::polar (1.0, juce::MathConstants<double>::twoPi * frequency * (double) delay / sampleRate);
+            return juce::radiansToDegrees (std::arg (value));
+        }
+    };
+
+    // Recovers the linear response from a recording of the sweep by regularized spectral division.
+    // Harmonic distortion lands at negative times, so only impulseResponseLength samples after 0 are kept.
+    // That's 3 FFTs plus one more for the final spectrum, all with cached plans.
+    template <typename SampleType>
+    static inline FrequencyResponse deconvolveSweep (const SampleType* recorded, size_t numRecorded, const LogSweep& sweep, size_t impulseResponseLength)
+    {
+        const auto sweepLength = sweep.getNumSamples();
+        const auto order = (int) std::ceil (std::log2 ((double) (juce::jmax (numRecorded, sweepLength) + sweepLength)));
+        const auto fftSize = (size_t) 1 << order;
+        const auto numBins = fftSize / 2 + 1;
+        const auto engine = FFTPlanCache::getInstance().getEngine (order);
+        impulseResponseLength = juce::jmin (impulseResponseLength, fftSize / 2);
+
+        std::vector<float> sweepData (fftSize * 2), recordedData (fftSize * 2);
+        for (size_t i = 0; i < sweepLength; ++i)
+            sweepData[i] = (float) sweep.valueAt (i);
+        copyForFFT (recordedData.data(), recorded, numRecorded, fftSize);
+        engine->performRealOnlyForwardTransform (sweepData.data(), true);
+        engine->performRealOnlyForwardTransform (recordedData.data(), true);
+
+        // Y X* / (|X|^2 + e), with e far enough down (-80dB) to only matter outside the sweep's range
+        double maxPower = 0;
+        for (size_t k = 0; k < numBins; ++k)
+            maxPower = juce::jmax (maxPower, (double) sweepData[2 * k] * sweepData[2 * k] + (double) sweepData[2 * k + 1] * sweepData[2 * k + 1]);
+        const auto regularization = maxPower * 1e-8;
+
+        // recordedData becomes the transfer function, filled out with its conjugates for the inverse transform
+        for (size_t k = 0; k < numBins; ++k)
+        {
+            const auto x = std::complex<double> (sweepData[2 * k], sweepData[2 * k + 1]);
+            const auto y = std::complex<double> (recordedData[2 * k], recordedData[2 * k + 1]);
+            const auto h = y * std::conj (x) / (std::norm (x) + regularization);
+            recordedData[2 * k] = (float) h.real();
+            recordedData[2 * k + 1] = (float) h.imag();
+        }
+        for (size_t k = numBins; k < fftSize; ++k)
+        {
+            recordedData[2 * k] = recordedData[2 * (fftSize - k)];
+            recordedData[2 * k + 1] = -recordedData[2 * (fftSize - k) + 1];
+        }
+        engine->performRealOnlyInverseTransform (recordedData.data());
+
+        FrequencyResponse response;
+        response.sampleRate = sweep.sampleRate;
+        response.startFrequency = sweep.startFrequency;
+        response.endFrequency = sweep.endFrequency;
+
+        // Keep a little before 0 for anything that rings ahead of the peak, well clear of the 2nd harmonic
+        // (which arrives seconds * ln(2) / ln(end / start) early), and fade out the last tenth of the response
+        const auto secondHarmonicLead = sweep.seconds * std::log (2.0) / std::log (sweep.endFrequency / sweep.startFrequency) * sweep.sampleRate;
+        const auto preRoll = juce::jmin ((size_t) 32, (size_t) (secondHarmonicLead / 2));
+        const auto fadeStart = impulseResponseLength - impulseResponseLength / 10;
+        for (size_t i = 0; i < fftSize; ++i)
+        {
+            if (i >= impulseResponseLength && i < fftSize - preRoll)
+                recordedData[i] = 0;
+            else if (i >= fadeStart && i < impulseResponseLength)
+                recordedData[i] *= (float) (0.5 + 0.5 * std::cos (juce::MathConstants<double>::pi * (double) (i - fadeStart) / (double) (impulseResponseLength - fadeStart)));
+        }
+
+        response.impulseResponse.assign (recordedData.begin(), recordedData.begin() + (long) impulseResponseLength);
+        for (size_t i = 0; i < impulseResponseLength; ++i)
+            if (std::abs (recordedData[i]) > std::abs (recordedData[response.delay]))
+                response.delay = i;
+
+        std::fill (recordedData.begin() + (long) fftSize, recordedData.end(), 0.0f);
+        engine->performRealOnlyForwardTransform (recordedData.data(), true);
+        response.spectrum.resize (numBins);
+        for (size_t k = 0; k < numBins; ++k)
+            response.spectrum[k] = { recordedData[2 * k], recordedData[2 * k + 1] };
+        return response;
+    }
+
+    // One render of a log sweep through the processor, giving the impulse, magnitude and phase response of every channel.
+    // The impulse response is cut off after tailSeconds, so make that longer than the processor's latency plus its ring.
+    //
+    //   auto response = measureFrequencyResponse (myProcessor, 48000);
+    //   REQUIRE_THAT (response, hasMagnitudeResponseWithin (ResponseCurve::flat (0.5)));
+    template <typename SampleType = float>
+    static inline std::vector<FrequencyResponse> measureFrequencyResponse (juce::AudioProcessor& processor,
+        double sampleRate = 48000.0,
+        int blockSize = 512,
+        double tailSeconds = 0.5,
+        std::optional<LogSweep> sweep = std::nullopt)
+    {
+        if (!sweep)
+            sweep.emplace (sampleRate);
+        jassert (juce::approximatelyEqual (sweep->sampleRate, sampleRate));
+
+        const auto tailLength = (size_t) std::llround (tailSeconds * sampleRate);
+        const auto numChannels = juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels(), 1);
+        juce::AudioBuffer<SampleType> input (numChannels, (int) (sweep->getNumSamples() + tailLength));
+        auto inputBlock = AudioBlock<SampleType> (input);
+        sweep->fill (inputBlock);
+
+        ProcessorHarness<SampleType> harness (processor, sampleRate, blockSize);
+        auto& output = harness.render (inputBlock);
+
+        std::vector<FrequencyResponse> responses;
+        for (int c = 0; c < output.getNumChannels(); ++c)
+            responses.push_back (deconvolveSweep (output.getReadPointer (c), (size_t) output.getNumSamples(), *sweep, tailLength));
+        return responses;
+    }
+
+    // Upper and lower limits over a frequency range, straight lines between points on a log frequency axis.
+    // Used for dB with magnitudes and degrees with phase.
+    struct ResponseCurve
+    {
+        struct Point
+        {
+            double frequency;
+            double lower;
+            double upper;
+        };
+
+        std::vector<Point> points;
+
+        ResponseCurve (std::initializer_list<Point> p) : points (p)
+        {
+            jassert (points.size() >= 2);
+        }
+
+        // within tolerance either side of target, e.g. ±0.5dB from 20Hz to 20kHz
+        static ResponseCurve flat (double tolerance, double lowFrequency = 20.0, double highFrequency = 20000.0, double target = 0.0)
+        {
+            return { { lowFrequency, target - tolerance, target + tolerance }, { highFrequency, target - tolerance, target + tolerance } };
+        }
+
+        [[nodiscard]] double lowestFrequency() const { return points.front().frequency; }
+        [[nodiscard]] double highestFrequency() const { return points.back().frequency; }
+
+        [[nodiscard]] std::pair<double, double> limitsAt (double frequency) const
+        {
+            for (size_t i = 1; i < points.size(); ++i)
+            {
+                if (frequency > points[i].frequency)
+                    continue;
+                const auto& a = points[i - 1];
+                const auto& b = points[i];
+                const auto fraction = b.frequency > a.frequency ? std::log (frequency / a.frequency) / std::log (b.frequency / a.frequency) : 1.0;
+                return { a.lower + (b.lower - a.lower) * fraction, a.upper + (b.upper - a.upper) * fraction };
+            }
+            return { points.back().lower, points.back().upper };
+        }
+    };
+
+    // Shared by the response matchers: checks every bin the curve covers, on every channel, and remembers the worst miss
+    struct ResponseMatcherBase : Catch::Matchers::MatcherGenericBase
+    {
+        ResponseCurve curve;
+        mutable std::string problem = "";
+
+        explicit ResponseMatcherBase (ResponseCurve c) : curve (std::move (c)) {}
+
+        template <typename Measure>
+        bool matchCurve (const std::vector<FrequencyResponse>& responses, Measure measure, const char* units) const
+        {
+            problem.clear();
+            for (size_t c = 0; c < responses.size(); ++c)
+            {
+                const auto& response = responses[c];
+                if (curve.lowestFrequency() < response.startFrequency || curve.highestFrequency() > response.endFrequency)
+                {
+                    std::ostringstream ss;
+                    ss << "the sweep only covered " << response.startFrequency << "Hz to " << response.endFrequency << "Hz";
+                    problem = ss.str();
+                    return false;
+                }
+
+                double worstMiss = 0, worstFrequency = 0, worstValue = 0;
+                std::pair<double, double> worstLimits;
+                const auto firstBin = (size_t) std::ceil (curve.lowestFrequency() / response.binWidth());
+                for (auto bin = firstBin; (double) bin * response.binWidth() <= curve.highestFrequency(); ++bin)
+                {
+                    const auto frequency = (double) bin * response.binWidth();
+                    const auto value = measure (response, frequency);
+                    const auto limits = curve.limitsAt (frequency);
+                    const auto miss = juce::jmax (limits.first - value, value - limits.second);
+                    if (miss > worstMiss)
+                    {
+                        worstMiss = miss;
+                        worstFrequency = frequency;
+                        worstValue = value;
+                        worstLimits = limits;
+                    }
+                }
+
+                if (worstMiss > 0)
+                {
+                    std::ostringstream ss;
+                    ss << std::fixed << std::setprecision (2) << "Channel " << c << " is " << worstValue << units << " at " << worstFrequency
+                       << "Hz, outside " << worstLimits.first << units << " to " << worstLimits.second << units;
+                    problem = ss.str();
+                    return false;
+                }
+            }
+            return !responses.empty();
+        }
+    };
+
+    struct hasMagnitudeResponseWithin : ResponseMatcherBase
+    {
+        explicit hasMagnitudeResponseWithin (ResponseCurve c) : ResponseMatcherBase (std::move (c)) {}
+
+        [[nodiscard]] bool match (const std::vector<FrequencyResponse>& responses) const
+        {
+            return matchCurve (responses, [] (const FrequencyResponse& r, double f) { return r.magnitudeAt (f); }, "dB");
+        }
+
+        [[nodiscard]] bool match (const FrequencyResponse& response) const
+        {
+            return match (std::vector<FrequencyResponse> { response });
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has a magnitude response within the curve from " << curve.lowestFrequency() << "Hz to " << curve.highestFrequency() << "Hz\n"
+               << problem;
+            return ss.str();
+        }
+    };
+
+    // Phase is in degrees, with the response's delay taken out
+    struct hasPhaseResponseWithin : ResponseMatcherBase
+    {
+        explicit hasPhaseResponseWithin (ResponseCurve c) : ResponseMatcherBase (std::move (c)) {}
+
+        [[nodiscard]] bool match (const std::vector<FrequencyResponse>& responses) const
+        {
+            return matchCurve (responses, [] (const FrequencyResponse& r, double f) { return r.phaseAt (f); }, " degrees");
+        }
+
+        [[nodiscard]] bool match (const FrequencyResponse& response) const
+        {
+            return match (std::vector<FrequencyResponse> { response });
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has a phase response within the curve from " << curve.lowestFrequency() << "Hz to " << curve.highestFrequency() << "Hz\n"
+               << problem;
+            return ss.str();
+        }
+    };
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+namespace melatonin
+{
+    // magnitudeOfFrequency is more accurate when it only looks at an integer number of cycles,
+    // so this trims the block down to the last full cycle (or uses everything if there isn't one)
+    static inline size_t fullCycleLength (size_t numSamples, float frequency, float sampleRate)
+    {
+        jassert (frequency > 0 && sampleRate > 0);
+        const auto samplesPerCycle = juce::jmax ((size_t) 1, (size_t) (sampleRate / frequency));
+        const auto length = numSamples - (numSamples % samplesPerCycle);
+        return length > 0 ? length : numSamples;
+    }
+
+    // Goertzel state for a single frequency
+    struct GoertzelState
+    {
+        double coefficient = 0;
+        double s1 = 0;
+        double s2 = 0;
+        size_t length = 0;
+
+        // Amplitude of a sinusoid at this frequency: |DFT| * 2 / N
+        [[nodiscard]] float magnitude() const
+        {
+            if (length == 0)
+                return 0;
+            const auto power = juce::jmax (0.0, s1 * s1 + s2 * s2 - coefficient * s1 * s2);
+            return (float) (std::sqrt (power) * 2.0 / (double) length);
+        }
+    };
+
+    static inline GoertzelState makeGoertzelState (size_t numSamples, float frequency, float sampleRate)
+    {
+        GoertzelState state;
+        state.coefficient = 2.0 * std::cos (juce::MathConstants<double>::twoPi * (double) frequency / (double) sampleRate);
+        state.length = fullCycleLength (numSamples, frequency, sampleRate);
+        return state;
+    }
+
+    // One frequency, one channel, no allocation
+    template <typename SampleType>
+    static inline float goertzelMagnitude (const SampleType* data, size_t numSamples, float frequency, float sampleRate)
+    {
+        auto state = makeGoertzelState (numSamples, frequency, sampleRate);
+        for (size_t i = 0; i < state.length; ++i)
+        {
+            const auto s0 = (double) data[i] + state.coefficient * state.s1 - state.s2;
+            state.s2 = state.s1;
+            state.s1 = s0;
+        }
+        return state.magnitude();
+    }
+
+    // Many frequencies in a single pass over one channel.
+    // Frequencies are ordered by how many samples they use, so each sample only updates the
+    // frequencies still running, and the inner loop runs over independent states (which vectorizes).
+    template <typename SampleType>
+    static inline void goertzelMagnitudes (const SampleType* data, size_t numSamples, const std::vector<float>& frequencies, float sampleRate, float* magnitudes)
+    {
+        const auto numFrequencies = frequencies.size();
+        std::vector<GoertzelState> states;
+        states.reserve (numFrequencies);
+        for (auto frequency : frequencies)
+            states.push_back (makeGoertzelState (numSamples, frequency, sampleRate));
+
+        std::vector<size_t> order (numFrequencies);
+        std::iota (order.begin(), order.end(), (size_t) 0);
+        std::sort (order.begin(), order.end(), [&] (size_t a, size_t b) { return states[a].length > states[b].length; });
+
+        std::vector<double> coefficients (numFrequencies), s1 (numFrequencies, 0.0), s2 (numFrequencies, 0.0);
+        for (size_t k = 0; k < numFrequencies; ++k)
+            coefficients[k] = states[order[k]].coefficient;
+
+        size_t active = numFrequencies;
+        for (size_t i = 0; i < numSamples && active > 0; ++i)
+        {
+            while (active > 0 && states[order[active - 1]].length <= i)
+                --active;
+
+            const auto sample = (double) data[i];
+            for (size_t k = 0; k < active; ++k)
+            {
+                const auto s0 = sample + coefficients[k] * s1[k] - s2[k];
+                s2[k] = s1[k];
+                s1[k] = s0;
+            }
+        }
+
+        for (size_t k = 0; k < numFrequencies; ++k)
+        {
+            auto& state = states[order[k]];
+            state.s1 = s1[k];
+            state.s2 = s2[k];
+            magnitudes[order[k]] = state.magnitude();
+        }
+    }
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+namespace melatonin
+{
+    // Counts samples into equal width bins between low and high. Samples outside the range
+    // are counted as underflow or overflow (a sample equal to high lands in the last bin) and NaNs separately.
+    class Histogram
+    {
+    public:
+        Histogram (size_t bins, double lowest, double highest)
+            : numBins (juce::jmax ((size_t) 1, bins)), low (lowest), high (highest)
+        {
+            jassert (high > low);
+            for (auto& table : tables)
+                table.assign (numBins + 3, 0);
+        }
+
+        // Bins every channel in a single pass.
+        // Bin indexes are worked out 64 at a time without branches (which vectorizes),
+        // then counted into 4 interleaved tables so repeated bins don't stall on each other.
+        template <typename SampleType>
+        void add (const SampleType* data, size_t numSamples)
+        {
+            constexpr size_t chunkSize = 64;
+            const auto scale = (double) numBins / (high - low);
+            const auto lastBin = (double) numBins - 1;
+            const auto nanIndex = (uint32_t) (numBins + 2);
+            uint32_t indexes[chunkSize];
+
+            for (size_t start = 0; start < numSamples; start += chunkSize)
+            {
+                const auto count = juce::jmin (chunkSize, numSamples - start);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const auto x = (double) data[start + i];
+                    const auto position = (x - low) * scale;
+
+                    // 0 is underflow, 1 to numBins are the bins, numBins + 1 is overflow
+                    const auto bin = position < 0 ? -1.0 : (x > high ? lastBin + 1.0 : juce::jmin (std::floor (position), lastBin));
+                    indexes[i] = x == x ? (uint32_t) (bin + 1.0) : nanIndex;
+                }
+                for (size_t i = 0; i < count; ++i)
+                    ++tables[i & 3][indexes[i]];
+            }
+            isMerged = false;
+        }
+
+        template <typename SampleType>
+        void add (const AudioBlock<SampleType>& block)
+        {
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+                add (block.getChannelPointer (c), block.getNumSamples());
+        }
+
+        template <typename SampleType>
+        void add (juce::AudioBuffer<SampleType>& buffer)
+        {
+            add (AudioBlock<SampleType> (buffer));
+        }
+
+        // A histogram over the block's own range
+        template <typename SampleType>
+        static Histogram of (const AudioBlock<SampleType>& block, size_t bins = 10)
+        {
+            auto lowest = std::numeric_limits<double>::max();
+            auto highest = std::numeric_limits<double>::lowest();
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+            {
+                const auto range = juce::FloatVectorOperations::findMinAndMax (block.getChannelPointer (c), (int) block.getNumSamples());
+                lowest = juce::jmin (lowest, (double) range.getStart());
+                highest = juce::jmax (highest, (double) range.getEnd());
+            }
+            if (!(highest > lowest))
+                highest = lowest + 1.0;
+
+            Histogram histogram (bins, lowest, highest);
+            histogram.add (block);
+            return histogram;
+        }
+
+        [[nodiscard]] size_t getNumBins() const { return numBins; }
+        [[nodiscard]] double getLow() const { return low; }
+        [[nodiscard]] double getHigh() const { return high; }
+        [[nodiscard]] double binWidth() const { return (high - low) / (double) numBins; }
+        [[nodiscard]] double binStart (size_t bin) const { return low + (double) bin * binWidth(); }
+        [[nodiscard]] double binEnd (size_t bin) const { return bin + 1 == numBins ? high : binStart (bin + 1); }
+
+        [[nodiscard]] size_t count (size_t bin) const { return merged()[bin + 1]; }
+        [[nodiscard]] size_t underflow() const { return merged().front(); }
+        [[nodiscard]] size_t overflow() const { return merged()[numBins + 1]; }
+        [[nodiscard]] size_t numNaNs() const { return merged().back(); }
+
+        // every sample that's a number, including under and overflow
+        [[nodiscard]] size_t total() const
+        {
+            const auto& counts = merged();
+            return std::accumulate (counts.begin(), counts.end() - 1, (size_t) 0);
+        }
+
+        [[nodiscard]] size_t largestCount() const
+        {
+            const auto& counts = merged();
+            return *std::max_element (counts.begin() + 1, counts.begin() + 1 + (long) numBins);
+        }
+
+    private:
+        size_t numBins;
+        double low;
+        double high;
+        std::array<std::vector<size_t>, 4> tables;
+        mutable std::vector<size_t> mergedCounts;
+        mutable bool isMerged = false;
+
+        const std::vector<size_t>& merged() const
+        {
+            if (!isMerged)
+            {
+                mergedCounts.assign (numBins + 3, 0);
+                for (auto& table : tables)
+                    for (size_t i = 0; i < table.size(); ++i)
+                        mergedCounts[i] += table[i];
+                isMerged = true;
+            }
+            return mergedCounts;
+        }
+    };
+
+    // What the samples should look like: a range to bin over (where nearly everything should land) and the CDF
+    struct Distribution
+    {
+        std::string name;
+        double low;
+        double high;
+        std::function<double (double)> cdf;
+    };
+
+    struct Uniform : Distribution
+    {
+        Uniform (double lowest = -1.0, double highest = 1.0)
+            : Distribution { describeRange (lowest, highest), lowest, highest, [lowest, highest] (double x) {
+                                return juce::jlimit (0.0, 1.0, (x - lowest) / (highest - lowest));
+                            } } {}
+
+    private:
+        static std::string describeRange (double lowest, double highest)
+        {
+            std::ostringstream ss;
+            ss << "Uniform(" << lowest << ", " << highest << ")";
+            return ss.str();
+        }
+    };
+
+    struct Gaussian : Distribution
+    {
+        Gaussian (double mean = 0.0, double standardDeviation = 1.0)
+            : Distribution { describe (mean, standardDeviation), mean - 8.0 * standardDeviation, mean + 8.0 * standardDeviation, [mean, standardDeviation] (double x) {
+                                return 0.5 * std::erfc (-(x - mean) / (standardDeviation * std::sqrt (2.0)));
+                            } } {}
+
+    private:
+        static std::string describe (double mean, double standardDeviation)
+        {
+            std::ostringstream ss;
+            ss << "Gaussian(" << mean << ", " << standardDeviation << ")";
+            return ss.str();
+        }
+    };
+
+    // Q(a, x), the upper regularized incomplete gamma function, which gives chi-square p-values
+    static inline double regularizedGammaQ (double a, double x)
+    {
+        if (x <= 0)
+            return 1.0;
+
+        const auto logPrefix = a * std::log (x) - x - std::lgamma (a);
+        if (x < a + 1.0)
+        {
+            // series for P(a, x)
+            double term = 1.0 / a, sum = term;
+            for (int n = 1; n < 10000 && std::abs (term) > std::abs (sum) * 1e-15; ++n)
+            {
+                term *= x / (a + n);
+                sum += term;
+            }
+            return juce::jlimit (0.0, 1.0, 1.0 - sum * std::exp (logPrefix));
+        }
+
+        // Lentz's continued fraction for Q(a, x)
+        constexpr auto tiny = 1e-300;
+        double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+        for (int n = 1; n < 10000; ++n)
+        {
+            const auto an = -n * (n - a);
+            b += 2.0;
+            d = an * d + b;
+            d = std::abs (d) < tiny ? tiny : d;
+            c = b + an / c;
+            c = std::abs (c) < tiny ? tiny : c;
+            d = 1.0 / d;
+            const auto delta = d * c;
+            h *= delta;
+            if (std::abs (delta - 1.0) < 1e-15)
+                break;
+        }
+        return juce::jlimit (0.0, 1.0, std::exp (logPrefix) * h);
+    }
+
+    // The probability of a Kolmogorov-Smirnov statistic at least this big
+    static inline double kolmogorovPValue (double statistic, double numSamples)
+    {
+        const auto root = std::sqrt (numSamples);
+        const auto lambda = (root + 0.12 + 0.11 / root) * statistic;
+        if (lambda < 0.2)
+            return 1.0;
+
+        double sum = 0, sign = 1;
+        for (int k = 1; k <= 100; ++k)
+        {
+            const auto term = sign * std::exp (-2.0 * k * k * lambda * lambda);
+            sum += term;
+            if (std::abs (term) < 1e-12)
+                break;
+            sign = -sign;
+        }
+        return juce::jlimit (0.0, 1.0, 2.0 * sum);
+    }
+
+    struct DistributionTestResult
+    {
+        size_t numSamples = 0;
+        double chiSquare = 0;
+        size_t degreesOfFreedom = 0;
+        double chiSquarePValue = 0;
+        double ksStatistic = 0; // the largest gap between the CDFs
+        double ksPValue = 0;
+
+        // the chance of a fit this bad if the samples really came from the distribution, whichever test is harsher
+        [[nodiscard]] double pValue() const { return juce::jmin (chiSquarePValue, ksPValue); }
+    };
+
+    // Runs chi-square and Kolmogorov-Smirnov tests of a histogram against a distribution.
+    // Neighbouring bins are merged for chi-square until each expects at least 5 samples.
+    // KS is measured at the bin edges, so use plenty of bins (it can only under-report the gap).
+    static inline DistributionTestResult testDistribution (const Histogram& histogram, const Distribution& distribution)
+    {
+        DistributionTestResult result;
+        result.numSamples = histogram.total();
+        if (result.numSamples == 0)
+            return result;
+
+        const auto n = (double) result.numSamples;
+        size_t numCells = 0;
+        double cellObserved = 0, cellExpected = 0;
+        const auto addToCell = [&] (double observed, double expected, bool last) {
+            cellObserved += observed;
+            cellExpected += expected;
+            if (cellExpected >= 5.0 || last)
+            {
+                if (cellExpected > 0)
+                {
+                    result.chiSquare += (cellObserved - cellExpected) * (cellObserved - cellExpected) / cellExpected;
+                    ++numCells;
+                }
+                else if (cellObserved > 0)
+                    result.chiSquare = std::numeric_limits<double>::infinity();
+                cellObserved = cellExpected = 0;
+            }
+        };
+
+        auto previousCdf = distribution.cdf (histogram.getLow());
+        double runningCount = (double) histogram.underflow();
+        addToCell (runningCount, previousCdf * n, false);
+        result.ksStatistic = std::abs (runningCount / n - previousCdf);
+
+        for (size_t bin = 0; bin < histogram.getNumBins(); ++bin)
+        {
+            const auto cdf = distribution.cdf (histogram.binEnd (bin));
+            const auto observed = (double) histogram.count (bin);
+            addToCell (observed, (cdf - previousCdf) * n, false);
+
+            runningCount += observed;
+            result.ksStatistic = juce::jmax (result.ksStatistic, std::abs (runningCount / n - cdf));
+            previousCdf = cdf;
+        }
+        addToCell ((double) histogram.overflow(), (1.0 - previousCdf) * n, true);
+
+        result.degreesOfFreedom = numCells > 1 ? numCells - 1 : 1;
+        result.chiSquarePValue = regularizedGammaQ ((double) result.degreesOfFreedom / 2.0, result.chiSquare / 2.0);
+        result.ksPValue = kolmogorovPValue (result.ksStatistic, n);
+        return result;
+    }
+
+    // Bins every channel over the distribution's range and tests the fit
+    template <typename SampleType>
+    static inline DistributionTestResult testDistribution (const AudioBlock<SampleType>& block, const Distribution& distribution, size_t numBins = 1024)
+    {
+        Histogram histogram (numBins, distribution.low, distribution.high);
+        histogram.add (block);
+        return testDistribution (histogram, distribution);
+    }
+
+    // Passes unless the chi-square or Kolmogorov-Smirnov test is confident (below pValue)
+    // that the samples didn't come from the distribution. Samples are assumed independent.
+    //
+    //   REQUIRE_THAT (noiseBuffer, isDistributed (Uniform (-1, 1)));
+    //   REQUIRE_THAT (noiseBuffer, isDistributed (Gaussian (0, 0.25), 0.001));
+    struct isDistributed : Catch::Matchers::MatcherGenericBase
+    {
+        Distribution distribution;
+        double pValue;
+        size_t numBins;
+        mutable DistributionTestResult result;
+
+        explicit isDistributed (Distribution d, double p = 0.01, size_t bins = 1024)
+            : distribution (std::move (d)), pValue (p), numBins (bins) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            result = testDistribution (block, distribution, numBins);
+            return result.numSamples > 0 && result.pValue() >= pValue;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "is distributed as " << distribution.name << " (p >= " << pValue << ")\n"
+               << "Over " << result.numSamples << " samples, chi-square is " << result.chiSquare << " with " << result.degreesOfFreedom
+               << " degrees of freedom (p = " << result.chiSquarePValue << "), KS statistic is " << result.ksStatistic
+               << " (p = " << result.ksPValue << ")";
+            return ss.str();
+        }
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+namespace melatonin
+{
+    enum class LatencyProbe {
+        impulse,
+        chirp
+    };
+
+    // What a processor says its latency is, next to what it actually does
+    struct LatencyMeasurement
+    {
+        int reported = 0;
+        double measured = 0;
+
+        [[nodiscard]] double error() const { return measured - (double) reported; }
+    };
+
+    // A log chirp from 20Hz up to just under nyquist with short fades, so it has energy everywhere
+    // and a sharp autocorrelation peak
+    template <typename SampleType>
+    static inline void fillWithLatencyChirp (AudioBlock<SampleType>& block, double sampleRate, size_t length)
+    {
+        constexpr double startFrequency = 20.0;
+        constexpr size_t fadeLength = 64;
+        const auto endFrequency = 0.45 * sampleRate;
+        const auto duration = (double) length / sampleRate;
+        const auto rate = std::log (endFrequency / startFrequency);
+
+        length = juce::jmin (length, block.getNumSamples());
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto t = (double) i / sampleRate;
+            const auto phase = juce::MathConstants<double>::twoPi * startFrequency * duration / rate * (std::exp (t / duration * rate) - 1.0);
+            const auto fadePosition = (double) juce::jmin (i, length - 1 - i) / (double) fadeLength;
+            const auto fade = fadePosition < 1.0 ? 0.5 - 0.5 * std::cos (juce::MathConstants<double>::pi * fadePosition) : 1.0;
+            const auto value = (SampleType) (0.5 * fade * std::sin (phase));
+            for (size_t c = 0; c < block.getNumChannels(); ++c)
+                block.setSample ((int) c, (int) i, value);
+        }
+    }
+
+    // Sends an impulse or chirp through the processor (in blocks, like a host would) and finds how far
+    // the output lags the input with FFT cross-correlation. Leave room for the largest latency you expect.
+    // The reported latency is read after prepareToPlay, since that's where most processors set it.
+    template <typename SampleType = float>
+    static inline LatencyMeasurement measureLatency (juce::AudioProcessor& processor,
+        double sampleRate = 44100.0,
+        int blockSize = 512,
+        LatencyProbe probe = LatencyProbe::chirp,
+        int maxLatency = 65536)
+    {
+        constexpr size_t chirpLength = 16384;
+        const auto probeLength = probe == LatencyProbe::chirp ? chirpLength : 1;
+        const auto numChannels = juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels(), 1);
+
+        juce::AudioBuffer<SampleType> input (numChannels, (int) probeLength + maxLatency);
+        input.clear();
+        auto inputBlock = AudioBlock<SampleType> (input);
+        if (probe == LatencyProbe::chirp)
+            fillWithLatencyChirp (inputBlock, sampleRate, probeLength);
+        else
+            for (size_t c = 0; c < inputBlock.getNumChannels(); ++c)
+                inputBlock.setSample ((int) c, 0, SampleType (1));
+
+        ProcessorHarness<SampleType> harness (processor, sampleRate, blockSize);
+        auto& output = harness.render (inputBlock);
+
+        LatencyMeasurement measurement;
+        measurement.reported = processor.getLatencySamples();
+        measurement.measured = estimateLatency (AudioBlock<const SampleType> (AudioBlock<SampleType> (output)), AudioBlock<const SampleType> (inputBlock), (size_t) maxLatency);
+        return measurement;
+    }
+
+    // Measures the processor's actual latency and checks getLatencySamples agrees (within a fraction of a sample).
+    // Renders in float unless you ask for double.
+    //
+    //   REQUIRE_THAT (myProcessor, reportsCorrectLatency());
+    //   REQUIRE_THAT (myProcessor, reportsCorrectLatency<double>());
+    template <typename SampleType = float>
+    struct reportsCorrectLatency : Catch::Matchers::MatcherGenericBase
+    {
+        double tolerance;
+        double sampleRate;
+        int blockSize;
+        LatencyProbe probe;
+        int maxLatency;
+        mutable LatencyMeasurement measurement;
+
+        explicit reportsCorrectLatency (double toleranceInSamples = 0.5, double rate = 44100.0, int size = 512, LatencyProbe p = LatencyProbe::chirp, int maximum = 65536)
+            : tolerance (toleranceInSamples), sampleRate (rate), blockSize (size), probe (p), maxLatency (maximum) {}
+
+        [[nodiscard]] bool match (juce::AudioProcessor& processor) const
+        {
+            measurement = measureLatency<SampleType> (processor, sampleRate, blockSize, probe, maxLatency);
+            return std::abs (measurement.error()) <= tolerance;
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "reports the latency it has (within " << tolerance << " samples, looking for up to " << maxLatency << " samples of latency)\n"
+               << "Reported " << measurement.reported << " samples, measured " << measurement.measured << " samples";
+            return ss.str();
+        }
+    };
+}
@@ -0,0 +1,414 @@
+#pragma once
+
+namespace melatonin
+{
+    // A direct form II transposed biquad, run in double so low cutoffs at high sample rates stay accurate
+    struct LoudnessBiquad
+    {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+        double z1 = 0, z2 = 0;
+
+        double process (double x)
+        {
+            const auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    // 4x oversampled peak detection as described in BS.1770 Annex 2:
+    // a 64 tap windowed sinc split into 4 phases of 16 taps, one of which is the original sample
+    class TruePeakDetector
+    {
+    public:
+        static constexpr size_t factor = 4;
+        static constexpr size_t tapsPerPhase = 16;
+
+        TruePeakDetector()
+        {
+            constexpr auto centre = (double) (tapsPerPhase / 2 - 1);
+            for (size_t p = 0; p < factor; ++p)
+            {
+                double total = 0;
+                for (size_t k = 0; k < tapsPerPhase; ++k)
+                {
+                    // taps read history oldest first, so phase p sits p/4 of a sample after the centre tap
+                    const auto x = centre - (double) k + (double) p / factor;
+                    const auto sinc = std::abs (x) < 1e-9 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                    const auto position = (x + tapsPerPhase / 2.0) / (double) tapsPerPhase;
+                    const auto blackman = 0.42 - 0.5 * std::cos (juce::MathConstants<double>::twoPi * position) + 0.08 * std::cos (2.0 * juce::MathConstants<double>::twoPi * position);
+                    coefficients[p][k] = (float) (sinc * blackman);
+                    total += sinc * blackman;
+                }
+                for (auto& coefficient : coefficients[p])
+                    coefficient = (float) (coefficient / total);
+            }
+        }
+
+        // Returns the highest interpolated magnitude in data, carrying the history over to the next call.
+        // Works through data in chunks, so any block size runs without allocating.
+        template <typename SampleType>
+        float process (const SampleType* data, size_t numSamples)
+        {
+            float highest = 0;
+            for (size_t start = 0; start < numSamples; start += chunkSize)
+            {
+                const auto count = juce::jmin (chunkSize, numSamples - start);
+                for (size_t i = 0; i < count; ++i)
+                    scratch[tapsPerPhase + i] = (float) data[start + i];
+
+                for (size_t i = 0; i < count; ++i)
+                    highest = juce::jmax (highest, peakOf (scratch.data() + i + 1));
+
+                // the last tapsPerPhase samples become the history at the front
+                std::copy (scratch.begin() + (long) count, scratch.begin() + (long) (count + tapsPerPhase), scratch.begin());
+            }
+            return highest;
+        }
+
+        // The filter lags by tapsPerPhase / 2 samples, so the newest ones are only interpolated by the next process.
+        // Returns their highest interpolated magnitude as if the signal stopped here, leaving the history alone.
+        [[nodiscard]] float pendingPeak() const
+        {
+            constexpr auto lag = tapsPerPhase / 2;
+            std::array<float, tapsPerPhase + lag> padded {};
+            std::copy (scratch.begin(), scratch.begin() + (long) tapsPerPhase, padded.begin());
+
+            float highest = 0;
+            for (size_t i = 0; i < lag; ++i)
+                highest = juce::jmax (highest, peakOf (padded.data() + i + 1));
+            return highest;
+        }
+
+    private:
+        static constexpr size_t chunkSize = 1024;
+        std::array<std::array<float, tapsPerPhase>, factor> coefficients {};
+        std::vector<float> scratch = std::vector<float> (tapsPerPhase + chunkSize, 0.0f); // history, then the chunk
+
+        // the highest magnitude of the factor phases interpolated from tapsPerPhase samples, oldest first
+        [[nodiscard]] float peakOf (const float* window) const
+        {
+            float highest = 0;
+            for (size_t p = 0; p < factor; ++p)
+            {
+                float sum = 0;
+                for (size_t k = 0; k < tapsPerPhase; ++k)
+                    sum += coefficients[p][k] * window[k];
+                highest = juce::jmax (highest, std::abs (sum));
+            }
+            return highest;
+        }
+    };
+
+    // ITU-R BS.1770 / EBU R128 loudness, fed one block at a time.
+    // Only the 100ms energies of the render are kept, so memory grows by 8 bytes every 100ms (560KB for 2 hours).
+    //
+    //   LoudnessMeter meter (48000);
+    //   for (...)
+    //   {
+    //       processor.processBlock (buffer, midi);
+    //       meter.push (buffer);
+    //   }
+    //   REQUIRE_THAT (meter, hasIntegratedLoudness (-23.0, 0.5, 48000));
+    //   REQUIRE_THAT (meter, truePeakBelow (-1.0, 48000));
+    class LoudnessMeter
+    {
+    public:
+        static constexpr double silence = -400.0;
+
+        explicit LoudnessMeter (double rate) : sampleRate (rate)
+        {
+            samplesPerStep = (size_t) std::llround (sampleRate * 0.1);
+        }
+
+        // The defaults are 1.0 for every channel, or L R C LFE Ls Rs when there are 6
+        void setChannelWeights (std::vector<double> weights)
+        {
+            channelWeights = std::move (weights);
+        }
+
+        template <typename SampleType>
+        void push (const AudioBlock<SampleType>& block)
+        {
+            if (channels.empty())
+                prepare (block.getNumChannels());
+
+            // every push should have the same number of channels
+            jassert (block.getNumChannels() == channels.size());
+            const auto numChannels = juce::jmin (block.getNumChannels(), channels.size());
+
+            for (size_t c = 0; c < numChannels; ++c)
+                maxTruePeak = juce::jmax (maxTruePeak, channels[c].truePeak.process (block.getChannelPointer (c), block.getNumSamples()));
+
+            // filter and sum up to each 100ms boundary, then close that step
+            size_t start = 0;
+            while (start < block.getNumSamples())
+            {
+                const auto count = juce::jmin (block.getNumSamples() - start, samplesPerStep - samplesInStep);
+                for (size_t c = 0; c < numChannels; ++c)
+                {
+                    auto& channel = channels[c];
+                    const auto* data = block.getChannelPointer (c) + start;
+                    double sum = 0;
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        const auto weighted = channel.highPass.process (channel.shelf.process ((double) data[i]));
+                        sum += weighted * weighted;
+                    }
+                    stepEnergy += sum * channel.weight;
+                }
+
+                samplesInStep += count;
+                start += count;
+                if (samplesInStep == samplesPerStep)
+                    finishStep();
+            }
+            samplesSoFar += block.getNumSamples();
+        }
+
+        template <typename SampleType>
+        void push (const juce::AudioBuffer<SampleType>& buffer)
+        {
+            push (AudioBlock<SampleType> (const_cast<juce::AudioBuffer<SampleType>&> (buffer)));
+        }
+
+        [[nodiscard]] size_t getNumSamples() const { return samplesSoFar; }
+        [[nodiscard]] double getSampleRate() const { return sampleRate; }
+
+        // LUFS over the last 400ms
+        [[nodiscard]] double momentaryLoudness() const { return loudnessOfLast (4); }
+
+        // LUFS over the last 3s
+        [[nodiscard]] double shortTermLoudness() const { return loudnessOfLast (30); }
+
+        [[nodiscard]] double maxMomentaryLoudness() const { return maxMomentary; }
+        [[nodiscard]] double maxShortTermLoudness() const { return maxShortTerm; }
+
+        // LUFS over everything pushed, gated at -70 LUFS and then 10 LU below the loudness of what passed
+        [[nodiscard]] double integratedLoudness() const
+        {
+            const auto gatedMean = [this] (double gate) {
+                double total = 0;
+                size_t count = 0;
+                forEachGatingBlock ([&] (double energy) {
+                    if (energy > gate)
+                    {
+                        total += energy;
+                        ++count;
+                    }
+                });
+                return count > 0 ? total / (double) count : 0.0;
+            };
+
+            const auto absoluteGate = energyFor (-70.0);
+            const auto ungated = gatedMean (absoluteGate);
+            if (ungated <= 0)
+                return silence;
+
+            const auto relativeGate = energyFor (loudnessFor (ungated) - 10.0);
+            return loudnessFor (gatedMean (juce::jmax (absoluteGate, relativeGate)));
+        }
+
+        // Includes the newest samples the oversampling filter hasn't reached yet, as if the render ended here
+        [[nodiscard]] double truePeak() const
+        {
+            auto highest = maxTruePeak;
+            for (const auto& channel : channels)
+                highest = juce::jmax (highest, channel.truePeak.pendingPeak());
+            return highest;
+        }
+
+        [[nodiscard]] double truePeakInDB() const { return juce::Decibels::gainToDecibels (truePeak(), silence); }
+
+    private:
+        struct ChannelState
+        {
+            LoudnessBiquad shelf;
+            LoudnessBiquad highPass;
+            TruePeakDetector truePeak;
+            double weight = 1.0;
+        };
+
+        double sampleRate;
+        size_t samplesPerStep;
+        std::vector<double> channelWeights;
+        std::vector<ChannelState> channels;
+        std::vector<double> stepEnergies; // mean square of every 100ms step, already weighted
+        double stepEnergy = 0;
+        size_t samplesInStep = 0;
+        size_t samplesSoFar = 0;
+        double maxMomentary = silence;
+        double maxShortTerm = silence;
+        float maxTruePeak = 0;
+
+        static double loudnessFor (double energy) { return energy > 0 ? -0.691 + 10.0 * std::log10 (energy) : silence; }
+        static double energyFor (double loudness) { return std::pow (10.0, (loudness + 0.691) / 10.0); }
+
+        void prepare (size_t numChannels)
+        {
+            channels.resize (numChannels);
+
+            // The K-weighting filters, from their analog prototypes so any sample rate works
+            // (at 48kHz these are the coefficients printed in BS.1770)
+            {
+                const auto gain = 3.999843853973347, frequency = 1681.974450955533, q = 0.7071752369554196;
+                const auto k = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+                const auto vh = std::pow (10.0, gain / 20.0);
+                const auto vb = std::pow (vh, 0.4996667741545416);
+                const auto a0 = 1.0 + k / q + k * k;
+                for (auto& channel : channels)
+                {
+                    channel.shelf.b0 = (vh + vb * k / q + k * k) / a0;
+                    channel.shelf.b1 = 2.0 * (k * k - vh) / a0;
+                    channel.shelf.b2 = (vh - vb * k / q + k * k) / a0;
+                    channel.shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+                    channel.shelf.a2 = (1.0 - k / q + k * k) / a0;
+                }
+            }
+            {
+                const auto frequency = 38.13547087602444, q = 0.5003270373238773;
+                const auto k = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+                const auto a0 = 1.0 + k / q + k * k;
+                for (auto& channel : channels)
+                {
+                    channel.highPass.b0 = 1.0;
+                    channel.highPass.b1 = -2.0;
+                    channel.highPass.b2 = 1.0;
+                    channel.highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+                    channel.highPass.a2 = (1.0 - k / q + k * k) / a0;
+                }
+            }
+
+            auto weights = channelWeights;
+            if (weights.empty() && numChannels == 6)
+                weights = { 1.0, 1.0, 1.0, 0.0, 1.41, 1.41 };
+            for (size_t c = 0; c < numChannels; ++c)
+                channels[c].weight = c < weights.size() ? weights[c] : 1.0;
+        }
+
+        void finishStep()
+        {
+            stepEnergies.push_back (stepEnergy / (double) samplesPerStep);
+            stepEnergy = 0;
+            samplesInStep = 0;
+
+            if (stepEnergies.size() >= 4)
+                maxMomentary = juce::jmax (maxMomentary, loudnessFor (meanOfLast (4)));
+            if (stepEnergies.size() >= 30)
+                maxShortTerm = juce::jmax (maxShortTerm, loudnessFor (meanOfLast (30)));
+        }
+
+        [[nodiscard]] double meanOfLast (size_t numSteps) const
+        {
+            numSteps = juce::jmin (numSteps, stepEnergies.size());
+            if (numSteps == 0)
+                return 0;
+            const auto total = std::accumulate (stepEnergies.end() - (long) numSteps, stepEnergies.end(), 0.0);
+            return total / (double) numSteps;
+        }
+
+        // Every 400ms gating block, overlapping by 75%, from a running sum of 4 steps
+        template <typename Function>
+        void forEachGatingBlock (Function&& function) const
+        {
+            double sum = 0;
+            for (size_t i = 0; i < stepEnergies.size(); ++i)
+            {
+                sum += stepEnergies[i];
+                if (i >= 4)
+                    sum -= stepEnergies[i - 4];
+                if (i >= 3)
+                    function (sum / 4.0);
+            }
+        }
+
+        [[nodiscard]] double loudnessOfLast (size_t numSteps) const
+        {
+            return stepEnergies.size() >= numSteps ? loudnessFor (meanOfLast (numSteps)) : silence;
+        }
+    };
+
+    // Integrated loudness in LUFS, within tolerance LU
+    //
+    //   REQUIRE_THAT (output, hasIntegratedLoudness (-23.0, 0.5, sampleRate));
+    struct hasIntegratedLoudness : Catch::Matchers::MatcherGenericBase
+    {
+        double target;
+        double tolerance;
+        double sampleRate;
+        mutable double measured = LoudnessMeter::silence;
+
+        // The sample rate sets up the K-weighting for blocks and buffers. A LoudnessMeter brings its own.
+        hasIntegratedLoudness (double lufs, double lu, double rate)
+            : target (lufs), tolerance (lu), sampleRate (rate) {}
+
+        [[nodiscard]] bool match (const LoudnessMeter& meter) const
+        {
+            measured = meter.integratedLoudness();
+            return std::abs (measured - target) <= tolerance;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            LoudnessMeter meter (sampleRate);
+            meter.push (block);
+            return match (meter);
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has an integrated loudness of " << target << " LUFS (within " << tolerance << " LU)\n"
+               << "Integrated loudness is " << measured << " LUFS";
+            return ss.str();
+        }
+    };
+
+    // 4x oversampled true peak, in dBTP
+    //
+    //   REQUIRE_THAT (limiterOutput, truePeakBelow (-1.0, sampleRate));
+    struct truePeakBelow : Catch::Matchers::MatcherGenericBase
+    {
+        double threshold;
+        double sampleRate;
+        mutable double measured = LoudnessMeter::silence;
+
+        truePeakBelow (double dBTP, double rate) : threshold (dBTP), sampleRate (rate) {}
+
+        [[nodiscard]] bool match (const LoudnessMeter& meter) const
+        {
+            measured = meter.truePeakInDB();
+            return measured < threshold;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            LoudnessMeter meter (sampleRate);
+            meter.push (block);
+            return match (meter);
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has a true peak below " << threshold << " dBTP\n"
+               << "True peak is " << measured << " dBTP";
+            return ss.str();
+        }
+    };
+}
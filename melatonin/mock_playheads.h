@@ -34,10 +34,25 @@ namespace melatonin
             info.setIsPlaying (isPlaying);
         }
 
+        void setSampleRate (double newSampleRate)
+        {
+            sampleRate = newSampleRate;
+        }
+
         void advancePosition (size_t numSamples)
         {
-            auto samplesPerBeat = 44100.f * 60.f / info.getBpm().orFallback (120.f);
-            info.setPpqPosition (info.getPpqPosition().orFallback(0) + (float) numSamples / samplesPerBeat);
+            auto samplesPerBeat = sampleRate * 60.0 / info.getBpm().orFallback (120.0);
+            info.setPpqPosition (info.getPpqPosition().orFallback (0) + (double) numSamples / samplesPerBeat);
+            info.setTimeInSamples (info.getTimeInSamples().orFallback (0) + (juce::int64) numSamples);
+            info.setTimeInSeconds ((double) *info.getTimeInSamples() / sampleRate);
+        }
+
+        // back to the start of the timeline
+        void resetPosition()
+        {
+            info.setPpqPosition (0);
+            info.setTimeInSamples (0);
+            info.setTimeInSeconds (0);
         }
 
     private:
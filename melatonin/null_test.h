@@ -0,0 +1,308 @@
+#pragma once
+
+namespace melatonin
+{
+    // What's left after lining a signal up with a reference and subtracting it
+    struct NullTestResult
+    {
+        double latency = 0; // in samples, positive when the signal lags the reference
+        size_t numComparedSamples = 0;
+        double residualRMS = 0;
+        double residualPeak = 0;
+
+        [[nodiscard]] double residualRMSInDB() const { return juce::Decibels::gainToDecibels (residualRMS, -400.0); }
+        [[nodiscard]] double residualPeakInDB() const { return juce::Decibels::gainToDecibels (residualPeak, -400.0); }
+    };
+
+    // The cross-correlation spectrum of signal against reference, summed over channels.
+    // Only the non-negative frequencies, the rest are the complex conjugates.
+    template <typename SampleType>
+    static inline std::vector<std::complex<double>> crossSpectrum (const AudioBlock<const SampleType>& signal, const AudioBlock<const SampleType>& reference, int order)
+    {
+        const auto fftSize = (size_t) 1 << order;
+        auto engine = FFTPlanCache::getInstance().getEngine (order);
+        std::vector<float> signalData (fftSize * 2), referenceData (fftSize * 2);
+        std::vector<std::complex<double>> spectrum (fftSize / 2 + 1);
+
+        for (size_t c = 0; c < juce::jmin (signal.getNumChannels(), reference.getNumChannels()); ++c)
+        {
+            copyForFFT (signalData.data(), signal.getChannelPointer (c), signal.getNumSamples(), fftSize);
+            copyForFFT (referenceData.data(), reference.getChannelPointer (c), reference.getNumSamples(), fftSize);
+            engine->performRealOnlyForwardTransform (signalData.data(), true);
+            engine->performRealOnlyForwardTransform (referenceData.data(), true);
+
+            for (size_t k = 0; k < spectrum.size(); ++k)
+            {
+                const auto s = std::complex<double> (signalData[2 * k], signalData[2 * k + 1]);
+                const auto r = std::complex<double> (referenceData[2 * k], referenceData[2 * k + 1]);
+                spectrum[k] += s * std::conj (r);
+            }
+        }
+        return spectrum;
+    }
+
+    // Evaluates the (band limited) cross-correlation at a fractional lag straight from its spectrum
+    static inline double correlationAtLag (const std::vector<std::complex<double>>& spectrum, double lag)
+    {
+        const auto fftSize = (double) (spectrum.size() - 1) * 2;
+        const auto angle = juce::MathConstants<double>::twoPi * lag / fftSize;
+        const auto rotation = std::polar (1.0, angle);
+        auto phasor = rotation;
+
+        auto total = spectrum.front().real() + (spectrum.back() * std::polar (1.0, juce::MathConstants<double>::pi * lag)).real();
+        for (size_t k = 1; k + 1 < spectrum.size(); ++k)
+        {
+            total += 2.0 * (spectrum[k] * phasor).real();
+
+            // stop rounding errors from building up in the rotating phasor
+            if (k % 4096 == 0)
+                phasor = std::polar (1.0, angle * (double) (k + 1));
+            else
+                phasor *= rotation;
+        }
+        return total;
+    }
+
+    // The lag between two whole blocks. The integer lag is the peak of the FFT cross-correlation,
+    // which is then refined by searching the band limited correlation either side of it.
+    // The transform covers both blocks end to end, so keep them short (estimateLatency does).
+    template <typename SampleType>
+    static inline double estimateLatencyOfWindow (const AudioBlock<const SampleType>& signal, const AudioBlock<const SampleType>& reference)
+    {
+        const auto numSignal = signal.getNumSamples();
+        const auto numReference = reference.getNumSamples();
+        if (numSignal == 0 || numReference == 0)
+            return 0;
+
+        // big enough that the circular correlation doesn't wrap around onto itself
+        const auto order = juce::jmax (1, (int) std::ceil (std::log2 ((double) (numSignal + numReference))));
+        const auto fftSize = (size_t) 1 << order;
+        const auto spectrum = crossSpectrum (signal, reference, order);
+
+        std::vector<float> correlation (fftSize * 2);
+        for (size_t k = 0; k < spectrum.size(); ++k)
+        {
+            correlation[2 * k] = (float) spectrum[k].real();
+            correlation[2 * k + 1] = (float) spectrum[k].imag();
+        }
+        for (size_t k = spectrum.size(); k < fftSize; ++k)
+        {
+            correlation[2 * k] = (float) spectrum[fftSize - k].real();
+            correlation[2 * k + 1] = (float) -spectrum[fftSize - k].imag();
+        }
+        FFTPlanCache::getInstance().getEngine (order)->performRealOnlyInverseTransform (correlation.data());
+
+        // positive lags are at the start, negative lags wrap around to the end
+        auto bestLag = 0.0;
+        auto bestValue = -std::numeric_limits<float>::infinity();
+        for (size_t m = 0; m < fftSize; ++m)
+        {
+            const bool isPositive = m < numSignal;
+            const bool isNegative = m > fftSize - numReference;
+            if ((isPositive || isNegative) && correlation[m] > bestValue)
+            {
+                bestValue = correlation[m];
+                bestLag = isPositive ? (double) m : (double) m - (double) fftSize;
+            }
+        }
+
+        // golden section search for the true peak, which is within a sample of the integer one
+        const auto ratio = (std::sqrt (5.0) - 1.0) / 2.0;
+        auto low = bestLag - 1.0, high = bestLag + 1.0;
+        auto a = high - ratio * (high - low), b = low + ratio * (high - low);
+        auto valueA = correlationAtLag (spectrum, a), valueB = correlationAtLag (spectrum, b);
+        while (high - low > 1e-6)
+        {
+            if (valueA > valueB)
+            {
+                high = b;
+                b = a;
+                valueB = valueA;
+                a = high - ratio * (high - low);
+                valueA = correlationAtLag (spectrum, a);
+            }
+            else
+            {
+                low = a;
+                a = b;
+                valueA = valueB;
+                b = low + ratio * (high - low);
+                valueB = correlationAtLag (spectrum, b);
+            }
+        }
+        return (low + high) / 2.0;
+    }
+
+    // How many samples signal lags reference by (negative when it leads), to a fraction of a sample.
+    // Only lags up to maxLag either way are looked for.
+    //
+    // Correlating two whole 10 minute renders would take a 2^25 point transform and gigabytes of memory,
+    // so only a segment of the reference (from its first sound) is correlated against the part of the
+    // signal it could line up with. The transform stays the same size however long the audio is.
+    template <typename SampleType>
+    static inline double estimateLatency (const AudioBlock<const SampleType>& signal, const AudioBlock<const SampleType>& reference, size_t maxLag = 65536)
+    {
+        constexpr size_t segmentLength = 65536;
+        constexpr int maxOrder = 22;
+        maxLag = juce::jmin (maxLag, ((size_t) 1 << (maxOrder - 1)) - segmentLength);
+
+        const auto numReference = reference.getNumSamples();
+        auto segmentStart = numReference;
+        for (size_t c = 0; c < reference.getNumChannels(); ++c)
+            segmentStart = juce::jmin (segmentStart, findFirstNonZeroSample (reference.getChannelPointer (c), juce::jmin (segmentStart, numReference)));
+        if (segmentStart == numReference)
+            segmentStart = 0; // silence, nothing to line up
+
+        const auto segmentEnd = juce::jmin (numReference, segmentStart + segmentLength);
+        const auto windowStart = segmentStart > maxLag ? segmentStart - maxLag : 0;
+        const auto windowEnd = juce::jmin (signal.getNumSamples(), segmentEnd + maxLag);
+        if (segmentStart >= segmentEnd || windowStart >= windowEnd)
+            return 0;
+
+        const auto lag = estimateLatencyOfWindow (signal.getSubBlock (windowStart, windowEnd - windowStart),
+            reference.getSubBlock (segmentStart, segmentEnd - segmentStart));
+        return lag + (double) windowStart - (double) segmentStart;
+    }
+
+    // Shifts signal back by latency (with a windowed sinc for any fractional part),
+    // subtracts the reference and measures what's left where the two overlap.
+    // The signal is treated as silent before its first sample.
+    template <typename SampleType>
+    static inline NullTestResult nullResidual (const AudioBlock<const SampleType>& signal, const AudioBlock<const SampleType>& reference, double latency)
+    {
+        constexpr int halfWidth = 32;
+        const auto whole = (long long) std::floor (latency);
+        const auto fraction = latency - (double) whole;
+        const bool interpolate = fraction > 1e-9;
+
+        // taps read signal[i + j] for j in (-halfWidth, halfWidth]
+        double taps[2 * halfWidth] = {};
+        if (interpolate)
+        {
+            double total = 0;
+            for (int j = -halfWidth + 1; j <= halfWidth; ++j)
+            {
+                const auto x = (double) j - fraction;
+                const auto sinc = std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                const auto phase = juce::MathConstants<double>::pi * x / halfWidth;
+                const auto blackman = 0.42 + 0.5 * std::cos (phase) + 0.08 * std::cos (2.0 * phase);
+                taps[j + halfWidth - 1] = sinc * blackman;
+                total += sinc * blackman;
+            }
+            for (auto& tap : taps)
+                tap /= total;
+        }
+
+        NullTestResult result;
+        result.latency = latency;
+
+        const auto numSignal = (long long) signal.getNumSamples();
+        const auto start = juce::jmax (0LL, -whole);
+        const auto end = juce::jmin ((long long) reference.getNumSamples(), numSignal - whole - (interpolate ? halfWidth : 0));
+        if (end <= start)
+            return result;
+
+        double sumOfSquares = 0;
+        const auto numChannels = juce::jmin (signal.getNumChannels(), reference.getNumChannels());
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            const auto* s = signal.getChannelPointer (c);
+            const auto* r = reference.getChannelPointer (c);
+            for (auto n = start; n < end; ++n)
+            {
+                const auto i = n + whole;
+                double aligned = 0;
+                if (!interpolate)
+                    aligned = (double) s[i];
+                else
+                    for (int j = -halfWidth + 1; j <= halfWidth; ++j)
+                        aligned += i + j >= 0 ? taps[j + halfWidth - 1] * (double) s[i + j] : 0.0;
+
+                const auto difference = aligned - (double) r[n];
+                sumOfSquares += difference * difference;
+                result.residualPeak = juce::jmax (result.residualPeak, std::abs (difference));
+            }
+        }
+
+        result.numComparedSamples = (size_t) (end - start);
+        result.residualRMS = std::sqrt (sumOfSquares / (double) (result.numComparedSamples * juce::jmax ((size_t) 1, numChannels)));
+        return result;
+    }
+
+    // Lines signal up with reference and subtracts them. When the latency is a whole number of samples
+    // (or close enough that shifting doesn't help) no interpolation is done, so identical audio nulls perfectly.
+    template <typename SampleType>
+    static inline NullTestResult nullTest (const AudioBlock<const SampleType>& signal, const AudioBlock<const SampleType>& reference)
+    {
+        const auto latency = estimateLatency (signal, reference);
+        const auto wholeSamples = nullResidual (signal, reference, std::round (latency));
+        const auto fractional = nullResidual (signal, reference, latency);
+
+        // only worth interpolating when it actually helps
+        if (fractional.numComparedSamples > 0 && fractional.residualRMS < wholeSamples.residualRMS * 0.99)
+            return fractional;
+        return wholeSamples;
+    }
+
+    // Passes when the signal, once lined up with the reference, cancels it out to below the threshold (RMS, in dBFS).
+    // Handy for processors with latency, oversampling or lookahead, where isEqualTo would fail on the shift:
+    //
+    //   REQUIRE_THAT (processedBuffer, nullsAgainst (referenceBuffer, -90.0));
+    template <typename SampleType>
+    struct nullsAgainst : Catch::Matchers::MatcherGenericBase
+    {
+        AudioBlock<const SampleType> reference;
+        double threshold;
+        mutable NullTestResult result;
+        mutable std::string problem = "";
+
+        explicit nullsAgainst (const AudioBlock<const SampleType>& r, double dBThreshold = -100.0)
+            : reference (r), threshold (dBThreshold) {}
+
+        explicit nullsAgainst (const AudioBlock<SampleType>& r, double dBThreshold = -100.0)
+            : nullsAgainst (AudioBlock<const SampleType> (r), dBThreshold) {}
+
+        explicit nullsAgainst (juce::AudioBuffer<SampleType>& r, double dBThreshold = -100.0)
+            : nullsAgainst (AudioBlock<SampleType> (r), dBThreshold) {}
+
+        [[nodiscard]] bool match (const AudioBlock<const SampleType>& block) const
+        {
+            problem.clear();
+            if (block.getNumChannels() != reference.getNumChannels())
+            {
+                problem = "has " + std::to_string (block.getNumChannels()) + " channels, the reference has " + std::to_string (reference.getNumChannels());
+                return false;
+            }
+
+            result = nullTest (block, reference);
+            if (result.numComparedSamples == 0)
+            {
+                problem = "doesn't overlap the reference at all once aligned";
+                return false;
+            }
+            return result.residualRMSInDB() <= threshold;
+        }
+
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            return match (AudioBlock<const SampleType> (block));
+        }
+
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "nulls against the reference to below " << threshold << " dB\n";
+            if (!problem.empty())
+                ss << problem;
+            else
+                ss << "Residual is " << result.residualRMSInDB() << " dB RMS (peak " << result.residualPeakInDB() << " dB) after aligning by "
+                   << result.latency << " samples over " << result.numComparedSamples << " samples";
+            return ss.str();
+        }
+    };
+}
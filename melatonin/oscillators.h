@@ -0,0 +1,175 @@
+#pragma once
+
+namespace melatonin
+{
+    enum class Waveform {
+        sine,
+        cosine,
+        saw,
+        square,
+        noise
+    };
+
+    // Generates test signals into blocks, carrying the phase over from one block to the next.
+    // This lets you stream a long continuous signal into a processor a processBlock at a time:
+    //
+    //   auto osc = Oscillator<float> (440.f, 48000.f);
+    //   for (...)
+    //       osc.renderSine (block); // continues where the last block left off
+    //
+    // Every channel receives the same signal.
+    template <typename SampleType>
+    class Oscillator
+    {
+    public:
+        Oscillator (float frequency, float rate, float g = 1.0f) : sampleRate (rate), gain (g)
+        {
+            setFrequency (frequency);
+        }
+
+        void setFrequency (float frequency)
+        {
+            increment = juce::MathConstants<double>::twoPi * (double) frequency / (double) sampleRate;
+        }
+
+        void setGain (float g) { gain = g; }
+
+        // phase is in radians, between -pi and pi
+        void reset (double newPhase = 0.0) { phase = wrap (newPhase); }
+        [[nodiscard]] double getPhase() const { return phase; }
+
+        // Calls function (angle) for every sample, where angle is in radians between -pi and pi
+        // Any callable works and gets inlined, no std::function involved
+        template <typename Function>
+        AudioBlock<SampleType>& render (AudioBlock<SampleType>& block, Function&& function, bool accumulate = false)
+        {
+            return renderSegments (block, accumulate, [&] (SampleType* values, size_t count, double startPhase) {
+                for (size_t i = 0; i < count; ++i)
+                    values[i] = (SampleType) (gain * function ((float) wrap (startPhase + (double) i * increment)));
+            });
+        }
+
+        AudioBlock<SampleType>& renderSine (AudioBlock<SampleType>& block, bool accumulate = false)
+        {
+            return renderRotating (block, accumulate, false);
+        }
+
+        AudioBlock<SampleType>& renderCosine (AudioBlock<SampleType>& block, bool accumulate = false)
+        {
+            return renderRotating (block, accumulate, true);
+        }
+
+        // naive (not band limited) saw, rising from -1 to 1
+        AudioBlock<SampleType>& renderSaw (AudioBlock<SampleType>& block, bool accumulate = false)
+        {
+            return render (block, [] (float angle) { return angle / juce::MathConstants<float>::pi; }, accumulate);
+        }
+
+        // naive (not band limited) square, in phase with the sine
+        AudioBlock<SampleType>& renderSquare (AudioBlock<SampleType>& block, bool accumulate = false)
+        {
+            return render (block, [] (float angle) { return angle >= 0 ? 1.0f : -1.0f; }, accumulate);
+        }
+
+        // uniform white noise between -gain and gain, repeatable for a given seed
+        AudioBlock<SampleType>& renderNoise (AudioBlock<SampleType>& block, bool accumulate = false)
+        {
+            return renderSegments (block, accumulate, [&] (SampleType* values, size_t count, double) {
+                for (size_t i = 0; i < count; ++i)
+                    values[i] = (SampleType) (gain * (random.nextFloat() * 2.0f - 1.0f));
+            });
+        }
+
+        void setNoiseSeed (juce::int64 seed) { random.setSeed (seed); }
+
+        AudioBlock<SampleType>& render (AudioBlock<SampleType>& block, Waveform waveform, bool accumulate = false)
+        {
+            switch (waveform)
+            {
+                case Waveform::sine:
+                    return renderSine (block, accumulate);
+                case Waveform::cosine:
+                    return renderCosine (block, accumulate);
+                case Waveform::saw:
+                    return renderSaw (block, accumulate);
+                case Waveform::square:
+                    return renderSquare (block, accumulate);
+                case Waveform::noise:
+                    return renderNoise (block, accumulate);
+            }
+            return block;
+        }
+
+    private:
+        static constexpr size_t chunkSize = 256;
+        float sampleRate;
+        float gain;
+        double increment = 0;
+        double phase = 0;
+        juce::Random random { 1 };
+
+        static double wrap (double angle)
+        {
+            constexpr auto pi = juce::MathConstants<double>::pi;
+            constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+            return angle - twoPi * std::floor ((angle + pi) / twoPi);
+        }
+
+        // Generates a chunk at a time into a small stack buffer, then writes (or adds) it to every channel
+        template <typename Generator>
+        AudioBlock<SampleType>& renderSegments (AudioBlock<SampleType>& block, bool accumulate, Generator&& generate)
+        {
+            SampleType values[chunkSize];
+            const auto numSamples = block.getNumSamples();
+
+            for (size_t start = 0; start < numSamples; start += chunkSize)
+            {
+                const auto count = juce::jmin (chunkSize, numSamples - start);
+                generate (values, count, phase);
+                phase = wrap (phase + (double) count * increment);
+
+                for (size_t c = 0; c < block.getNumChannels(); ++c)
+                {
+                    auto channel = block.getChannelPointer (c) + start;
+                    if (accumulate)
+                        juce::FloatVectorOperations::add (channel, values, (int) count);
+                    else
+                        juce::FloatVectorOperations::copy (channel, values, (int) count);
+                }
+            }
+            return block;
+        }
+
+        // Sine and cosine without calling sin per sample: each lane is a unit phasor rotated by
+        // lanes * increment per step, so every step is a handful of independent multiply-adds.
+        // The phasors are reseeded from the exact phase every chunk so error can't build up.
+        AudioBlock<SampleType>& renderRotating (AudioBlock<SampleType>& block, bool accumulate, bool cosine)
+        {
+            constexpr size_t lanes = 8;
+            const auto stepReal = std::cos ((double) lanes * increment);
+            const auto stepImaginary = std::sin ((double) lanes * increment);
+
+            return renderSegments (block, accumulate, [&] (SampleType* values, size_t count, double startPhase) {
+                double real[lanes], imaginary[lanes];
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    real[lane] = std::cos (startPhase + (double) lane * increment);
+                    imaginary[lane] = std::sin (startPhase + (double) lane * increment);
+                }
+
+                for (size_t i = 0; i < count; i += lanes)
+                {
+                    SampleType chunk[lanes];
+                    for (size_t lane = 0; lane < lanes; ++lane)
+                    {
+                        chunk[lane] = (SampleType) (gain * (cosine ? real[lane] : imaginary[lane]));
+                        const auto r = real[lane] * stepReal - imaginary[lane] * stepImaginary;
+                        imaginary[lane] = imaginary[lane] * stepReal + real[lane] * stepImaginary;
+                        real[lane] = r;
+                    }
+                    std::copy (chunk, chunk + juce::jmin (lanes, count - i), values + i);
+                }
+            });
+        }
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+namespace melatonin
+{
+    // Shared by the analyzers that split their work across cores
+    static inline juce::ThreadPool& analysisThreadPool()
+    {
+        static juce::ThreadPool pool (juce::jmax (1, juce::SystemStats::getNumCpus() - 1));
+        return pool;
+    }
+
+    // Splits [0, numItems) into contiguous ranges and calls function (begin, end) for each range
+    // on the analysis pool, using the calling thread for one of them. Blocks until every range is done.
+    // Runs serially when called from a pool thread, so nested calls can't deadlock the pool.
+    //
+    // If function throws, every range still finishes (or throws) before the first exception
+    // is rethrown on the calling thread, so nothing is left referring to this stack frame.
+    template <typename Function>
+    static inline void parallelFor (size_t numItems, Function&& function, size_t minItemsPerJob = 1)
+    {
+        if (numItems == 0)
+            return;
+
+        auto& pool = analysisThreadPool();
+        const auto maxJobs = (size_t) pool.getNumThreads() + 1;
+        const auto numJobs = juce::jlimit<size_t> (1, maxJobs, numItems / juce::jmax<size_t> (1, minItemsPerJob));
+
+        if (numJobs == 1 || juce::ThreadPoolJob::getCurrentThreadPoolJob() != nullptr)
+        {
+            function ((size_t) 0, numItems);
+            return;
+        }
+
+        auto rangeStart = [=] (size_t job) { return numItems * job / numJobs; };
+
+        std::mutex exceptionLock;
+        std::exception_ptr firstException;
+        auto runRange = [&] (size_t job) {
+            try
+            {
+                function (rangeStart (job), rangeStart (job + 1));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock (exceptionLock);
+                if (firstException == nullptr)
+                    firstException = std::current_exception();
+            }
+        };
+
+        std::atomic<size_t> remaining { numJobs - 1 };
+        juce::WaitableEvent finished;
+        for (size_t job = 1; job < numJobs; ++job)
+        {
+            pool.addJob ([&, job] {
+                runRange (job);
+                if (--remaining == 0)
+                    finished.signal();
+            });
+        }
+
+        runRange (0);
+        finished.wait();
+
+        if (firstException != nullptr)
+            std::rethrow_exception (firstException);
+    }
+
+    // Calls function (index) for every index in [0, numItems) on the analysis pool.
+    // Indexes are handed out one at a time to whichever thread is free, so a few slow items
+    // don't leave the other threads idle. Blocks until every item is done.
+    //
+    // Once function throws, no more items are started. The ones already running finish,
+    // then the first exception is rethrown on the calling thread.
+    template <typename Function>
+    static inline void parallelForEach (size_t numItems, Function&& function)
+    {
+        std::atomic<size_t> next { 0 };
+        const auto numWorkers = juce::jmin (numItems, (size_t) analysisThreadPool().getNumThreads() + 1);
+        parallelFor (numWorkers, [&] (size_t, size_t) {
+            for (auto index = next++; index < numItems; index = next++)
+            {
+                try
+                {
+                    function (index);
+                }
+                catch (...)
+                {
+                    next = numItems;
+                    throw;
+                }
+            }
+        });
+    }
+}
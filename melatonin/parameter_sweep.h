@@ -0,0 +1,307 @@
+#pragma once
+
+namespace melatonin
+{
+    // What one grid point of a ParameterSweep rendered
+    struct SweepResult
+    {
+        double sampleRate = 0;
+        int blockSize = 0;
+        std::vector<float> parameterValues; // in the order the parameters were added to the sweep
+        double rms = 0;
+        double peak = 0;
+        bool valid = true;
+        double realtimeFactor = 0;
+        size_t realtimeViolations = 0;
+        double measurement = 0; // whatever ParameterSweep::measure returned
+    };
+
+    // Every grid point of a sweep, in grid order (sample rates vary slowest, the last parameter fastest)
+    class SweepResults
+    {
+    public:
+        SweepResults() = default;
+        SweepResults (std::vector<juce::String> ids, size_t size) : parameterIDs (std::move (ids)), results (size) {}
+
+        [[nodiscard]] size_t size() const { return results.size(); }
+        [[nodiscard]] SweepResult& operator[] (size_t index) { return results[index]; }
+        [[nodiscard]] const SweepResult& operator[] (size_t index) const { return results[index]; }
+        [[nodiscard]] auto begin() const { return results.begin(); }
+        [[nodiscard]] auto end() const { return results.end(); }
+
+        [[nodiscard]] const std::vector<juce::String>& getParameterIDs() const { return parameterIDs; }
+
+        [[nodiscard]] size_t indexOfParameter (const juce::String& parameterID) const
+        {
+            auto found = std::find (parameterIDs.begin(), parameterIDs.end(), parameterID);
+
+            // this parameter isn't part of the sweep
+            jassert (found != parameterIDs.end());
+            return (size_t) std::distance (parameterIDs.begin(), found);
+        }
+
+        [[nodiscard]] float valueOf (size_t index, const juce::String& parameterID) const
+        {
+            return results[index].parameterValues[indexOfParameter (parameterID)];
+        }
+
+        // the first point that rendered invalid audio, if any
+        [[nodiscard]] std::optional<size_t> firstInvalidPoint() const
+        {
+            for (size_t i = 0; i < results.size(); ++i)
+                if (!results[i].valid)
+                    return i;
+            return std::nullopt;
+        }
+
+        [[nodiscard]] bool allValid() const { return !firstInvalidPoint().has_value(); }
+
+        // Groups points that only differ in this parameter, each group ordered by its value.
+        // Good for asking how something changes with one parameter at every other setting.
+        [[nodiscard]] std::vector<std::vector<size_t>> seriesAlong (const juce::String& parameterID) const
+        {
+            const auto along = indexOfParameter (parameterID);
+            auto everythingElse = [&] (const SweepResult& result) {
+                auto values = result.parameterValues;
+                values.erase (values.begin() + (std::ptrdiff_t) along);
+                return std::make_tuple (result.sampleRate, result.blockSize, values);
+            };
+
+            std::map<decltype (everythingElse (results[0])), std::vector<size_t>> groups;
+            for (size_t i = 0; i < results.size(); ++i)
+                groups[everythingElse (results[i])].push_back (i);
+
+            std::vector<std::vector<size_t>> series;
+            for (auto& [key, indexes] : groups)
+            {
+                std::sort (indexes.begin(), indexes.end(), [&] (size_t a, size_t b) {
+                    return results[a].parameterValues[along] < results[b].parameterValues[along];
+                });
+                series.push_back (std::move (indexes));
+            }
+            return series;
+        }
+
+        [[nodiscard]] std::string describePoint (size_t index) const
+        {
+            auto& result = results[index];
+            std::ostringstream ss;
+            ss << result.sampleRate << "Hz, " << result.blockSize << " samples";
+            for (size_t p = 0; p < parameterIDs.size(); ++p)
+                ss << ", " << parameterIDs[p].toStdString() << "=" << result.parameterValues[p];
+            return ss.str();
+        }
+
+    private:
+        std::vector<juce::String> parameterIDs;
+        std::vector<SweepResult> results;
+    };
+
+    // Renders a processor at every combination of sample rate, block size and parameter value,
+    // each on its own processor instance, concurrently on the analysis thread pool.
+    //
+    //   auto results = ParameterSweep ([] { return std::make_unique<MyProcessor>(); })
+    //                      .sampleRates ({ 44100, 48000, 96000 })
+    //                      .blockSizes ({ 32, 512 })
+    //                      .parameter ("gain", { -24.f, -12.f, 0.f })
+    //                      .input ([] (auto& block, double rate) { fillWithSine (block, 440.f, (float) rate); })
+    //                      .run (1.0);
+    //   REQUIRE (results.allValid());
+    //   REQUIRE_THAT (results, isMonotonicWith ("gain"));
+    //
+    // The factory is called (and parameters are set) on the calling thread, since JUCE likes processors
+    // to be built on the message thread. Only input, prepareToPlay, the render and measure run concurrently.
+    // Catch's assertions aren't thread safe, so don't REQUIRE or CHECK inside input or measure:
+    // store what you need in the measurement and assert on the results. If anything throws on a pool
+    // thread, the sweep stops starting new points and run rethrows the first exception.
+    template <typename SampleType = float>
+    class ParameterSweep
+    {
+    public:
+        using Factory = std::function<std::unique_ptr<juce::AudioProcessor>()>;
+        using InputFunction = std::function<void (AudioBlock<SampleType>&, double sampleRate)>;
+        using MeasureFunction = std::function<double (juce::AudioBuffer<SampleType>&, const SweepResult&)>;
+
+        explicit ParameterSweep (Factory f) : factory (std::move (f)) {}
+
+        ParameterSweep& sampleRates (std::vector<double> rates)
+        {
+            rateValues = std::move (rates);
+            return *this;
+        }
+
+        ParameterSweep& blockSizes (std::vector<int> sizes)
+        {
+            blockSizeValues = std::move (sizes);
+            return *this;
+        }
+
+        // values are in the parameter's own range (e.g. dB, not 0-1)
+        ParameterSweep& parameter (const juce::String& parameterID, std::vector<float> values)
+        {
+            jassert (!values.empty());
+            parameterIDs.push_back (parameterID);
+            parameterValues.push_back (std::move (values));
+            return *this;
+        }
+
+        // fills the input for each point, otherwise the processors render silence
+        ParameterSweep& input (InputFunction function)
+        {
+            inputFunction = std::move (function);
+            return *this;
+        }
+
+        // computes SweepResult::measurement from each point's output
+        ParameterSweep& measure (MeasureFunction function)
+        {
+            measureFunction = std::move (function);
+            return *this;
+        }
+
+        [[nodiscard]] size_t getNumPoints() const
+        {
+            auto total = rateValues.size() * blockSizeValues.size();
+            for (auto& values : parameterValues)
+                total *= values.size();
+            return total;
+        }
+
+        // Renders this many seconds at every point
+        SweepResults run (double seconds)
+        {
+            const auto numPoints = getNumPoints();
+            SweepResults results (parameterIDs, numPoints);
+            for (size_t i = 0; i < numPoints; ++i)
+                describeGridPoint (i, results[i]);
+
+            // processors are built in batches so a big grid doesn't need every instance alive at once
+            const auto batchSize = 4 * ((size_t) analysisThreadPool().getNumThreads() + 1);
+            std::vector<std::unique_ptr<juce::AudioProcessor>> processors (juce::jmin (batchSize, numPoints));
+
+            for (size_t batchStart = 0; batchStart < numPoints; batchStart += batchSize)
+            {
+                const auto numInBatch = juce::jmin (batchSize, numPoints - batchStart);
+                for (size_t i = 0; i < numInBatch; ++i)
+                {
+                    processors[i] = factory();
+                    auto& result = results[batchStart + i];
+                    for (size_t p = 0; p < parameterIDs.size(); ++p)
+                        setParameterValue (*processors[i], parameterIDs[p], result.parameterValues[p]);
+                }
+
+                parallelForEach (numInBatch, [&] (size_t i) {
+                    renderPoint (*processors[i], results[batchStart + i], seconds);
+                });
+
+                for (size_t i = 0; i < numInBatch; ++i)
+                    processors[i].reset();
+            }
+            return results;
+        }
+
+    private:
+        Factory factory;
+        std::vector<double> rateValues { 44100.0 };
+        std::vector<int> blockSizeValues { 512 };
+        std::vector<juce::String> parameterIDs;
+        std::vector<std::vector<float>> parameterValues;
+        InputFunction inputFunction;
+        MeasureFunction measureFunction;
+
+        // the grid index is a mixed radix number with the last parameter as the fastest digit
+        void describeGridPoint (size_t index, SweepResult& result) const
+        {
+            result.parameterValues.resize (parameterIDs.size());
+            for (size_t p = parameterIDs.size(); p-- > 0;)
+            {
+                result.parameterValues[p] = parameterValues[p][index % parameterValues[p].size()];
+                index /= parameterValues[p].size();
+            }
+            result.blockSize = blockSizeValues[index % blockSizeValues.size()];
+            index /= blockSizeValues.size();
+            result.sampleRate = rateValues[index];
+        }
+
+        void renderPoint (juce::AudioProcessor& processor, SweepResult& result, double seconds) const
+        {
+            ProcessorHarness<SampleType> harness (processor, result.sampleRate, result.blockSize);
+
+            juce::AudioBuffer<SampleType>* output = nullptr;
+            if (inputFunction)
+            {
+                const auto numChannels = juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+                juce::AudioBuffer<SampleType> inputBuffer (numChannels, (int) std::llround (seconds * result.sampleRate));
+                auto inputBlock = AudioBlock<SampleType> (inputBuffer);
+                inputFunction (inputBlock, result.sampleRate);
+                output = &harness.render (inputBlock);
+            }
+            else
+                output = &harness.render (seconds);
+
+            const auto stats = BlockStats<SampleType> (*output);
+            result.rms = (double) stats.rms();
+            result.peak = (double) stats.peak();
+            result.valid = stats.isValid();
+            result.realtimeFactor = harness.getTimings().realtimeFactor();
+            result.realtimeViolations = harness.getRealtimeGuard().getNumViolations();
+
+            if (measureFunction)
+                result.measurement = measureFunction (*output, result);
+        }
+    };
+
+    // Checks that a measurement only ever goes one way as a parameter increases, at every other point of the sweep.
+    // Measures RMS unless you pass something else:
+    //
+    //   REQUIRE_THAT (results, isMonotonicWith ("gain"));
+    //   REQUIRE_THAT (results, isMonotonicWith ("cutoff", [] (auto& r) { return r.measurement; }, false));
+    struct isMonotonicWith : Catch::Matchers::MatcherGenericBase
+    {
+        using Measurement = std::function<double (const SweepResult&)>;
+
+        juce::String parameterID;
+        Measurement measurement;
+        bool increasing;
+        bool strictly;
+        mutable std::string problem = "";
+
+        explicit isMonotonicWith (
+            juce::String id,
+            Measurement m = [] (const SweepResult& result) { return result.rms; },
+            bool shouldIncrease = true,
+            bool strict = false)
+            : parameterID (std::move (id)), measurement (std::move (m)), increasing (shouldIncrease), strictly (strict) {}
+
+        [[nodiscard]] bool match (const SweepResults& results) const
+        {
+            for (auto& series : results.seriesAlong (parameterID))
+            {
+                for (size_t i = 1; i < series.size(); ++i)
+                {
+                    const auto before = measurement (results[series[i - 1]]);
+                    const auto after = measurement (results[series[i]]);
+                    const auto difference = increasing ? after - before : before - after;
+                    if (difference < 0 || (strictly && difference == 0))
+                    {
+                        std::ostringstream ss;
+                        ss << "went from " << before << " at " << results.describePoint (series[i - 1])
+                           << " to " << after << " at " << results.describePoint (series[i]);
+                        problem = ss.str();
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "is " << (strictly ? "strictly " : "") << (increasing ? "increasing" : "decreasing")
+               << " with " << parameterID.toStdString() << "\n"
+               << problem;
+            return ss.str();
+        }
+    };
+}
@@ -17,4 +17,29 @@ namespace melatonin
         auto unusedState = apvts.copyState();
         waitForParameterChange();
     }
+
+    static inline juce::AudioProcessorParameter* findParameter (juce::AudioProcessor& processor, const juce::String& parameterID)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                if (withID->paramID == parameterID)
+                    return parameter;
+        return nullptr;
+    }
+
+    // Sets a parameter by ID to a value in its own range (e.g. dB, not 0-1)
+    // An APVTS picks this up in its raw parameter values right away, but its ValueTree needs flushAPVTS
+    static inline void setParameterValue (juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = findParameter (processor, parameterID);
+
+        // there's no parameter with this ID!
+        jassert (parameter != nullptr);
+        if (parameter == nullptr)
+            return;
+
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            value = ranged->convertTo0to1 (value);
+        parameter->setValueNotifyingHost (value);
+    }
 }
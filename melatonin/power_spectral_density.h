@@ -0,0 +1,249 @@
+#pragma once
+
+namespace melatonin
+{
+    // So slopes read like they do on a spec sheet: hasSpectralSlope (-3_dB_per_octave, 0.25, sampleRate)
+    inline namespace literals
+    {
+        constexpr double operator""_dB_per_octave (long double value) { return (double) value; }
+        constexpr double operator""_dB_per_octave (unsigned long long value) { return (double) value; }
+    }
+
+    // Welch's method: the power spectra of overlapping windowed segments, averaged over every segment of every channel.
+    // Averaging is what makes it steady enough to check the shape of noise, which a single FFT frame isn't.
+    //
+    // Densities are one-sided, in power per Hz, so summing them over a band (times the bin width) gives
+    // the mean square of that band. Segments are analyzed in parallel on the analysis thread pool.
+    template <typename SampleType>
+    class PowerSpectralDensity
+    {
+    public:
+        // order 13 is a segment size of 8192, an overlap of 0.5 is 50%
+        PowerSpectralDensity (const AudioBlock<SampleType>& block, double rate, int order = 13, double overlap = 0.5, WindowingMethod windowingMethod = WindowingMethod::hann)
+            : sampleRate (rate),
+              fftSize ((size_t) 1 << order),
+              hopSize (juce::jmax ((size_t) 1, (size_t) ((double) fftSize * (1.0 - juce::jlimit (0.0, 0.95, overlap))))),
+              numSegmentsPerChannel (block.getNumSamples() >= fftSize ? (block.getNumSamples() - fftSize) / hopSize + 1 : 0),
+              densities (fftSize / 2 + 1, 0.0)
+        {
+            const auto numSegments = numSegmentsPerChannel * block.getNumChannels();
+            if (numSegments == 0)
+                return;
+
+            auto window = FFTPlanCache::getInstance().getWindow (order, windowingMethod, false);
+            double sumOfSquares = 0;
+            for (auto w : *window)
+                sumOfSquares += (double) w * (double) w;
+
+            std::mutex mutex;
+            parallelFor (numSegments, [&] (size_t begin, size_t end) {
+                // engines belong to the thread that asked for them
+                auto engine = FFTPlanCache::getInstance().getEngine (order);
+                juce::HeapBlock<float> scratch (fftSize * 2, true);
+                std::vector<double> sums (densities.size(), 0.0);
+                for (size_t job = begin; job < end; ++job)
+                {
+                    const auto channel = job / numSegmentsPerChannel;
+                    const auto start = (job % numSegmentsPerChannel) * hopSize;
+
+                    copyForFFT (scratch.getData(), block.getChannelPointer (channel) + start, fftSize, fftSize);
+                    juce::FloatVectorOperations::multiply (scratch.getData(), window->data(), (int) fftSize);
+                    engine->performRealOnlyForwardTransform (scratch.getData(), true);
+                    for (size_t k = 0; k < sums.size(); ++k)
+                        sums[k] += (double) scratch[2 * k] * scratch[2 * k] + (double) scratch[2 * k + 1] * scratch[2 * k + 1];
+                }
+
+                std::lock_guard<std::mutex> lock (mutex);
+                for (size_t k = 0; k < sums.size(); ++k)
+                    densities[k] += sums[k];
+            });
+
+            // |X|^2 / (rate * sum of w^2), doubled for the negative frequencies everywhere but DC and nyquist
+            const auto normalisation = 1.0 / (sampleRate * sumOfSquares * (double) numSegments);
+            for (size_t k = 0; k < densities.size(); ++k)
+                densities[k] *= normalisation * (k == 0 || k + 1 == densities.size() ? 1.0 : 2.0);
+        }
+
+        [[nodiscard]] size_t getNumBins() const { return densities.size(); }
+        [[nodiscard]] size_t getFFTSize() const { return fftSize; }
+        [[nodiscard]] size_t getNumSegments() const { return numSegmentsPerChannel; }
+        [[nodiscard]] double getSampleRate() const { return sampleRate; }
+        [[nodiscard]] double binWidth() const { return sampleRate / (double) fftSize; }
+        [[nodiscard]] double frequencyForBin (size_t bin) const { return (double) bin * binWidth(); }
+
+        [[nodiscard]] double getDensity (size_t bin) const { return densities[bin]; }
+        [[nodiscard]] double getDensityInDB (size_t bin) const { return 10.0 * std::log10 (juce::jmax (densities[bin], 1e-40)); }
+        [[nodiscard]] const std::vector<double>& getDensities() const { return densities; }
+
+        // Mean square of everything between the two frequencies
+        [[nodiscard]] double bandPower (double lowFrequency, double highFrequency) const
+        {
+            double total = 0;
+            for (size_t k = 0; k < densities.size(); ++k)
+                if (frequencyForBin (k) >= lowFrequency && frequencyForBin (k) < highFrequency)
+                    total += densities[k];
+            return total * binWidth();
+        }
+
+    private:
+        double sampleRate;
+        size_t fftSize;
+        size_t hopSize;
+        size_t numSegmentsPerChannel;
+        std::vector<double> densities;
+    };
+
+    // The PSD averaged into fractional octave bands, with a straight line fitted through them on a log frequency axis.
+    // Bands weight every octave equally, where individual bins would be dominated by the top octave.
+    struct SpectralShape
+    {
+        struct Band
+        {
+            double frequency; // geometric center
+            double level; // dB
+        };
+
+        std::vector<Band> bands;
+        double slope = 0; // dB per octave
+        double flatness = 0; // the furthest any band is from the mean level, in dB
+        double deviation = 0; // the furthest any band is from the fitted line, in dB
+        double worstFrequency = 0; // where flatness was measured
+    };
+
+    template <typename SampleType>
+    static inline SpectralShape spectralShape (const PowerSpectralDensity<SampleType>& psd, double lowFrequency, double highFrequency, int bandsPerOctave = 3)
+    {
+        SpectralShape shape;
+        const auto step = std::pow (2.0, 1.0 / bandsPerOctave);
+        for (auto bandStart = lowFrequency; bandStart * step <= highFrequency * 1.0001; bandStart *= step)
+        {
+            double total = 0;
+            size_t count = 0;
+            for (auto k = (size_t) std::ceil (bandStart / psd.binWidth()); k < psd.getNumBins() && psd.frequencyForBin (k) < bandStart * step; ++k)
+            {
+                total += psd.getDensity (k);
+                ++count;
+            }
+            if (count > 0)
+                shape.bands.push_back ({ bandStart * std::sqrt (step), 10.0 * std::log10 (juce::jmax (total / (double) count, 1e-40)) });
+        }
+        if (shape.bands.size() < 2)
+            return shape;
+
+        double n = 0, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+        for (auto& band : shape.bands)
+        {
+            const auto x = std::log2 (band.frequency);
+            n += 1;
+            sumX += x;
+            sumY += band.level;
+            sumXX += x * x;
+            sumXY += x * band.level;
+        }
+        shape.slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+        const auto offset = (sumY - shape.slope * sumX) / n;
+        const auto mean = sumY / n;
+
+        for (auto& band : shape.bands)
+        {
+            shape.deviation = juce::jmax (shape.deviation, std::abs (band.level - (offset + shape.slope * std::log2 (band.frequency))));
+            if (std::abs (band.level - mean) > shape.flatness)
+            {
+                shape.flatness = std::abs (band.level - mean);
+                shape.worstFrequency = band.frequency;
+            }
+        }
+        return shape;
+    }
+
+    // Shared by the spectral matchers: a Welch PSD of every channel, reduced to third octave bands
+    struct SpectralMatcherBase : Catch::Matchers::MatcherGenericBase
+    {
+        double tolerance;
+        double sampleRate;
+        double lowFrequency;
+        double highFrequency;
+        mutable SpectralShape shape;
+
+        SpectralMatcherBase (double t, double rate, double low, double high)
+            : tolerance (t), sampleRate (rate), lowFrequency (low), highFrequency (high > 0 ? high : rate * 0.4) {}
+
+        template <typename SampleType>
+        void analyze (const AudioBlock<SampleType>& block) const
+        {
+            shape = spectralShape (PowerSpectralDensity<SampleType> (block, sampleRate), lowFrequency, highFrequency);
+        }
+    };
+
+    // White noise is 0 dB per octave, pink is -3, brown is -6
+    //
+    //   REQUIRE_THAT (pinkNoise, hasSpectralSlope (-3_dB_per_octave, 0.25, sampleRate));
+    struct hasSpectralSlope : SpectralMatcherBase
+    {
+        double expectedSlope;
+
+        // by default checks from 50Hz up to 40% of the sample rate
+        hasSpectralSlope (double slope, double tolerance, double rate, double low = 50.0, double high = 0)
+            : SpectralMatcherBase (tolerance, rate, low, high), expectedSlope (slope) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            analyze (block);
+            return shape.bands.size() >= 2 && std::abs (shape.slope - expectedSlope) <= tolerance;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "has a spectral slope of " << expectedSlope << " dB/octave (within " << tolerance << ") from "
+               << lowFrequency << "Hz to " << highFrequency << "Hz\n";
+            if (shape.bands.size() < 2)
+                ss << "Too short to measure";
+            else
+                ss << "Slope is " << shape.slope << " dB/octave, bands are within " << shape.deviation << " dB of that line";
+            return ss.str();
+        }
+    };
+
+    // Every third octave band within tolerance dB of the average level
+    //
+    //   REQUIRE_THAT (whiteNoise, isSpectrallyFlat (0.5, sampleRate));
+    struct isSpectrallyFlat : SpectralMatcherBase
+    {
+        // by default checks from 50Hz up to 40% of the sample rate
+        isSpectrallyFlat (double tolerance, double rate, double low = 50.0, double high = 0)
+            : SpectralMatcherBase (tolerance, rate, low, high) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            analyze (block);
+            return shape.bands.size() >= 2 && shape.flatness <= tolerance;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "is spectrally flat within " << tolerance << " dB from " << lowFrequency << "Hz to " << highFrequency << "Hz\n";
+            if (shape.bands.size() < 2)
+                ss << "Too short to measure";
+            else
+                ss << "The band at " << shape.worstFrequency << "Hz is " << shape.flatness << " dB from the average (slope is "
+                   << shape.slope << " dB/octave)";
+            return ss.str();
+        }
+    };
+}
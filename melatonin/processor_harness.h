@@ -0,0 +1,253 @@
+#pragma once
+
+namespace melatonin
+{
+    // How long each processBlock call took during a render
+    class RenderTimings
+    {
+    public:
+        RenderTimings() = default;
+        RenderTimings (double rate, int size) : sampleRate (rate), blockSize (size) {}
+
+        void reserve (size_t numBlocks) { blockSeconds.reserve (numBlocks); }
+        void clear()
+        {
+            blockSeconds.clear();
+            samplesRendered = 0;
+        }
+
+        void add (double seconds, size_t numSamples)
+        {
+            blockSeconds.push_back (seconds);
+            samplesRendered += numSamples;
+        }
+
+        [[nodiscard]] const std::vector<double>& getBlockSeconds() const { return blockSeconds; }
+        [[nodiscard]] size_t getNumBlocks() const { return blockSeconds.size(); }
+        [[nodiscard]] double getSampleRate() const { return sampleRate; }
+        [[nodiscard]] int getBlockSize() const { return blockSize; }
+
+        [[nodiscard]] double totalSeconds() const { return std::accumulate (blockSeconds.begin(), blockSeconds.end(), 0.0); }
+        [[nodiscard]] double audioSeconds() const { return (double) samplesRendered / sampleRate; }
+
+        // how many times faster than realtime the render was (2.0 means a second of audio took half a second)
+        [[nodiscard]] double realtimeFactor() const
+        {
+            auto total = totalSeconds();
+            return total > 0 ? audioSeconds() / total : std::numeric_limits<double>::infinity();
+        }
+
+        // nearest-rank percentile of block times, in seconds (percentile 0-100)
+        [[nodiscard]] double percentile (double percent) const
+        {
+            if (blockSeconds.empty())
+                return 0;
+            auto sorted = blockSeconds;
+            auto rank = (size_t) std::ceil (percent / 100.0 * (double) sorted.size());
+            auto index = juce::jlimit ((size_t) 0, sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+            std::nth_element (sorted.begin(), sorted.begin() + (std::ptrdiff_t) index, sorted.end());
+            return sorted[index];
+        }
+
+        [[nodiscard]] double median() const { return percentile (50); }
+        [[nodiscard]] double worstBlock() const { return blockSeconds.empty() ? 0 : *std::max_element (blockSeconds.begin(), blockSeconds.end()); }
+
+        // time available for one block before it would drop out
+        [[nodiscard]] double blockBudget() const { return (double) blockSize / sampleRate; }
+
+        [[nodiscard]] std::string summary() const
+        {
+            std::ostringstream ss;
+            ss << getNumBlocks() << " blocks of " << blockSize << " samples at " << sampleRate << "Hz, "
+               << realtimeFactor() << "x realtime, "
+               << "p50 " << median() * 1e6 << "us, p99 " << percentile (99) * 1e6 << "us, max " << worstBlock() * 1e6 << "us"
+               << " (budget " << blockBudget() * 1e6 << "us)";
+            return ss.str();
+        }
+
+    private:
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        size_t samplesRendered = 0;
+        std::vector<double> blockSeconds;
+    };
+
+    // Pulls audio through a processor the way a host would: prepareToPlay once, then processBlock
+    // in fixed size blocks with a playhead that advances from 0 on each render. Each processBlock
+    // call is timed and watched by a RealtimeGuard. When the harness goes away it clears the
+    // processor's playhead and calls releaseResources.
+    //
+    //   auto harness = ProcessorHarness (myProcessor, 48000.0, 64);
+    //   auto& output = harness.render (10.0); // seconds of silence in
+    //   REQUIRE_THAT (output, isValidAudio());
+    //   REQUIRE_THAT (harness, rendersFasterThanRealtime (50));
+    //   REQUIRE_THAT (harness, isRealtimeSafe());
+    template <typename SampleType = float>
+    class ProcessorHarness
+    {
+    public:
+        ProcessorHarness (juce::AudioProcessor& p, double rate = 44100.0, int size = 512)
+            : processor (p), sampleRate (rate), blockSize (size), timings (rate, size)
+        {
+            numChannels = juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+            playhead.setSampleRate (sampleRate);
+        }
+
+        // The processor outlives the harness, so it mustn't be left holding a pointer to our playhead
+        ~ProcessorHarness()
+        {
+            if (!prepared)
+                return;
+
+            processor.setPlayHead (nullptr);
+            processor.releaseResources();
+        }
+
+        // Called for you by render, but call it yourself if you want to poke the processor first
+        void prepare()
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+            {
+                jassert (processor.supportsDoublePrecisionProcessing());
+                processor.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+            }
+
+            processor.setPlayHead (&playhead);
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+            prepared = true;
+        }
+
+        // Renders seconds of audio with silence as input
+        juce::AudioBuffer<SampleType>& render (double seconds)
+        {
+            allocateOutput ((size_t) std::llround (seconds * sampleRate));
+            output.clear();
+            return renderOutputInPlace();
+        }
+
+        // Renders input through the processor, channel for channel
+        juce::AudioBuffer<SampleType>& render (const AudioBlock<const SampleType>& input)
+        {
+            allocateOutput (input.getNumSamples());
+            output.clear();
+            for (size_t c = 0; c < juce::jmin (input.getNumChannels(), (size_t) numChannels); ++c)
+                juce::FloatVectorOperations::copy (output.getWritePointer ((int) c), input.getChannelPointer (c), (int) input.getNumSamples());
+            return renderOutputInPlace();
+        }
+
+        juce::AudioBuffer<SampleType>& render (const AudioBlock<SampleType>& input)
+        {
+            return render (AudioBlock<const SampleType> (input));
+        }
+
+        [[nodiscard]] juce::AudioBuffer<SampleType>& getOutput() { return output; }
+        [[nodiscard]] const RenderTimings& getTimings() const { return timings; }
+        [[nodiscard]] const RealtimeGuard& getRealtimeGuard() const { return realtimeGuard; }
+        [[nodiscard]] PlayingPlayhead& getPlayhead() { return playhead; }
+        [[nodiscard]] juce::AudioProcessor& getProcessor() { return processor; }
+        [[nodiscard]] double getSampleRate() const { return sampleRate; }
+        [[nodiscard]] int getBlockSize() const { return blockSize; }
+
+    private:
+        juce::AudioProcessor& processor;
+        double sampleRate;
+        int blockSize;
+        int numChannels = 2;
+        bool prepared = false;
+        PlayingPlayhead playhead;
+        juce::AudioBuffer<SampleType> output;
+        juce::MidiBuffer midi;
+        RenderTimings timings;
+        RealtimeGuard realtimeGuard { false };
+
+        void allocateOutput (size_t numSamples)
+        {
+            if (!prepared)
+                prepare();
+
+            // only reallocates when it needs to grow
+            output.setSize (numChannels, (int) numSamples, false, false, true);
+            playhead.resetPosition(); // every render starts from the top
+            timings.clear();
+            timings.reserve (numSamples / (size_t) blockSize + 1);
+            realtimeGuard.reset();
+        }
+
+        // Each block is an AudioBuffer referring straight into the output, so nothing is copied or allocated while rendering
+        juce::AudioBuffer<SampleType>& renderOutputInPlace()
+        {
+            const auto numSamples = output.getNumSamples();
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                const auto thisBlockSize = juce::jmin (blockSize, numSamples - start);
+                juce::AudioBuffer<SampleType> block (output.getArrayOfWritePointers(), numChannels, start, thisBlockSize);
+                midi.clear();
+
+                realtimeGuard.arm();
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+                processor.processBlock (block, midi);
+                const auto endTicks = juce::Time::getHighResolutionTicks();
+                realtimeGuard.disarm();
+
+                timings.add (juce::Time::highResolutionTicksToSeconds (endTicks - startTicks), (size_t) thisBlockSize);
+                playhead.advancePosition ((size_t) thisBlockSize);
+            }
+            return output;
+        }
+    };
+
+    struct rendersFasterThanRealtime : Catch::Matchers::MatcherGenericBase
+    {
+        double factor;
+        mutable std::string summary = "";
+        explicit rendersFasterThanRealtime (double f = 1.0) : factor (f) {}
+
+        [[nodiscard]] bool match (const RenderTimings& timings) const
+        {
+            summary = timings.summary();
+            return timings.realtimeFactor() >= factor;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const ProcessorHarness<SampleType>& harness) const
+        {
+            return match (harness.getTimings());
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "renders at least " << factor << "x faster than realtime\n"
+               << summary;
+            return ss.str();
+        }
+    };
+
+    struct worstBlockUnder : Catch::Matchers::MatcherGenericBase
+    {
+        double microseconds;
+        mutable std::string summary = "";
+        explicit worstBlockUnder (double us) : microseconds (us) {}
+
+        [[nodiscard]] bool match (const RenderTimings& timings) const
+        {
+            summary = timings.summary();
+            return timings.worstBlock() * 1e6 < microseconds;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const ProcessorHarness<SampleType>& harness) const
+        {
+            return match (harness.getTimings());
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            std::ostringstream ss;
+            ss << "every processBlock call takes less than " << microseconds << "us\n"
+               << summary;
+            return ss.str();
+        }
+    };
+}
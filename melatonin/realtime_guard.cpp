@@ -0,0 +1,111 @@
+#if MELATONIN_REALTIME_GUARD
+
+    #include <cstdlib>
+    #include <new>
+
+// Global operator new and delete replacements that tell the RealtimeGuard armed on this thread (if any).
+// Replacements have to be defined exactly once per program, which is why this isn't in the header.
+namespace melatonin::realtime_guard_hooks
+{
+    static void* allocate (std::size_t size)
+    {
+        RealtimeGuard::recordViolation (RealtimeViolation::Kind::allocation, size);
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    static void* allocateAligned (std::size_t size, std::align_val_t alignment)
+    {
+        RealtimeGuard::recordViolation (RealtimeViolation::Kind::allocation, size);
+        size = size == 0 ? 1 : size;
+    #if JUCE_WINDOWS
+        return _aligned_malloc (size, (std::size_t) alignment);
+    #else
+        void* memory = nullptr;
+        return posix_memalign (&memory, juce::jmax ((std::size_t) alignment, sizeof (void*)), size) == 0 ? memory : nullptr;
+    #endif
+    }
+
+    static void release (void* memory) noexcept
+    {
+        if (memory == nullptr)
+            return;
+        RealtimeGuard::recordViolation (RealtimeViolation::Kind::deallocation);
+        std::free (memory);
+    }
+
+    static void releaseAligned (void* memory) noexcept
+    {
+        if (memory == nullptr)
+            return;
+        RealtimeGuard::recordViolation (RealtimeViolation::Kind::deallocation);
+    #if JUCE_WINDOWS
+        _aligned_free (memory);
+    #else
+        std::free (memory);
+    #endif
+    }
+
+    static void* allocateOrThrow (std::size_t size)
+    {
+        if (auto memory = allocate (size))
+            return memory;
+        throw std::bad_alloc();
+    }
+
+    static void* allocateAlignedOrThrow (std::size_t size, std::align_val_t alignment)
+    {
+        if (auto memory = allocateAligned (size, alignment))
+            return memory;
+        throw std::bad_alloc();
+    }
+
+    static const bool installed = (RealtimeGuard::hooksInstalled = true);
+}
+
+// clang-format off
+void* operator new (std::size_t size) { return melatonin::realtime_guard_hooks::allocateOrThrow (size); }
+void* operator new[] (std::size_t size) { return melatonin::realtime_guard_hooks::allocateOrThrow (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept { return melatonin::realtime_guard_hooks::allocate (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return melatonin::realtime_guard_hooks::allocate (size); }
+void* operator new (std::size_t size, std::align_val_t alignment) { return melatonin::realtime_guard_hooks::allocateAlignedOrThrow (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return melatonin::realtime_guard_hooks::allocateAlignedOrThrow (size, alignment); }
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return melatonin::realtime_guard_hooks::allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return melatonin::realtime_guard_hooks::allocateAligned (size, alignment); }
+
+void operator delete (void* memory) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete[] (void* memory) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete (void* memory, std::size_t) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete[] (void* memory, std::size_t) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete (void* memory, const std::nothrow_t&) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete[] (void* memory, const std::nothrow_t&) noexcept { melatonin::realtime_guard_hooks::release (memory); }
+void operator delete (void* memory, std::align_val_t) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+void operator delete[] (void* memory, std::align_val_t) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+void operator delete (void* memory, std::size_t, std::align_val_t) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+void operator delete[] (void* memory, std::size_t, std::align_val_t) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+void operator delete (void* memory, std::align_val_t, const std::nothrow_t&) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+void operator delete[] (void* memory, std::align_val_t, const std::nothrow_t&) noexcept { melatonin::realtime_guard_hooks::releaseAligned (memory); }
+// clang-format on
+
+    #if MELATONIN_REALTIME_GUARD_LOCKS && JUCE_LINUX
+        #include <dlfcn.h>
+        #include <pthread.h>
+
+// Interposes libc's pthread_mutex_lock, which std::mutex and juce::CriticalSection both end up in
+extern "C" int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+{
+    using LockFunction = int (*) (pthread_mutex_t*);
+    static std::atomic<LockFunction> realLock { nullptr };
+
+    melatonin::RealtimeGuard::recordViolation (melatonin::RealtimeViolation::Kind::lock);
+
+    auto lock = realLock.load (std::memory_order_relaxed);
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+        realLock.store (lock, std::memory_order_relaxed);
+    }
+    return lock (mutex);
+}
+    #endif
+
+#endif
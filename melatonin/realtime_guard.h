@@ -0,0 +1,188 @@
+#pragma once
+
+namespace melatonin
+{
+    // Something that happened on the audio thread that shouldn't have
+    struct RealtimeViolation
+    {
+        enum class Kind {
+            allocation,
+            deallocation,
+            lock
+        };
+
+        Kind kind;
+        size_t size = 0; // bytes, for allocations
+        juce::String stack = {};
+
+        [[nodiscard]] std::string getDescription() const
+        {
+            switch (kind)
+            {
+                case Kind::allocation:
+                    return "allocated " + std::to_string (size) + " bytes";
+                case Kind::deallocation:
+                    return "freed memory";
+                case Kind::lock:
+                    return "locked a mutex";
+            }
+            return {};
+        }
+    };
+
+    // While armed, counts every operator new/delete (and pthread_mutex_lock on Linux, see MELATONIN_REALTIME_GUARD_LOCKS)
+    // made on the thread that armed it. Other threads are never affected.
+    //
+    //   RealtimeGuard guard;
+    //   processor.processBlock (buffer, midi);
+    //   guard.disarm(); // Catch is allowed to allocate
+    //   REQUIRE_THAT (guard, isRealtimeSafe());
+    //
+    // The hooks live in melatonin_test_helpers.cpp, which juce_add_module compiles for you.
+    class RealtimeGuard
+    {
+    public:
+        explicit RealtimeGuard (bool armImmediately = true, size_t stacksToCapture = 8)
+            : maxStacks (stacksToCapture)
+        {
+            violations.reserve (maxStacks);
+            if (armImmediately)
+                arm();
+        }
+
+        ~RealtimeGuard()
+        {
+            disarm();
+        }
+
+        // Guards nest, the most recently armed guard on a thread gets the violations
+        void arm()
+        {
+            if (armed)
+                return;
+            previous = current;
+            current = this;
+            armed = true;
+        }
+
+        void disarm()
+        {
+            if (!armed)
+                return;
+            jassert (current == this); // guards should be disarmed in the reverse order they were armed
+            current = previous;
+            armed = false;
+        }
+
+        void reset()
+        {
+            numAllocations = numDeallocations = numLocks = 0;
+            violations.clear();
+        }
+
+        [[nodiscard]] bool isArmed() const { return armed; }
+        [[nodiscard]] size_t getNumAllocations() const { return numAllocations; }
+        [[nodiscard]] size_t getNumDeallocations() const { return numDeallocations; }
+        [[nodiscard]] size_t getNumLocks() const { return numLocks; }
+        [[nodiscard]] size_t getNumViolations() const { return numAllocations + numDeallocations + numLocks; }
+
+        // only the first few violations (stacksToCapture) are kept, with their call stacks
+        [[nodiscard]] const std::vector<RealtimeViolation>& getViolations() const { return violations; }
+
+        // Called by the hooks. Anything allocated or locked while recording is ignored so this can't recurse
+        static void recordViolation (RealtimeViolation::Kind kind, size_t size = 0)
+        {
+            auto guard = current;
+            if (guard == nullptr || recording)
+                return;
+
+            recording = true;
+            guard->record (kind, size);
+            recording = false;
+        }
+
+        // Allocations and locks in this scope aren't counted, for test code that runs while a guard is armed
+        struct ScopedIgnore
+        {
+            ScopedIgnore() : wasRecording (recording) { recording = true; }
+            ~ScopedIgnore() { recording = wasRecording; }
+            bool wasRecording;
+        };
+
+        // False when the hooks weren't compiled in, in which case nothing can be detected
+        static bool hooksAreInstalled() { return hooksInstalled.load(); }
+
+        static inline thread_local RealtimeGuard* current = nullptr;
+        static inline thread_local bool recording = false;
+        static inline std::atomic<bool> hooksInstalled { false };
+
+    private:
+        RealtimeGuard* previous = nullptr;
+        bool armed = false;
+        size_t maxStacks;
+        size_t numAllocations = 0;
+        size_t numDeallocations = 0;
+        size_t numLocks = 0;
+        std::vector<RealtimeViolation> violations;
+
+        void record (RealtimeViolation::Kind kind, size_t size)
+        {
+            if (kind == RealtimeViolation::Kind::allocation)
+                ++numAllocations;
+            else if (kind == RealtimeViolation::Kind::deallocation)
+                ++numDeallocations;
+            else
+                ++numLocks;
+
+            if (violations.size() < maxStacks)
+                violations.push_back ({ kind, size, juce::SystemStats::getStackBacktrace() });
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (RealtimeGuard)
+    };
+
+    template <typename SampleType>
+    class ProcessorHarness;
+
+    // Fails if anything allocated, freed or locked while the guard was armed.
+    // Also takes a ProcessorHarness, which arms its guard around each processBlock call (so prepareToPlay is free to allocate)
+    struct isRealtimeSafe : Catch::Matchers::MatcherGenericBase
+    {
+        mutable std::string problem = "";
+
+        [[nodiscard]] bool match (const RealtimeGuard& guard) const
+        {
+            RealtimeGuard::ScopedIgnore ignore;
+            if (!RealtimeGuard::hooksAreInstalled())
+            {
+                problem = "the allocation hooks aren't installed (is MELATONIN_REALTIME_GUARD off, or melatonin_test_helpers.cpp not compiled?)";
+                return false;
+            }
+
+            if (guard.getNumViolations() == 0)
+                return true;
+
+            std::ostringstream ss;
+            ss << guard.getNumAllocations() << " allocations, "
+               << guard.getNumDeallocations() << " deallocations and "
+               << guard.getNumLocks() << " locks";
+            for (auto& violation : guard.getViolations())
+                ss << "\n\n"
+                   << violation.getDescription() << " at:\n"
+                   << violation.stack.toStdString();
+            problem = ss.str();
+            return false;
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const ProcessorHarness<SampleType>& harness) const
+        {
+            return match (harness.getRealtimeGuard());
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            return "is realtime safe\n" + problem;
+        }
+    };
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+namespace melatonin
+{
+    enum class SampleClass {
+        normal,
+        zero,
+        subnormal,
+        infinite,
+        nan
+    };
+
+    static inline const char* sampleClassName (SampleClass sampleClass)
+    {
+        switch (sampleClass)
+        {
+            case SampleClass::normal:
+                return "normal";
+            case SampleClass::zero:
+                return "zero";
+            case SampleClass::subnormal:
+                return "subnormal";
+            case SampleClass::infinite:
+                return "INF";
+            case SampleClass::nan:
+                return "NaN";
+        }
+        return "";
+    }
+
+    // IEEE 754 layout, so we can classify by looking at exponent and mantissa bits
+    // instead of calling std::fpclassify, which the compiler won't vectorize
+    template <typename SampleType>
+    struct SampleBits;
+
+    template <>
+    struct SampleBits<float>
+    {
+        using Bits = uint32_t;
+        static constexpr Bits exponentMask = 0x7F800000u;
+        static constexpr Bits mantissaMask = 0x007FFFFFu;
+    };
+
+    template <>
+    struct SampleBits<double>
+    {
+        using Bits = uint64_t;
+        static constexpr Bits exponentMask = 0x7FF0000000000000ull;
+        static constexpr Bits mantissaMask = 0x000FFFFFFFFFFFFFull;
+    };
+
+    template <typename SampleType>
+    static inline typename SampleBits<SampleType>::Bits bitsOf (SampleType value)
+    {
+        typename SampleBits<SampleType>::Bits bits;
+        std::memcpy (&bits, &value, sizeof (value));
+        return bits;
+    }
+
+    template <typename SampleType>
+    static inline SampleClass classifySample (SampleType value)
+    {
+        using Traits = SampleBits<SampleType>;
+        const auto bits = bitsOf (value);
+        const auto exponent = bits & Traits::exponentMask;
+        const auto mantissa = bits & Traits::mantissaMask;
+
+        if (exponent == Traits::exponentMask)
+            return mantissa == 0 ? SampleClass::infinite : SampleClass::nan;
+        if (exponent == 0)
+            return mantissa == 0 ? SampleClass::zero : SampleClass::subnormal;
+        return SampleClass::normal;
+    }
+
+    struct SampleClassCounts
+    {
+        size_t normal = 0;
+        size_t zero = 0;
+        size_t subnormal = 0;
+        size_t infinite = 0;
+        size_t nan = 0;
+
+        [[nodiscard]] size_t invalid() const { return subnormal + infinite + nan; }
+
+        SampleClassCounts& operator+= (const SampleClassCounts& other)
+        {
+            normal += other.normal;
+            zero += other.zero;
+            subnormal += other.subnormal;
+            infinite += other.infinite;
+            nan += other.nan;
+            return *this;
+        }
+    };
+
+    // Counts each class of sample, branch-free so it vectorizes
+    template <typename SampleType>
+    static inline SampleClassCounts classifySamples (const SampleType* data, size_t numSamples)
+    {
+        using Traits = SampleBits<SampleType>;
+        SampleClassCounts counts;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto bits = bitsOf (data[i]);
+            const auto exponent = bits & Traits::exponentMask;
+            const bool mantissaIsZero = (bits & Traits::mantissaMask) == 0;
+            const bool exponentIsMax = exponent == Traits::exponentMask;
+            const bool exponentIsZero = exponent == 0;
+
+            counts.zero += exponentIsZero && mantissaIsZero;
+            counts.subnormal += exponentIsZero && !mantissaIsZero;
+            counts.infinite += exponentIsMax && mantissaIsZero;
+            counts.nan += exponentIsMax && !mantissaIsZero;
+        }
+        counts.normal = numSamples - counts.zero - counts.subnormal - counts.infinite - counts.nan;
+        return counts;
+    }
+
+    // Fast path for validAudio: checks a chunk of samples at a time without branching
+    // and only bails out between chunks. Returns numSamples when everything is valid.
+    template <typename SampleType>
+    static inline size_t findFirstInvalidSample (const SampleType* data, size_t numSamples)
+    {
+        using Traits = SampleBits<SampleType>;
+        constexpr size_t chunkSize = 64;
+
+        for (size_t chunkStart = 0; chunkStart < numSamples; chunkStart += chunkSize)
+        {
+            const auto chunkEnd = juce::jmin (chunkStart + chunkSize, numSamples);
+            bool anyInvalid = false;
+            for (size_t i = chunkStart; i < chunkEnd; ++i)
+            {
+                const auto bits = bitsOf (data[i]);
+                const auto exponent = bits & Traits::exponentMask;
+                anyInvalid |= (exponent == Traits::exponentMask) | (exponent == 0 && (bits & Traits::mantissaMask) != 0);
+            }
+
+            if (anyInvalid)
+            {
+                for (size_t i = chunkStart; i < chunkEnd; ++i)
+                {
+                    auto sampleClass = classifySample (data[i]);
+                    if (sampleClass != SampleClass::normal && sampleClass != SampleClass::zero)
+                        return i;
+                }
+            }
+        }
+        return numSamples;
+    }
+
+    template <typename SampleType>
+    struct InvalidSample
+    {
+        size_t channel = 0;
+        size_t sample = 0;
+        SampleType value = 0;
+        SampleClass sampleClass = SampleClass::normal;
+    };
+
+    // Locates the first NaN, INF or subnormal, scanning channel by channel
+    template <typename SampleType>
+    static inline std::optional<InvalidSample<SampleType>> findFirstInvalidSample (const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+        {
+            auto channel = block.getChannelPointer (c);
+            auto index = findFirstInvalidSample (channel, block.getNumSamples());
+            if (index < block.getNumSamples())
+                return InvalidSample<SampleType> { c, index, channel[index], classifySample (channel[index]) };
+        }
+        return std::nullopt;
+    }
+
+    template <typename SampleType>
+    static inline SampleClassCounts classifySamples (const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        SampleClassCounts counts;
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+            counts += classifySamples (block.getChannelPointer (c), block.getNumSamples());
+        return counts;
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+namespace melatonin
+{
+    // How close two samples have to be to count as equal
+    struct Tolerance
+    {
+        enum class Mode {
+            absolute,
+            relative,
+            ulps
+        };
+
+        Mode mode = Mode::absolute;
+        double amount = 0;
+
+        static Tolerance absolute (double amount) { return { Mode::absolute, amount }; }
+
+        // a fraction of the larger magnitude of the two samples, e.g. 0.001 for 0.1%
+        static Tolerance relative (double fraction) { return { Mode::relative, fraction }; }
+
+        // units in the last place, the number of representable values between the two samples
+        static Tolerance ulps (uint64_t count) { return { Mode::ulps, (double) count }; }
+
+        [[nodiscard]] std::string describe() const
+        {
+            std::ostringstream ss;
+            if (mode == Mode::absolute)
+                ss << "within " << amount;
+            else if (mode == Mode::relative)
+                ss << "within " << amount * 100 << "%";
+            else
+                ss << "within " << amount << " ULPs";
+            return ss.str();
+        }
+    };
+
+    // Maps a sample's bits onto integers that sort the same way the samples do,
+    // which turns ULP distance into a subtraction
+    template <typename SampleType>
+    static inline int64_t orderedBitsOf (SampleType value)
+    {
+        using Signed = std::make_signed_t<typename SampleBits<SampleType>::Bits>;
+        const auto bits = (Signed) bitsOf (value);
+        return bits < 0 ? (int64_t) (std::numeric_limits<Signed>::min() - bits) : (int64_t) bits;
+    }
+
+    // How far apart two samples are, in the tolerance's units. NaN is infinitely far from everything.
+    template <Tolerance::Mode mode, typename SampleType>
+    static inline double deviationOf (SampleType actual, SampleType expected)
+    {
+        if constexpr (mode == Tolerance::Mode::absolute)
+        {
+            return std::abs ((double) actual - (double) expected);
+        }
+        else if constexpr (mode == Tolerance::Mode::relative)
+        {
+            const auto difference = std::abs ((double) actual - (double) expected);
+            const auto larger = juce::jmax (std::abs ((double) actual), std::abs ((double) expected));
+            return larger > 0 ? difference / larger : difference;
+        }
+        else
+        {
+            const auto a = orderedBitsOf (actual);
+            const auto b = orderedBitsOf (expected);
+            const auto distance = a > b ? (uint64_t) a - (uint64_t) b : (uint64_t) b - (uint64_t) a;
+            const bool isNaN = actual != actual || expected != expected;
+            return isNaN ? std::numeric_limits<double>::infinity() : (double) distance;
+        }
+    }
+
+    // Identical samples (including matching infinities) are always within tolerance, NaNs never are
+    template <Tolerance::Mode mode, typename SampleType>
+    static inline bool isWithinTolerance (SampleType actual, SampleType expected, double amount)
+    {
+        return actual == expected || deviationOf<mode> (actual, expected) <= amount;
+    }
+
+    template <Tolerance::Mode mode, typename SampleType>
+    static inline size_t findFirstMismatch (const SampleType* actual, const SampleType* expected, size_t numSamples, double amount)
+    {
+        // Counts mismatches 64 samples at a time with no branches (which vectorizes),
+        // only looking at individual samples in the chunk that has one
+        constexpr size_t chunkSize = 64;
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto count = juce::jmin (chunkSize, numSamples - start);
+            size_t mismatches = 0;
+            for (size_t i = start; i < start + count; ++i)
+                mismatches += !isWithinTolerance<mode> (actual[i], expected[i], amount);
+
+            if (mismatches > 0)
+                for (size_t i = start; i < start + count; ++i)
+                    if (!isWithinTolerance<mode> (actual[i], expected[i], amount))
+                        return i;
+        }
+        return numSamples;
+    }
+
+    // The index of the first sample out of tolerance, or numSamples when everything matches
+    template <typename SampleType>
+    static inline size_t findFirstMismatch (const SampleType* actual, const SampleType* expected, size_t numSamples, Tolerance tolerance)
+    {
+        switch (tolerance.mode)
+        {
+            case Tolerance::Mode::absolute:
+                return findFirstMismatch<Tolerance::Mode::absolute> (actual, expected, numSamples, tolerance.amount);
+            case Tolerance::Mode::relative:
+                return findFirstMismatch<Tolerance::Mode::relative> (actual, expected, numSamples, tolerance.amount);
+            case Tolerance::Mode::ulps:
+                return findFirstMismatch<Tolerance::Mode::ulps> (actual, expected, numSamples, tolerance.amount);
+        }
+        return numSamples;
+    }
+
+    // How badly one channel missed, for failure messages
+    struct MismatchSummary
+    {
+        size_t numOutOfTolerance = 0;
+        double worstDeviation = 0;
+        size_t worstSample = 0;
+    };
+
+    template <Tolerance::Mode mode, typename SampleType>
+    static inline MismatchSummary summarizeMismatches (const SampleType* actual, const SampleType* expected, size_t numSamples, double amount)
+    {
+        MismatchSummary summary;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            if (isWithinTolerance<mode> (actual[i], expected[i], amount))
+                continue;
+
+            ++summary.numOutOfTolerance;
+            auto deviation = deviationOf<mode> (actual[i], expected[i]);
+            if (deviation != deviation)
+                deviation = std::numeric_limits<double>::infinity();
+            if (deviation > summary.worstDeviation || summary.numOutOfTolerance == 1)
+            {
+                summary.worstDeviation = deviation;
+                summary.worstSample = i;
+            }
+        }
+        return summary;
+    }
+
+    template <typename SampleType>
+    static inline MismatchSummary summarizeMismatches (const SampleType* actual, const SampleType* expected, size_t numSamples, Tolerance tolerance)
+    {
+        switch (tolerance.mode)
+        {
+            case Tolerance::Mode::absolute:
+                return summarizeMismatches<Tolerance::Mode::absolute> (actual, expected, numSamples, tolerance.amount);
+            case Tolerance::Mode::relative:
+                return summarizeMismatches<Tolerance::Mode::relative> (actual, expected, numSamples, tolerance.amount);
+            case Tolerance::Mode::ulps:
+                return summarizeMismatches<Tolerance::Mode::ulps> (actual, expected, numSamples, tolerance.amount);
+        }
+        return {};
+    }
+}
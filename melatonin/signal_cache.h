@@ -0,0 +1,173 @@
+#pragma once
+
+namespace melatonin
+{
+    // A read-only, cache-line aligned, single channel signal shared between everyone who asked for it.
+    // The samples stay alive as long as a handle does, even after the cache evicts them.
+    template <typename SampleType>
+    class CachedSignal
+    {
+    public:
+        struct Storage
+        {
+            juce::HeapBlock<char> memory;
+            SampleType* channels[1] = { nullptr };
+            size_t numSamples = 0;
+
+            explicit Storage (size_t n) : numSamples (n)
+            {
+                constexpr size_t alignment = 64;
+                memory.allocate (n * sizeof (SampleType) + alignment, false);
+                auto address = reinterpret_cast<uintptr_t> (memory.getData());
+                auto aligned = (address + alignment - 1) & ~(uintptr_t) (alignment - 1);
+                channels[0] = reinterpret_cast<SampleType*> (aligned);
+            }
+
+            [[nodiscard]] size_t sizeInBytes() const { return numSamples * sizeof (SampleType); }
+        };
+
+        explicit CachedSignal (std::shared_ptr<const Storage> s) : storage (std::move (s)) {}
+
+        // valid for as long as this CachedSignal (or a copy of it) is around
+        [[nodiscard]] AudioBlock<const SampleType> getBlock() const { return { storage->channels, 1, storage->numSamples }; }
+        [[nodiscard]] const SampleType* getData() const { return storage->channels[0]; }
+        [[nodiscard]] size_t getNumSamples() const { return storage->numSamples; }
+
+    private:
+        std::shared_ptr<const Storage> storage;
+    };
+
+    // Copies (or adds) a cached signal into every channel of a block
+    template <typename SampleType>
+    static inline AudioBlock<SampleType>& copySignalToBlock (AudioBlock<SampleType>& block, const CachedSignal<SampleType>& signal, bool accumulate = false)
+    {
+        jassert (signal.getNumSamples() >= block.getNumSamples());
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+        {
+            if (accumulate)
+                juce::FloatVectorOperations::add (block.getChannelPointer (c), signal.getData(), (int) block.getNumSamples());
+            else
+                juce::FloatVectorOperations::copy (block.getChannelPointer (c), signal.getData(), (int) block.getNumSamples());
+        }
+        return block;
+    }
+
+    // Process-wide memo of generated test signals, keyed by waveform, frequency, sample rate, length and gain.
+    // The least recently used signals are evicted once the memory budget (32MB by default) is exceeded.
+    // Signals bigger than an eighth of the budget aren't kept at all: long renders are cheap to regenerate
+    // compared to the memory they'd pin for the rest of the test run.
+    //
+    //   auto sine = SignalCache::getInstance().get<float> (Waveform::sine, 1000.f, 48000.f, 48000);
+    //   myBlock.copyFrom (sine.getBlock());
+    class SignalCache
+    {
+    public:
+        static constexpr size_t defaultMemoryBudget = 32 * 1024 * 1024;
+
+        static SignalCache& getInstance()
+        {
+            static SignalCache cache;
+            return cache;
+        }
+
+        template <typename SampleType>
+        CachedSignal<SampleType> get (Waveform waveform, float frequency, float sampleRate, size_t numSamples, float gain = 1.0f)
+        {
+            using Storage = typename CachedSignal<SampleType>::Storage;
+            const Key key { sizeof (SampleType), (int) waveform, frequency, sampleRate, numSamples, gain };
+
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                if (auto existing = entries.find (key); existing != entries.end())
+                {
+                    recentlyUsed.splice (recentlyUsed.begin(), recentlyUsed, existing->second.position);
+                    ++hits;
+                    return CachedSignal<SampleType> (std::static_pointer_cast<const Storage> (existing->second.storage));
+                }
+            }
+
+            // generate outside the lock so other threads aren't held up by a long signal
+            auto storage = std::make_shared<Storage> (numSamples);
+            auto block = AudioBlock<SampleType> (storage->channels, 1, numSamples);
+            Oscillator<SampleType> (frequency, sampleRate, gain).render (block, waveform);
+
+            std::lock_guard<std::mutex> lock (mutex);
+            ++misses;
+            if (auto existing = entries.find (key); existing != entries.end())
+                return CachedSignal<SampleType> (std::static_pointer_cast<const Storage> (existing->second.storage));
+
+            if (storage->sizeInBytes() <= memoryBudget / largestEntryFraction)
+            {
+                recentlyUsed.push_front (key);
+                entries[key] = { storage, recentlyUsed.begin(), storage->sizeInBytes() };
+                bytesUsed += storage->sizeInBytes();
+                evictUntilWithinBudget();
+            }
+            return CachedSignal<SampleType> (storage);
+        }
+
+        // Set to 0 to turn caching off
+        void setMemoryBudget (size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            memoryBudget = bytes;
+            evictUntilWithinBudget();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            entries.clear();
+            recentlyUsed.clear();
+            bytesUsed = 0;
+        }
+
+        [[nodiscard]] size_t getBytesUsed() const
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            return bytesUsed;
+        }
+
+        [[nodiscard]] size_t getNumHits() const
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            return hits;
+        }
+
+        [[nodiscard]] size_t getNumMisses() const
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            return misses;
+        }
+
+    private:
+        using Key = std::tuple<size_t, int, float, float, size_t, float>;
+
+        struct Entry
+        {
+            std::shared_ptr<const void> storage;
+            std::list<Key>::iterator position;
+            size_t sizeInBytes = 0;
+        };
+
+        mutable std::mutex mutex;
+        std::map<Key, Entry> entries;
+        std::list<Key> recentlyUsed;
+        static constexpr size_t largestEntryFraction = 8;
+        size_t memoryBudget = defaultMemoryBudget;
+        size_t bytesUsed = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+
+        void evictUntilWithinBudget()
+        {
+            while (bytesUsed > memoryBudget && !recentlyUsed.empty())
+            {
+                auto entry = entries.find (recentlyUsed.back());
+                bytesUsed -= entry->second.sizeInBytes;
+                entries.erase (entry);
+                recentlyUsed.pop_back();
+            }
+        }
+    };
+}
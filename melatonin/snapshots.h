@@ -0,0 +1,263 @@
+#pragma once
+
+namespace melatonin
+{
+    // Snapshots are a 64 byte header followed by each channel's samples in native byte order.
+    // Every channel starts on a 64 byte boundary, so a memory mapped snapshot can be used in place.
+    struct SnapshotHeader
+    {
+        static constexpr char expectedMagic[8] = { 'M', 'E', 'L', 'S', 'N', 'A', 'P', '\0' };
+        static constexpr uint32_t currentVersion = 1;
+        static constexpr uint32_t expectedByteOrder = 0x01020304;
+        static constexpr size_t alignment = 64;
+
+        char magic[8] = {};
+        uint32_t version = currentVersion;
+        uint32_t byteOrder = expectedByteOrder;
+        uint32_t bytesPerSample = 0;
+        uint32_t numChannels = 0;
+        uint64_t numSamples = 0;
+        uint64_t channelStride = 0; // in samples, between the start of one channel and the next
+        double sampleRate = 0;
+        char unused[16] = {};
+
+        static uint64_t strideFor (uint64_t numSamples, size_t bytesPerSample)
+        {
+            const auto bytes = numSamples * bytesPerSample;
+            return ((bytes + alignment - 1) / alignment * alignment) / bytesPerSample;
+        }
+    };
+    static_assert (sizeof (SnapshotHeader) == SnapshotHeader::alignment);
+
+    // A read-only, zero-copy view of a recorded snapshot. Nothing is read until the samples are touched,
+    // so opening a gigabyte reference is instant.
+    //
+    //   auto snapshot = Snapshot<float> (getSnapshotFile ("reverb_tail"));
+    //   REQUIRE (snapshot.isValid());
+    //   auto block = snapshot.getBlock();
+    template <typename SampleType>
+    class Snapshot
+    {
+    public:
+        explicit Snapshot (const juce::File& file)
+        {
+            if (!file.existsAsFile())
+            {
+                error = "there's no snapshot at " + file.getFullPathName().toStdString();
+                return;
+            }
+
+            mappedFile = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+            auto data = static_cast<const char*> (mappedFile->getData());
+            const auto size = mappedFile->getSize();
+
+            if (data == nullptr || size < sizeof (SnapshotHeader))
+            {
+                error = "couldn't map " + file.getFullPathName().toStdString();
+                return;
+            }
+
+            std::memcpy (&header, data, sizeof (SnapshotHeader));
+            if (std::memcmp (header.magic, SnapshotHeader::expectedMagic, sizeof (header.magic)) != 0)
+                error = "not a snapshot file";
+            else if (header.version != SnapshotHeader::currentVersion)
+                error = "snapshot version " + std::to_string (header.version) + " isn't supported";
+            else if (header.byteOrder != SnapshotHeader::expectedByteOrder)
+                error = "snapshot was recorded on a machine with a different byte order";
+            else if (header.bytesPerSample != sizeof (SampleType))
+                error = "snapshot was recorded as " + std::string (header.bytesPerSample == sizeof (double) ? "double" : "float");
+            else if (header.channelStride < header.numSamples)
+                error = "snapshot channels overlap (stride " + std::to_string (header.channelStride) + " is less than " + std::to_string (header.numSamples) + " samples)";
+            else if (header.numChannels > 0 && header.channelStride > (size - sizeof (SnapshotHeader)) / sizeof (SampleType) / header.numChannels)
+                error = "snapshot is truncated"; // checked by division so a corrupt header can't overflow the size
+
+            if (!error.empty())
+                return;
+
+            auto samples = reinterpret_cast<const SampleType*> (data + sizeof (SnapshotHeader));
+            for (size_t c = 0; c < header.numChannels; ++c)
+                channels.push_back (samples + c * header.channelStride);
+        }
+
+        [[nodiscard]] bool isValid() const { return error.empty(); }
+        [[nodiscard]] const std::string& getError() const { return error; }
+
+        [[nodiscard]] size_t getNumChannels() const { return channels.size(); }
+        [[nodiscard]] size_t getNumSamples() const { return isValid() ? (size_t) header.numSamples : 0; }
+        [[nodiscard]] double getSampleRate() const { return header.sampleRate; }
+
+        // valid for as long as the Snapshot is around
+        [[nodiscard]] AudioBlock<const SampleType> getBlock() const
+        {
+            return { channels.data(), channels.size(), getNumSamples() };
+        }
+
+    private:
+        SnapshotHeader header;
+        std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+        std::vector<const SampleType*> channels;
+        std::string error;
+    };
+
+    // Records a block as a snapshot, replacing any existing one
+    template <typename SampleType>
+    static inline bool writeSnapshot (const juce::File& file, const AudioBlock<const SampleType>& block, double sampleRate = 0)
+    {
+        SnapshotHeader header;
+        std::memcpy (header.magic, SnapshotHeader::expectedMagic, sizeof (header.magic));
+        header.bytesPerSample = sizeof (SampleType);
+        header.numChannels = (uint32_t) block.getNumChannels();
+        header.numSamples = block.getNumSamples();
+        header.channelStride = SnapshotHeader::strideFor (header.numSamples, sizeof (SampleType));
+        header.sampleRate = sampleRate;
+
+        file.getParentDirectory().createDirectory();
+
+        // written next to the real file then moved over it, so a failed write never leaves half a snapshot
+        auto temporaryFile = file.getSiblingFile (file.getFileName() + ".recording");
+        temporaryFile.deleteFile();
+        {
+            juce::FileOutputStream stream (temporaryFile);
+            if (stream.failedToOpen())
+                return false;
+
+            const auto padding = (header.channelStride - header.numSamples) * sizeof (SampleType);
+            bool ok = stream.write (&header, sizeof (header));
+            for (size_t c = 0; c < block.getNumChannels() && ok; ++c)
+            {
+                ok = stream.write (block.getChannelPointer (c), block.getNumSamples() * sizeof (SampleType));
+                ok = ok && (padding == 0 || stream.writeRepeatedByte (0, padding));
+            }
+            stream.flush();
+
+            if (!ok || stream.getStatus().failed())
+                return false;
+        }
+        return temporaryFile.moveFileTo (file);
+    }
+
+    template <typename SampleType>
+    static inline bool writeSnapshot (const juce::File& file, const AudioBlock<SampleType>& block, double sampleRate = 0)
+    {
+        return writeSnapshot (file, AudioBlock<const SampleType> (block), sampleRate);
+    }
+
+    // Where snapshots live: setSnapshotDirectory wins, then the MELATONIN_SNAPSHOT_DIR environment variable,
+    // then a snapshots folder in the working directory
+    static inline juce::File& snapshotDirectoryOverride()
+    {
+        static juce::File directory;
+        return directory;
+    }
+
+    static inline void setSnapshotDirectory (const juce::File& directory)
+    {
+        snapshotDirectoryOverride() = directory;
+    }
+
+    static inline juce::File getSnapshotDirectory()
+    {
+        if (snapshotDirectoryOverride().getFullPathName().isNotEmpty())
+            return snapshotDirectoryOverride();
+
+        auto fromEnvironment = juce::SystemStats::getEnvironmentVariable ("MELATONIN_SNAPSHOT_DIR", {});
+        if (fromEnvironment.isNotEmpty())
+            return juce::File (fromEnvironment);
+
+        return juce::File::getCurrentWorkingDirectory().getChildFile ("snapshots");
+    }
+
+    static inline juce::File getSnapshotFile (const juce::String& name)
+    {
+        return getSnapshotDirectory().getChildFile (name + ".melsnap");
+    }
+
+    // Set MELATONIN_UPDATE_SNAPSHOTS=1 when running your tests to (re)record every snapshot they check
+    static inline bool shouldRecordSnapshots()
+    {
+        auto flag = juce::SystemStats::getEnvironmentVariable ("MELATONIN_UPDATE_SNAPSHOTS", {});
+        return flag.isNotEmpty() && flag != "0";
+    }
+
+    // Compares against a recorded snapshot, or records one when MELATONIN_UPDATE_SNAPSHOTS is set.
+    // Pass a sample rate to have it recorded too (and checked on later runs).
+    // The tolerance is absolute, or pass a Tolerance::relative or Tolerance::ulps like isEqualTo.
+    //
+    //   REQUIRE_THAT (myBuffer, matchesSnapshot ("distortion_1k_sine"));
+    //   REQUIRE_THAT (myBuffer, matchesSnapshot ("reverb_tail", Tolerance::ulps (4)));
+    struct matchesSnapshot : Catch::Matchers::MatcherGenericBase
+    {
+        juce::String name;
+        Tolerance tolerance;
+        double sampleRate;
+        mutable std::string problem = "";
+
+        explicit matchesSnapshot (juce::String n, Tolerance t, double rate = 0)
+            : name (std::move (n)), tolerance (t), sampleRate (rate) {}
+
+        explicit matchesSnapshot (juce::String n, float t = std::numeric_limits<float>::epsilon() * 100, double rate = 0)
+            : matchesSnapshot (std::move (n), Tolerance::absolute (t), rate) {}
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (const AudioBlock<SampleType>& block) const
+        {
+            const auto file = getSnapshotFile (name);
+            if (shouldRecordSnapshots())
+            {
+                if (writeSnapshot (file, block, sampleRate))
+                    return true;
+                problem = "couldn't record " + file.getFullPathName().toStdString();
+                return false;
+            }
+
+            const auto snapshot = Snapshot<SampleType> (file);
+            if (!snapshot.isValid())
+            {
+                problem = snapshot.getError() + "\n(run with MELATONIN_UPDATE_SNAPSHOTS=1 to record it)";
+                return false;
+            }
+
+            if (snapshot.getNumChannels() != block.getNumChannels() || snapshot.getNumSamples() != block.getNumSamples())
+            {
+                std::ostringstream ss;
+                ss << "snapshot has " << snapshot.getNumChannels() << " channels of " << snapshot.getNumSamples()
+                   << " samples, this has " << block.getNumChannels() << " channels of " << block.getNumSamples();
+                problem = ss.str();
+                return false;
+            }
+
+            if (sampleRate > 0 && snapshot.getSampleRate() > 0 && !juce::approximatelyEqual (sampleRate, snapshot.getSampleRate()))
+            {
+                std::ostringstream ss;
+                ss << "snapshot was recorded at " << snapshot.getSampleRate() << "Hz";
+                problem = ss.str();
+                return false;
+            }
+
+            return matchesRecording (snapshot, block);
+        }
+
+        template <typename SampleType>
+        [[nodiscard]] bool match (juce::AudioBuffer<SampleType>& buffer) const
+        {
+            return match (AudioBlock<SampleType> (buffer));
+        }
+
+        [[nodiscard]] std::string describe() const override
+        {
+            return "matches snapshot " + name.toStdString() + "\n" + problem;
+        }
+
+    private:
+        template <typename SampleType>
+        bool matchesRecording (const Snapshot<SampleType>& snapshot, const AudioBlock<SampleType>& block) const
+        {
+            auto equal = isEqualTo<SampleType> (snapshot.getBlock(), tolerance);
+            if (equal.match (block))
+                return true;
+
+            problem = equal.describeMismatch();
+            return false;
+        }
+    };
+}
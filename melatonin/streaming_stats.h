@@ -0,0 +1,252 @@
+#pragma once
+
+namespace melatonin
+{
+    // Goertzel state that keeps going across blocks and remembers where the last full cycle ended
+    struct StreamingGoertzel
+    {
+        GoertzelState running;
+        GoertzelState lastFullCycle;
+        size_t samplesPerCycle = 1;
+
+        StreamingGoertzel (float frequency, float sampleRate)
+        {
+            running = makeGoertzelState (0, frequency, sampleRate);
+            lastFullCycle.coefficient = running.coefficient;
+            samplesPerCycle = juce::jmax ((size_t) 1, (size_t) (sampleRate / frequency));
+        }
+
+        template <typename SampleType>
+        void process (const SampleType* data, size_t numSamples)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto s0 = (double) data[i] + running.coefficient * running.s1 - running.s2;
+                running.s2 = running.s1;
+                running.s1 = s0;
+                if (++running.length % samplesPerCycle == 0)
+                    lastFullCycle = running;
+            }
+        }
+
+        [[nodiscard]] float magnitude() const { return lastFullCycle.length > 0 ? lastFullCycle.magnitude() : running.magnitude(); }
+    };
+
+    // Everything the matchers need to know about a render, accumulated one block at a time in constant memory.
+    // Use this when a render is too long to keep around:
+    //
+    //   auto stream = StreamingStats<float> ({ 440.f }, 48000.f); // frequencies are optional
+    //   for (...)
+    //   {
+    //       processor.processBlock (buffer, midi);
+    //       stream.push (buffer);
+    //   }
+    //   REQUIRE_THAT (stream, isValidAudio());
+    //   REQUIRE_THAT (stream, isEmptyAfter (48000));
+    template <typename SampleType>
+    class StreamingStats
+    {
+    public:
+        StreamingStats() = default;
+
+        StreamingStats (std::vector<float> frequenciesToTrack, float rate)
+            : frequencies (std::move (frequenciesToTrack)), sampleRate (rate) {}
+
+        void push (const AudioBlock<SampleType>& block)
+        {
+            if (channels.empty())
+                prepare (block.getNumChannels());
+
+            // every push should have the same number of channels
+            jassert (block.getNumChannels() == channels.size());
+
+            const auto numSamples = block.getNumSamples();
+            for (size_t c = 0; c < juce::jmin (block.getNumChannels(), channels.size()); ++c)
+                pushChannel (c, block.getChannelPointer (c), numSamples);
+
+            samplesSoFar += numSamples;
+        }
+
+        void push (const juce::AudioBuffer<SampleType>& buffer)
+        {
+            push (AudioBlock<SampleType> (const_cast<juce::AudioBuffer<SampleType>&> (buffer)));
+        }
+
+        // samples per channel pushed so far
+        [[nodiscard]] size_t getNumSamples() const { return samplesSoFar; }
+        [[nodiscard]] size_t getNumChannels() const { return channels.size(); }
+
+        [[nodiscard]] SampleType peak() const { return peakMagnitude; }
+
+        [[nodiscard]] double rms() const
+        {
+            const auto total = samplesSoFar * channels.size();
+            return total > 0 ? std::sqrt (sumOfSquares / (double) total) : 0.0;
+        }
+
+        [[nodiscard]] const SampleClassCounts& getClassCounts() const { return classCounts; }
+        [[nodiscard]] const std::optional<InvalidSample<SampleType>>& getFirstInvalidSample() const { return firstInvalid; }
+        [[nodiscard]] bool isValid() const { return classCounts.invalid() == 0; }
+
+        [[nodiscard]] std::optional<NonZeroSample> getFirstNonZeroSample() const { return firstNonZero; }
+        [[nodiscard]] std::optional<NonZeroSample> getLastNonZeroSample() const { return lastNonZero; }
+
+        // the earliest run of 2 or more zeros, including a run still in progress at the end
+        [[nodiscard]] std::optional<ZeroRun> getFirstGap() const
+        {
+            auto earliest = firstGap;
+            for (size_t c = 0; c < channels.size(); ++c)
+            {
+                auto& channel = channels[c];
+                if (channel.runLength >= 2 && (!earliest.has_value() || channel.runStart < earliest->start))
+                    earliest = ZeroRun { c, channel.runStart, channel.runLength };
+            }
+            return earliest;
+        }
+
+        [[nodiscard]] const std::vector<float>& getFrequencies() const { return frequencies; }
+
+        // strongest magnitude on any channel for each tracked frequency, over whole cycles
+        [[nodiscard]] std::vector<float> magnitudesOfFrequencies() const
+        {
+            std::vector<float> magnitudes (frequencies.size(), 0.0f);
+            for (auto& channel : channels)
+                for (size_t i = 0; i < frequencies.size(); ++i)
+                    magnitudes[i] = juce::jmax (magnitudes[i], channel.goertzels[i].magnitude());
+            return magnitudes;
+        }
+
+    private:
+        struct ChannelState
+        {
+            size_t runStart = 0;
+            size_t runLength = 0;
+            std::vector<StreamingGoertzel> goertzels;
+        };
+
+        std::vector<float> frequencies;
+        float sampleRate = 44100.f;
+        std::vector<ChannelState> channels;
+        size_t samplesSoFar = 0;
+        SampleType peakMagnitude = 0;
+        double sumOfSquares = 0;
+        SampleClassCounts classCounts;
+        std::optional<InvalidSample<SampleType>> firstInvalid;
+        std::optional<NonZeroSample> firstNonZero;
+        std::optional<NonZeroSample> lastNonZero;
+        std::optional<ZeroRun> firstGap;
+
+        void prepare (size_t numChannels)
+        {
+            channels.resize (numChannels);
+            for (auto& channel : channels)
+                for (auto frequency : frequencies)
+                    channel.goertzels.emplace_back (frequency, sampleRate);
+        }
+
+        // One full pass over the samples (the fused stats kernel). Everything else either stops at the first
+        // sample it's looking for or only runs when the stats say there's something to find.
+        void pushChannel (size_t c, const SampleType* data, size_t numSamples)
+        {
+            auto stats = calculateChannelStats (data, numSamples);
+            peakMagnitude = juce::jmax (peakMagnitude, stats.peak());
+            sumOfSquares += stats.sumOfSquares;
+
+            SampleClassCounts counts;
+            counts.zero = stats.numZeros;
+            counts.subnormal = stats.numSubnormals;
+            counts.infinite = stats.numInfs;
+            counts.nan = stats.numNaNs;
+            counts.normal = numSamples - counts.zero - counts.invalid();
+            classCounts += counts;
+
+            if (counts.invalid() > 0 && !firstInvalid.has_value())
+            {
+                auto index = findFirstInvalidSample (data, numSamples);
+                firstInvalid = InvalidSample<SampleType> { c, samplesSoFar + index, data[index], classifySample (data[index]) };
+            }
+
+            if (stats.numZeros < numSamples)
+                trackNonZeroSamples (c, data, numSamples);
+
+            trackZeroRuns (c, data, numSamples, stats.numZeros);
+
+            for (auto& goertzel : channels[c].goertzels)
+                goertzel.process (data, numSamples);
+        }
+
+        void trackNonZeroSamples (size_t c, const SampleType* data, size_t numSamples)
+        {
+            auto first = samplesSoFar + findFirstNonZeroSample (data, numSamples);
+            if (!firstNonZero.has_value() || first < firstNonZero->sample)
+                firstNonZero = NonZeroSample { c, first };
+
+            size_t last = numSamples - 1;
+            while (data[last] == 0)
+                --last;
+            if (!lastNonZero.has_value() || samplesSoFar + last > lastNonZero->sample)
+                lastNonZero = NonZeroSample { c, samplesSoFar + last };
+        }
+
+        // stitches runs of zeros together across block boundaries
+        void trackZeroRuns (size_t c, const SampleType* data, size_t numSamples, size_t numZeros)
+        {
+            auto& channel = channels[c];
+            if (numSamples == 0)
+                return;
+
+            // no zeros at all, so only a run carried over from the last block can end here
+            if (numZeros == 0)
+            {
+                if (channel.runLength > 0)
+                    recordGap (ZeroRun { c, channel.runStart, channel.runLength });
+                channel.runLength = 0;
+                return;
+            }
+
+            // silence carries on (or starts) a run without looking at the samples again
+            if (numZeros == numSamples)
+            {
+                if (channel.runLength == 0)
+                    channel.runStart = samplesSoFar;
+                channel.runLength += numSamples;
+                return;
+            }
+
+            const auto blockStart = samplesSoFar;
+            const auto blockEnd = samplesSoFar + numSamples;
+
+            // a run carried over from the last block ends here unless this block starts with a zero
+            if (channel.runLength > 0 && data[0] != 0)
+            {
+                recordGap (ZeroRun { c, channel.runStart, channel.runLength });
+                channel.runLength = 0;
+            }
+
+            scanZeroRuns (data, numSamples, c, blockStart, SampleType (0), 1, [&] (ZeroRun run) {
+                if (run.start == blockStart && channel.runLength > 0)
+                {
+                    run.start = channel.runStart;
+                    run.length += channel.runLength;
+                }
+                channel.runLength = 0;
+
+                // still going at the end of the block, so finish it on a later push
+                if (run.end() == blockEnd)
+                {
+                    channel.runStart = run.start;
+                    channel.runLength = run.length;
+                }
+                else
+                    recordGap (run);
+                return true;
+            });
+        }
+
+        void recordGap (const ZeroRun& run)
+        {
+            if (run.length >= 2 && (!firstGap.has_value() || run.start < firstGap->start))
+                firstGap = run;
+        }
+    };
+}
@@ -42,6 +42,14 @@ namespace melatonin
             return true;
         }
 
+        // every channel, in O(log n) once the index is built
+        template <typename SampleType>
+        [[nodiscard]] bool match (const BlockIndex<SampleType>& index) const
+        {
+            jassert (min < max);
+            return index.isBetween (0, index.getNumSamples(), (SampleType) (min - margin), (SampleType) (max + margin));
+        }
+
         [[nodiscard]] std::string describe() const override
         {
             std::ostringstream ss;
@@ -0,0 +1,154 @@
+#pragma once
+
+namespace melatonin
+{
+    // A stretch of consecutive (near) zero samples on one channel
+    struct ZeroRun
+    {
+        size_t channel = 0;
+        size_t start = 0;
+        size_t length = 0;
+
+        [[nodiscard]] size_t end() const { return start + length; }
+    };
+
+    // Walks one channel and calls onRun (ZeroRun) for every run of at least minLength samples
+    // whose magnitude is <= threshold. Return false from onRun to stop scanning.
+    //
+    // Real audio is mostly non-zero, so chunks are first checked for zeros without branching
+    // (which vectorizes) and only walked sample by sample when they contain one.
+    template <typename SampleType, typename Callback>
+    static inline bool scanZeroRuns (const SampleType* data, size_t numSamples, size_t channel, size_t offset, SampleType threshold, size_t minLength, Callback&& onRun)
+    {
+        constexpr size_t chunkSize = 64;
+        size_t runStart = 0;
+        size_t runLength = 0;
+
+        auto finishRun = [&]() {
+            bool keepGoing = true;
+            if (runLength >= minLength && runLength > 0)
+                keepGoing = onRun (ZeroRun { channel, offset + runStart, runLength });
+            runLength = 0;
+            return keepGoing;
+        };
+
+        for (size_t chunkStart = 0; chunkStart < numSamples; chunkStart += chunkSize)
+        {
+            const auto chunkEnd = juce::jmin (chunkStart + chunkSize, numSamples);
+
+            bool anyZeros = false;
+            for (size_t i = chunkStart; i < chunkEnd; ++i)
+                anyZeros |= std::abs (data[i]) <= threshold;
+
+            if (!anyZeros)
+            {
+                if (!finishRun())
+                    return false;
+                continue;
+            }
+
+            for (size_t i = chunkStart; i < chunkEnd; ++i)
+            {
+                if (std::abs (data[i]) <= threshold)
+                {
+                    if (runLength == 0)
+                        runStart = i;
+                    ++runLength;
+                }
+                else if (!finishRun())
+                    return false;
+            }
+        }
+        return finishRun();
+    }
+
+    // Every run of at least minLength zeros between sample start and end (exclusive) on every channel
+    template <typename SampleType>
+    static inline std::vector<ZeroRun> findZeroRuns (const juce::dsp::AudioBlock<SampleType>& block, size_t minLength = 1, SampleType threshold = 0, size_t start = 0, size_t end = std::numeric_limits<size_t>::max())
+    {
+        end = juce::jmin (end, block.getNumSamples());
+        std::vector<ZeroRun> runs;
+        if (start >= end)
+            return runs;
+
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+            scanZeroRuns (block.getChannelPointer (c) + start, end - start, c, start, threshold, minLength, [&] (const ZeroRun& run) {
+                runs.push_back (run);
+                return true;
+            });
+        return runs;
+    }
+
+    // The run that starts earliest on any channel (the lowest channel wins a tie), with its full length.
+    // Once a channel has a run, later channels are only scanned up to where it starts.
+    template <typename SampleType>
+    static inline std::optional<ZeroRun> findFirstZeroRun (const juce::dsp::AudioBlock<SampleType>& block, size_t minLength = 1, SampleType threshold = 0, size_t start = 0, size_t end = std::numeric_limits<size_t>::max())
+    {
+        end = juce::jmin (end, block.getNumSamples());
+        minLength = juce::jmax ((size_t) 1, minLength);
+        std::optional<ZeroRun> found;
+
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+        {
+            const auto scanEnd = found.has_value() ? juce::jmin (end, found->start + minLength - 1) : end;
+            if (start >= scanEnd)
+                break;
+
+            const auto* data = block.getChannelPointer (c);
+            scanZeroRuns (data + start, scanEnd - start, c, start, threshold, minLength, [&] (const ZeroRun& run) {
+                found = run;
+                return false;
+            });
+
+            // the shorter scan can cut a run off early
+            if (found.has_value() && found->channel == c)
+                while (found->end() < end && std::abs (data[found->end()]) <= threshold)
+                    ++found->length;
+        }
+        return found;
+    }
+
+    // Index of the first sample with a magnitude above threshold, or numSamples if there isn't one
+    template <typename SampleType>
+    static inline size_t findFirstNonZeroSample (const SampleType* data, size_t numSamples, SampleType threshold = 0)
+    {
+        constexpr size_t chunkSize = 64;
+        for (size_t chunkStart = 0; chunkStart < numSamples; chunkStart += chunkSize)
+        {
+            const auto chunkEnd = juce::jmin (chunkStart + chunkSize, numSamples);
+
+            bool anyNonZero = false;
+            for (size_t i = chunkStart; i < chunkEnd; ++i)
+                anyNonZero |= !(std::abs (data[i]) <= threshold);
+
+            if (anyNonZero)
+                for (size_t i = chunkStart; i < chunkEnd; ++i)
+                    if (!(std::abs (data[i]) <= threshold))
+                        return i;
+        }
+        return numSamples;
+    }
+
+    // A non-zero sample found where silence was expected
+    struct NonZeroSample
+    {
+        size_t channel = 0;
+        size_t sample = 0;
+    };
+
+    template <typename SampleType>
+    static inline std::optional<NonZeroSample> findFirstNonZeroSample (const juce::dsp::AudioBlock<SampleType>& block, size_t start = 0, size_t end = std::numeric_limits<size_t>::max())
+    {
+        end = juce::jmin (end, block.getNumSamples());
+        if (start >= end)
+            return std::nullopt;
+
+        for (size_t c = 0; c < block.getNumChannels(); ++c)
+        {
+            auto index = findFirstNonZeroSample (block.getChannelPointer (c) + start, end - start);
+            if (index < end - start)
+                return NonZeroSample { c, start + index };
+        }
+        return std::nullopt;
+    }
+}
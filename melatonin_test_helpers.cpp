@@ -0,0 +1,3 @@
+#include "melatonin_test_helpers.h"
+
+#include "melatonin/realtime_guard.cpp"
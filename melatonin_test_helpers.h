@@ -21,9 +21,52 @@ END_JUCE_MODULE_DECLARATION
 #include <juce_dsp/juce_dsp.h>
 #include <melatonin_audio_sparklines/melatonin_audio_sparklines.h>
 
+//==============================================================================
+/** Config: MELATONIN_REALTIME_GUARD
+
+    Replaces the global operator new and delete so RealtimeGuard and isRealtimeSafe can catch
+    allocations on the audio thread. Off by default, because replacing them affects the whole
+    binary. Turn it on in a test binary that doesn't replace them itself.
+*/
+#ifndef MELATONIN_REALTIME_GUARD
+    #define MELATONIN_REALTIME_GUARD 0
+#endif
+
+/** Config: MELATONIN_REALTIME_GUARD_LOCKS
+
+    On Linux, also interposes pthread_mutex_lock so RealtimeGuard catches locks on the audio thread.
+*/
+#ifndef MELATONIN_REALTIME_GUARD_LOCKS
+    #define MELATONIN_REALTIME_GUARD_LOCKS 0
+#endif
+
+#include "melatonin/parallel.h"
 #include "melatonin/AudioBlockFFT.h"
+#include "melatonin/AudioBlockSTFT.h"
+#include "melatonin/power_spectral_density.h"
+#include "melatonin/block_stats.h"
+#include "melatonin/sample_classification.h"
+#include "melatonin/sample_comparison.h"
+#include "melatonin/zero_runs.h"
+#include "melatonin/block_index.h"
+#include "melatonin/decay_analysis.h"
+#include "melatonin/goertzel.h"
+#include "melatonin/distortion_analysis.h"
+#include "melatonin/loudness.h"
+#include "melatonin/histogram.h"
+#include "melatonin/oscillators.h"
+#include "melatonin/signal_cache.h"
+#include "melatonin/streaming_stats.h"
 #include "melatonin/block_and_buffer_test_helpers.h"
+#include "melatonin/block_summary.h"
 #include "melatonin/block_and_buffer_matchers.h"
 #include "melatonin/vector_matchers.h"
+#include "melatonin/snapshots.h"
+#include "melatonin/null_test.h"
 #include "melatonin/mock_playheads.h"
+#include "melatonin/realtime_guard.h"
+#include "melatonin/processor_harness.h"
 #include "melatonin/parameter_test_helpers.h"
+#include "melatonin/parameter_sweep.h"
+#include "melatonin/latency_measurement.h"
+#include "melatonin/frequency_response.h"
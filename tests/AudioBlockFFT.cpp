@@ -0,0 +1,73 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("FFT finds a sine's bin", "[fft]")
+{
+    juce::AudioBuffer<float> buffer (1, 2048);
+    auto block = AudioBlock<float> (buffer);
+
+    SECTION ("at the default size of 2048")
+    {
+        // 43 cycles in 2048 samples puts it in the middle of bin 43
+        fillWithSine (block, 43.f * 48000.f / 2048.f, 48000.f);
+        auto fft = FFT<float> (block, 48000.f);
+        REQUIRE (fft.getSize() == 2048);
+        REQUIRE (fft.strongestFrequencyBin() == 43);
+        REQUIRE (fft.getMagnitude (43) == Catch::Approx (0.5f)); // scaled so the strongest bin is 0.5
+        REQUIRE (fft.frequencyNotPresent (5000.f));
+    }
+
+    SECTION ("at a configurable size")
+    {
+        fillWithSine (block, 10.f * 48000.f / 512.f, 48000.f);
+        auto fft = FFT<float> (block, 48000.f, true, false, 9);
+        REQUIRE (fft.getSize() == 512);
+        REQUIRE (fft.strongestFrequencyBin() == 10);
+        REQUIRE (fft.strongestFrequencyIs (10.f * 48000.f / 512.f));
+    }
+}
+
+TEST_CASE ("FFTPlanCache", "[fft]")
+{
+    auto& cache = FFTPlanCache::getInstance();
+
+    SECTION ("reuses engines on a thread and gives other threads their own")
+    {
+        auto engine = cache.getEngine (10);
+        REQUIRE (engine == cache.getEngine (10));
+        REQUIRE (engine != cache.getEngine (11));
+        REQUIRE (engine->getSize() == 1024);
+
+        std::shared_ptr<const juce::dsp::FFT> otherThreadsEngine;
+        std::thread ([&] { otherThreadsEngine = cache.getEngine (10); }).join();
+        REQUIRE (otherThreadsEngine != nullptr);
+        REQUIRE (otherThreadsEngine != engine);
+    }
+
+    SECTION ("shares window tables")
+    {
+        auto window = cache.getWindow (10, WindowingMethod::hann, false);
+        REQUIRE (window == cache.getWindow (10, WindowingMethod::hann, false));
+        REQUIRE (window != cache.getWindow (10, WindowingMethod::hann, true));
+        REQUIRE (window->size() == 1024);
+    }
+
+    SECTION ("a periodic cosine sum window averages to its first coefficient")
+    {
+        auto window = getBlackmanHarris7Window (10);
+        REQUIRE (window == getBlackmanHarris7Window (10));
+        auto mean = std::accumulate (window->begin(), window->end(), 0.0) / (double) window->size();
+        REQUIRE (mean == Catch::Approx (0.27105140069342).epsilon (1e-6));
+
+        std::vector<float> hann (8);
+        fillCosineSumWindow (hann.data(), hann.size(), { 0.5, 0.5 });
+        REQUIRE (hann[0] == Catch::Approx (0.0f).margin (1e-7));
+        REQUIRE (hann[2] == Catch::Approx (0.5f));
+        REQUIRE (hann[4] == Catch::Approx (1.0f));
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("STFT follows a change in frequency", "[stft]")
+{
+    // bin centers at order 10 and 48kHz are multiples of 46.875Hz
+    const float low = 20 * 46.875f;
+    const float high = 80 * 46.875f;
+
+    juce::AudioBuffer<float> buffer (2, 48000);
+    auto block = AudioBlock<float> (buffer);
+    auto firstHalf = block.getSubBlock (0, 24000);
+    auto secondHalf = block.getSubBlock (24000, 24000);
+    fillWithSine (firstHalf, low, 48000.f);
+    fillWithSine (secondHalf, high, 48000.f);
+    block.getSingleChannelBlock (1).multiplyBy (0.5f);
+
+    auto stft = STFT<float> (block, 48000.f, 10);
+
+    SECTION ("frames, hops and timing")
+    {
+        REQUIRE (stft.getFFTSize() == 1024);
+        REQUIRE (stft.getHopSize() == 256);
+        REQUIRE (stft.getNumChannels() == 2);
+        REQUIRE (stft.getNumFrames() == 1 + (48000 - 1024 + 255) / 256);
+        REQUIRE (stft.timeOfFrame (0) == Catch::Approx (512.0 / 48000.0));
+    }
+
+    SECTION ("a centered full scale sine reads as an amplitude of about 1")
+    {
+        REQUIRE (stft.strongestFrequencyBin (0, 0) == 20);
+        REQUIRE (stft.getMagnitude (0, 0, 20) == Catch::Approx (1.0f).margin (0.01));
+        REQUIRE (stft.getMagnitude (1, 0, 20) == Catch::Approx (0.5f).margin (0.01));
+        REQUIRE (stft.frequencyNotPresent (0, 0, high));
+    }
+
+    SECTION ("finds when the frequency changes")
+    {
+        auto lastFrame = stft.getNumFrames() - 1;
+        REQUIRE (stft.strongestFrequencyIs (0, lastFrame, high));
+
+        auto change = stft.firstFrameWhereStrongestFrequencyIs (0, high);
+        REQUIRE (change.has_value());
+        REQUIRE (stft.timeOfFrame (*change) == Catch::Approx (0.5).margin (1024.0 / 48000.0));
+        REQUIRE (stft.strongestFrequencies (1)[lastFrame] == Catch::Approx (high));
+    }
+}
+
+TEST_CASE ("STFT of a block shorter than a frame", "[stft]")
+{
+    juce::AudioBuffer<float> buffer (1, 100);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 1000.f, 48000.f);
+    auto stft = STFT<float> (block, 48000.f, 10);
+    REQUIRE (stft.getNumFrames() == 1);
+}
+
+#endif
@@ -1,3 +1,71 @@
 #if RUN_MELATONIN_TESTS
 
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("maxMagnitude and minMagnitude", "[helpers]")
+{
+    juce::AudioBuffer<float> buffer (2, 5);
+    auto block = AudioBlock<float> (buffer);
+
+    SECTION ("use the absolute value on every channel")
+    {
+        auto left = block.getSingleChannelBlock (0);
+        auto right = block.getSingleChannelBlock (1);
+        fillBlock (left, { 0.5f, -0.9f, 0.25f, 0.3f, -0.4f });
+        fillBlock (right, { 0.6f, 0.7f, -0.2f, 0.8f, 0.45f });
+
+        REQUIRE (maxMagnitude (block) == 0.9f);
+        REQUIRE (minMagnitude (block) == 0.2f);
+        REQUIRE (betweenMagnitudes (block, 0.2f, 0.9f));
+        REQUIRE_FALSE (betweenMagnitudes (block, 0.25f, 0.9f));
+        REQUIRE_FALSE (betweenMagnitudes (block, 0.2f, 0.85f));
+    }
+
+    SECTION ("a negative peak counts")
+    {
+        block.fill (0.1f);
+        block.setSample (1, 3, -1.5f);
+        REQUIRE (maxMagnitude (block) == 1.5f);
+        REQUIRE (minMagnitude (block) == 0.1f);
+    }
+}
+
+TEST_CASE ("rms", "[helpers]")
+{
+    juce::AudioBuffer<float> buffer (2, 48000);
+    auto block = AudioBlock<float> (buffer);
+
+    SECTION ("a sine is 1/sqrt(2) of its peak")
+    {
+        fillWithSine (block, 1000.f, 48000.f, 0.5f);
+        REQUIRE (rms (block) == Catch::Approx (0.5 / std::sqrt (2.0)).margin (0.0001));
+        REQUIRE (rmsInDB (block) == Catch::Approx (-9.03).margin (0.01));
+        REQUIRE_THAT (block, hasRMS (0.5 / std::sqrt (2.0)));
+    }
+
+    SECTION ("a constant is its own RMS")
+    {
+        block.fill (-0.25f);
+        REQUIRE (rms (block) == Catch::Approx (0.25f));
+    }
+}
+
+TEST_CASE ("blockIsEmpty", "[helpers]")
+{
+    juce::AudioBuffer<float> buffer (2, 1000);
+    buffer.clear();
+    auto block = AudioBlock<float> (buffer);
+    REQUIRE (blockIsEmpty (block));
+    REQUIRE_THAT (block, isEmpty());
+
+    block.setSample (1, 999, 0.0001f);
+    REQUIRE_FALSE (blockIsEmpty (block));
+
+    auto matcher = isEmpty();
+    REQUIRE_FALSE (matcher.match (block));
+    REQUIRE (matcher.describe().find ("channel 1 at sample 999") != std::string::npos);
+}
+
 #endif
@@ -0,0 +1,119 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+// Stretches of noise, silence and scattered zeros, so gaps and non-zeros land on, inside and across leaves
+static void fillWithPatches (AudioBlock<float>& block, juce::Random& random)
+{
+    for (size_t c = 0; c < block.getNumChannels(); ++c)
+    {
+        size_t i = 0;
+        while (i < block.getNumSamples())
+        {
+            const auto length = juce::jmin (block.getNumSamples() - i, (size_t) random.nextInt (700) + 1);
+            const auto kind = random.nextInt (4);
+            for (auto end = i + length; i < end; ++i)
+            {
+                auto value = random.nextFloat() * 2.0f - 1.0f;
+                if (kind == 0 || (kind == 1 && random.nextInt (3) == 0))
+                    value = 0;
+                block.setSample ((int) c, (int) i, value);
+            }
+        }
+    }
+}
+
+// filled means no two exact zeros in a row on any channel, with both samples inside the range
+static bool isFilledByHand (const AudioBlock<float>& block, size_t start, size_t end)
+{
+    for (size_t c = 0; c < block.getNumChannels(); ++c)
+        for (auto i = start + 1; i < end; ++i)
+            if (block.getSample ((int) c, (int) i) == 0 && block.getSample ((int) c, (int) i - 1) == 0)
+                return false;
+    return true;
+}
+
+TEST_CASE ("BlockIndex matches the whole block helpers", "[block_index]")
+{
+    juce::Random random (2024);
+    for (int trial = 0; trial < 40; ++trial)
+    {
+        const auto numChannels = random.nextInt (3) + 1;
+        const auto numSamples = random.nextInt (6000) + 1;
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        auto block = AudioBlock<float> (buffer);
+        fillWithPatches (block, random);
+        const auto index = BlockIndex<float> (block);
+
+        for (int query = 0; query < 50; ++query)
+        {
+            auto begin = (size_t) random.nextInt (numSamples + 1);
+            auto end = (size_t) random.nextInt (numSamples + 1);
+            if (begin > end)
+                std::swap (begin, end);
+            if (query == 0)
+                end = std::numeric_limits<size_t>::max(); // past the end is clamped
+
+            const auto clampedEnd = juce::jmin (end, (size_t) numSamples);
+            for (size_t c = 0; c < (size_t) numChannels; ++c)
+            {
+                const auto expected = calculateChannelStats (block.getChannelPointer (c) + begin, clampedEnd - begin);
+                const auto stats = index.stats (c, begin, end);
+                REQUIRE (stats.numSamples == expected.numSamples);
+                REQUIRE (stats.min == expected.min);
+                REQUIRE (stats.max == expected.max);
+                REQUIRE (stats.numZeros == expected.numZeros);
+                REQUIRE (stats.sum == Catch::Approx (expected.sum).margin (1e-9));
+                REQUIRE (stats.sumOfSquares == Catch::Approx (expected.sumOfSquares).margin (1e-9));
+            }
+
+            const auto gap = index.firstGap (begin, end);
+            const auto expectedGap = firstGap (block, begin, end);
+            REQUIRE (gap.has_value() == expectedGap.has_value());
+            if (gap.has_value())
+            {
+                REQUIRE (gap->channel == expectedGap->channel);
+                REQUIRE (gap->start == expectedGap->start);
+                REQUIRE (gap->length == expectedGap->length);
+            }
+
+            const auto nonZero = index.firstNonZeroSample (begin, end);
+            const auto expectedNonZero = findFirstNonZeroSample (block, begin, end);
+            REQUIRE (nonZero.has_value() == expectedNonZero.has_value());
+            if (nonZero.has_value())
+            {
+                REQUIRE (nonZero->channel == expectedNonZero->channel);
+                REQUIRE (nonZero->sample == expectedNonZero->sample);
+            }
+
+            REQUIRE (index.isSilent (begin, end) == !expectedNonZero.has_value());
+
+            if (begin < clampedEnd)
+            {
+                const auto filled = isFilledByHand (block, begin, clampedEnd);
+                REQUIRE (blockIsFilledBetween (block, (int) begin, (int) clampedEnd) == filled);
+                REQUIRE (blockIsFilledBetween (index, (int) begin, (int) clampedEnd) == filled);
+            }
+        }
+    }
+}
+
+TEST_CASE ("blockIsFilledBetween checks the whole range when it doesn't start at 0", "[block_index]")
+{
+    juce::AudioBuffer<float> buffer (1, 1000);
+    auto block = AudioBlock<float> (buffer);
+    block.fill (0.5f);
+
+    // a gap in the second half of [400, 1000), which a scan of end - start samples from start would never reach
+    block.setSample (0, 900, 0.f);
+    block.setSample (0, 901, 0.f);
+
+    REQUIRE_FALSE (blockIsFilledBetween (block, 400, 1000));
+    REQUIRE_FALSE (blockIsFilledBetween (BlockIndex<float> (block), 400, 1000));
+    REQUIRE (blockIsFilledBetween (block, 400, 901)); // only one of the zeros is inside
+    REQUIRE (blockIsFilledBetween (block, 901, 1000));
+}
+
+#endif
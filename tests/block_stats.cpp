@@ -0,0 +1,96 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("calculateChannelStats", "[block_stats]")
+{
+    SECTION ("a full scale sine has an RMS of 1/sqrt(2), a peak of 1 and no DC")
+    {
+        juce::AudioBuffer<float> buffer (1, 48000);
+        auto block = AudioBlock<float> (buffer);
+        fillWithSine (block, 1000.f, 48000.f); // exactly 1000 cycles
+
+        auto stats = calculateChannelStats (buffer.getReadPointer (0), 48000);
+        REQUIRE (stats.numSamples == 48000);
+        REQUIRE (stats.rms() == Catch::Approx (1.0 / std::sqrt (2.0)).margin (0.0001));
+        REQUIRE (stats.peak() == Catch::Approx (1.0f).margin (0.0001));
+        REQUIRE (stats.dcOffset() == Catch::Approx (0.0).margin (0.0001));
+        REQUIRE (stats.isValid());
+    }
+
+    SECTION ("known values, including the samples after the last full lane")
+    {
+        std::vector<float> values { 0.5f, -0.25f, 0.f, 1.f, -2.f, 0.f, 0.f, 0.25f, 0.f, 3.f, -1.f };
+        auto stats = calculateChannelStats (values.data(), values.size());
+        REQUIRE (stats.numSamples == 11);
+        REQUIRE (stats.min == -2.f);
+        REQUIRE (stats.max == 3.f);
+        REQUIRE (stats.sum == Catch::Approx (1.5));
+        REQUIRE (stats.sumOfSquares == Catch::Approx (0.25 + 0.0625 + 1 + 4 + 0.0625 + 9 + 1));
+        REQUIRE (stats.numZeros == 4);
+        REQUIRE (stats.peak() == 3.f);
+    }
+
+    SECTION ("counts NaNs, infs and subnormals")
+    {
+        std::vector<float> values (21, 0.1f);
+        values[2] = std::numeric_limits<float>::quiet_NaN();
+        values[9] = std::numeric_limits<float>::infinity();
+        values[17] = -std::numeric_limits<float>::infinity();
+        values[20] = std::numeric_limits<float>::denorm_min();
+        auto stats = calculateChannelStats (values.data(), values.size());
+        REQUIRE (stats.numNaNs == 1);
+        REQUIRE (stats.numInfs == 2);
+        REQUIRE (stats.numSubnormals == 1);
+        REQUIRE_FALSE (stats.isValid());
+    }
+
+    SECTION ("an empty range")
+    {
+        auto stats = calculateChannelStats<float> (nullptr, 0);
+        REQUIRE (stats.numSamples == 0);
+        REQUIRE (stats.rms() == 0.0);
+        REQUIRE (stats.isEmpty());
+    }
+}
+
+TEST_CASE ("BlockStats", "[block_stats]")
+{
+    juce::AudioBuffer<float> buffer (2, 1000);
+    buffer.clear();
+    buffer.setSample (0, 10, 0.5f);
+    buffer.setSample (1, 20, -0.75f);
+    auto stats = BlockStats<float> (AudioBlock<float> (buffer));
+
+    SECTION ("combines every channel")
+    {
+        REQUIRE (stats.getNumChannels() == 2);
+        REQUIRE (stats.getNumSamples() == 1000);
+        REQUIRE (stats.min() == -0.75f);
+        REQUIRE (stats.max() == 0.5f);
+        REQUIRE (stats.peak() == 0.75f);
+        REQUIRE (stats.numZeros() == 1998);
+        REQUIRE (stats.rms() == Catch::Approx (std::sqrt ((0.25 + 0.5625) / 2000.0)));
+        REQUIRE (stats.dcOffset() == Catch::Approx (-0.25 / 2000.0));
+        REQUIRE (stats.channel (1).min == -0.75f);
+    }
+
+    SECTION ("answers the free helpers")
+    {
+        REQUIRE (maxMagnitude (stats) == 0.75f);
+        REQUIRE (validAudio (stats));
+        REQUIRE_FALSE (blockIsEmpty (stats));
+        REQUIRE_THAT (stats, isValidAudio());
+    }
+
+    SECTION ("the isEmpty matcher says how many samples weren't zero")
+    {
+        auto matcher = isEmpty();
+        REQUIRE_FALSE (matcher.match (stats));
+        REQUIRE (matcher.describe().find ("Found 2 non-zero samples") != std::string::npos);
+    }
+}
+
+#endif
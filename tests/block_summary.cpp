@@ -0,0 +1,60 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("summarizeBlock", "[block_summary]")
+{
+    juce::AudioBuffer<float> buffer (2, 100000);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 440.f, 48000.f, 0.5f);
+
+    SECTION ("within the budget every number is exact")
+    {
+        buffer.setSample (1, 99999, 0.9f);
+        const auto summary = summarizeBlock (AudioBlock<const float> (block));
+        REQUIRE (summary.find ("2 channels of 100000 samples\n") == 0);
+        REQUIRE (summary.find ("sampled") == std::string::npos);
+        REQUIRE (summary.find ("max 0.9,") != std::string::npos);
+        REQUIRE (summary.find ("NaNs") == std::string::npos);
+    }
+
+    SECTION ("past the budget the stats are sampled and say so")
+    {
+        // 10 columns reading 50 samples each from the start of their 10000, so none of these are read
+        buffer.setSample (0, 5000, 0.9f);
+        buffer.setSample (0, 15000, std::numeric_limits<float>::quiet_NaN());
+
+        const auto summary = summarizeBlock (AudioBlock<const float> (block), 10, std::nullopt, 1000);
+        REQUIRE (summary.find ("(each column sampled from its first 50 samples)") != std::string::npos);
+        REQUIRE (summary.find ("max 0.9,") == std::string::npos);
+        REQUIRE (summary.find ("NaNs 0, infs 0, subnormals 0 (sampled)\n") != std::string::npos);
+    }
+
+    SECTION ("a BlockIndex gives exact totals at any length")
+    {
+        buffer.setSample (0, 5000, 0.9f);
+        buffer.setSample (0, 5001, -0.95f);
+        buffer.setSample (0, 15000, std::numeric_limits<float>::quiet_NaN());
+        buffer.setSample (1, 25000, std::numeric_limits<float>::infinity());
+
+        const auto summary = summarizeBlock (BlockIndex<float> (block), 10);
+        REQUIRE (summary.find ("sampled") == std::string::npos);
+        REQUIRE (summary.find ("max 0.9,") != std::string::npos);
+        REQUIRE (summary.find ("min -0.95,") != std::string::npos);
+        REQUIRE (summary.find ("NaNs 1, infs 0") != std::string::npos);
+        REQUIRE (summary.find ("NaNs 0, infs 1") != std::string::npos);
+    }
+
+    SECTION ("columns show the peak of their range")
+    {
+        block.clear();
+        buffer.setSample (0, 0, 2.0f);
+        buffer.setSample (0, 99999, 0.1f);
+        const auto summary = summarizeBlock (AudioBlock<const float> (block.getSingleChannelBlock (0)), 4);
+        REQUIRE (summary.find ("0: !__▁\n") != std::string::npos);
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+// An exponential decay that falls 60dB in rt60 seconds, so its Schroeder curve is a straight line
+static void fillWithDecay (AudioBlock<float>& block, double rt60, double sampleRate)
+{
+    const auto perSample = std::pow (10.0, -3.0 / (rt60 * sampleRate));
+    for (size_t c = 0; c < block.getNumChannels(); ++c)
+    {
+        double value = 1.0;
+        for (size_t i = 0; i < block.getNumSamples(); ++i, value *= perSample)
+            block.setSample ((int) c, (int) i, (float) (i % 2 == 0 ? value : -value));
+    }
+}
+
+TEST_CASE ("analyzeDecay", "[decay_analysis]")
+{
+    juce::AudioBuffer<float> buffer (2, 48000);
+    auto block = AudioBlock<float> (buffer);
+    fillWithDecay (block, 0.5, 48000.0);
+
+    SECTION ("a known decay")
+    {
+        auto analysis = analyzeDecay (block, 48000.0);
+        REQUIRE (analysis.rt60() == Catch::Approx (0.5).epsilon (0.001));
+        REQUIRE (analysis.t20 == Catch::Approx (0.5).epsilon (0.001));
+        REQUIRE (analysis.edt == Catch::Approx (0.5).epsilon (0.001));
+        REQUIRE (analysis.slope == Catch::Approx (-120.0).epsilon (0.001));
+
+        // the amplitude reaches -90dB at 0.75s
+        REQUIRE (analysis.tailEndInSeconds() == Catch::Approx (0.75).margin (0.001));
+    }
+
+    SECTION ("a noise floor below the threshold doesn't stretch it")
+    {
+        juce::AudioBuffer<float> withFloor (2, 48000 * 20);
+        auto floorBlock = AudioBlock<float> (withFloor);
+        floorBlock.fill (0.0005f); // -66dB, with 20 seconds of it worth -37dB of the decay's energy
+        floorBlock.getSubBlock (0, 48000).copyFrom (block);
+        for (size_t i = 0; i < 48000; ++i)
+            for (int c = 0; c < 2; ++c)
+                if (std::abs (withFloor.getSample (c, (int) i)) < 0.0005f)
+                    withFloor.setSample (c, (int) i, 0.0005f);
+
+        auto analysis = analyzeDecay (floorBlock, 48000.0, -60.0);
+        REQUIRE (analysis.tailEndInSeconds() == Catch::Approx (0.5).margin (0.001));
+        REQUIRE (analysis.rt60() == Catch::Approx (0.5).epsilon (0.01));
+    }
+
+    SECTION ("matches the energy decay curve")
+    {
+        auto curve = energyDecayCurve (block);
+        REQUIRE (curve.size() == 48000);
+        REQUIRE (curve.front() == 0.0f);
+        REQUIRE (curve[12000] == Catch::Approx (-30.0).margin (0.01));
+        REQUIRE (std::is_sorted (curve.rbegin(), curve.rend()));
+    }
+
+    SECTION ("channels are combined")
+    {
+        block.getSingleChannelBlock (1).clear();
+        auto curve = energyDecayCurve (block);
+        REQUIRE (curve[12000] == Catch::Approx (-30.0).margin (0.01));
+        REQUIRE (analyzeDecay (block, 48000.0).rt60() == Catch::Approx (0.5).epsilon (0.001));
+    }
+
+    SECTION ("silence has nothing to measure")
+    {
+        block.clear();
+        auto analysis = analyzeDecay (block, 48000.0);
+        REQUIRE (analysis.tailEnd == 0);
+        REQUIRE (analysis.rt60() == 0);
+        REQUIRE (energyDecayCurve (block).front() == -400.0f);
+    }
+}
+
+TEST_CASE ("decay matchers", "[decay_analysis]")
+{
+    juce::AudioBuffer<float> buffer (1, 96000);
+    auto block = AudioBlock<float> (buffer);
+    fillWithDecay (block, 1.0, 48000.0);
+
+    SECTION ("hasRT60Between")
+    {
+        REQUIRE_THAT (block, hasRT60Between (0.95, 1.05, 48000.0));
+        auto matcher = hasRT60Between (1.5, 2.0, 48000.0);
+        REQUIRE_FALSE (matcher.match (block));
+        REQUIRE (matcher.describe().find ("RT60 is 1") != std::string::npos);
+    }
+
+    SECTION ("decaysBelow")
+    {
+        // -90dB arrives at 1.5s
+        REQUIRE_THAT (block, decaysBelow (-80_dB).within (48000 * 3 / 2));
+        REQUIRE_FALSE (decaysBelow (-90_dB).within (48000).match (block));
+        REQUIRE_FALSE (decaysBelow (-130_dB).match (block)); // still at -120dB at the end
+    }
+}
+
+#endif
@@ -0,0 +1,110 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+static_assert (-80_dB == -80.0);
+static_assert (melatonin::literals::operator""_dB (0.5L) == 0.5);
+static_assert (melatonin::literals::operator""_dB_per_octave (3ULL) == 3.0);
+
+TEST_CASE ("analyzeDistortion", "[distortion]")
+{
+    juce::AudioBuffer<float> buffer (1, 65536);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 1000.f, 48000.f, 0.5f);
+
+    SECTION ("a clean sine has nothing but its fundamental")
+    {
+        auto analysis = analyzeDistortion (block, 48000.0);
+        REQUIRE (analysis.fundamentalFrequency == Catch::Approx (1000.0).margin (0.5));
+        REQUIRE (analysis.fundamentalLevel == Catch::Approx (-6.02).margin (0.05));
+        REQUIRE (analysis.harmonicLevels.size() == 9);
+        REQUIRE (analysis.thd < -110.0);
+        REQUIRE (analysis.snr > 110.0);
+    }
+
+    SECTION ("a 2nd harmonic 40dB down reads as -40dB THD")
+    {
+        addSineToBlock (block, 2000.f, 48000.f, 0.005f);
+        auto analysis = analyzeDistortion (block, 48000.0);
+        REQUIRE (analysis.thd == Catch::Approx (-40.0).margin (0.1));
+        REQUIRE (analysis.thdPercent() == Catch::Approx (1.0).margin (0.02));
+        REQUIRE (analysis.harmonicLevels[0] == Catch::Approx (-46.02).margin (0.1));
+        REQUIRE (analysis.harmonicLevels[1] < -110.0);
+    }
+
+    SECTION ("harmonics add up by power")
+    {
+        addSineToBlock (block, 2000.f, 48000.f, 0.005f);
+        addSineToBlock (block, 3000.f, 48000.f, 0.005f);
+        auto analysis = analyzeDistortion (block, 48000.0);
+        REQUIRE (analysis.thd == Catch::Approx (-36.99).margin (0.1));
+        REQUIRE (analysis.harmonicLevels[1] == Catch::Approx (-46.02).margin (0.1));
+    }
+
+    SECTION ("noise shows up in THD+N and SNR but not THD")
+    {
+        // uniform noise of ±0.01 has a mean square of 0.0001 / 3, the sine 0.125, so an SNR of 35.7dB
+        juce::Random random (42);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.getWritePointer (0)[i] += (random.nextFloat() * 2.0f - 1.0f) * 0.01f;
+
+        auto analysis = analyzeDistortion (block, 48000.0);
+        REQUIRE (analysis.snr == Catch::Approx (35.7).margin (0.3));
+        REQUIRE (analysis.thdPlusNoise == Catch::Approx (-35.7).margin (0.3));
+        REQUIRE (analysis.thd < analysis.thdPlusNoise - 20.0); // only the noise under the harmonics' lobes
+    }
+
+    SECTION ("frequencies are in Hz at the given sample rate")
+    {
+        auto analysis = analyzeDistortion (block, 96000.0);
+        REQUIRE (analysis.fundamentalFrequency == Catch::Approx (2000.0).margin (1.0));
+    }
+
+    SECTION ("too short to analyze")
+    {
+        auto analysis = analyzeDistortion (block.getSubBlock (0, 32), 48000.0);
+        REQUIRE (analysis.fundamentalLevel == -400.0);
+    }
+}
+
+TEST_CASE ("distortion matchers", "[distortion]")
+{
+    juce::AudioBuffer<float> buffer (2, 65536);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 1000.f, 48000.f, 0.5f);
+    auto right = block.getSingleChannelBlock (1);
+    addSineToBlock (right, 3000.f, 48000.f, 0.005f);
+
+    SECTION ("the worst channel decides")
+    {
+        REQUIRE_THAT (block.getSingleChannelBlock (0), hasTHDBelow (-100_dB, 48000.0));
+        REQUIRE_THAT (block, hasTHDBelow (-39_dB, 48000.0));
+        REQUIRE_FALSE (hasTHDBelow (-41_dB, 48000.0).match (buffer));
+        REQUIRE_THAT (block, hasTHDPlusNoiseBelow (-39_dB, 48000.0));
+        REQUIRE_FALSE (hasTHDPlusNoiseBelow (-41_dB, 48000.0).match (block));
+    }
+
+    SECTION ("SNR")
+    {
+        REQUIRE_THAT (block.getSingleChannelBlock (0), hasSNRAbove (100_dB, 48000.0));
+        REQUIRE_FALSE (hasSNRAbove (200_dB, 48000.0).match (block.getSingleChannelBlock (0)));
+    }
+
+    SECTION ("describes the worst channel")
+    {
+        auto matcher = hasTHDBelow (-41_dB, 48000.0);
+        REQUIRE_FALSE (matcher.match (block));
+        REQUIRE (matcher.describe().find ("Channel 1: fundamental 1000.0Hz at -6.0 dBFS, THD -40.0 dB") != std::string::npos);
+        REQUIRE (matcher.describe().find ("H3 -46.0") != std::string::npos);
+    }
+
+    SECTION ("silence fails")
+    {
+        block.clear();
+        REQUIRE_FALSE (hasTHDBelow (0_dB, 48000.0).match (block));
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include "test_processors.h"
+
+using namespace melatonin;
+
+TEST_CASE ("measureFrequencyResponse", "[frequency_response]")
+{
+    SECTION ("a processor that does nothing is flat")
+    {
+        TestProcessor processor;
+        auto responses = measureFrequencyResponse (processor, 48000.0);
+        REQUIRE (responses.size() == 2);
+        REQUIRE (responses[0].delay == 0);
+        REQUIRE_THAT (responses, hasMagnitudeResponseWithin (ResponseCurve::flat (0.1)));
+        REQUIRE_THAT (responses, hasPhaseResponseWithin (ResponseCurve::flat (1.0)));
+    }
+
+    SECTION ("gain shows up as a level")
+    {
+        GainProcessor processor;
+        *processor.gain = 0.5f;
+        auto responses = measureFrequencyResponse (processor, 48000.0);
+        REQUIRE_THAT (responses, hasMagnitudeResponseWithin (ResponseCurve::flat (0.1, 20.0, 20000.0, -6.02)));
+        REQUIRE_FALSE (hasMagnitudeResponseWithin (ResponseCurve::flat (0.5)).match (responses));
+    }
+
+    SECTION ("latency is found and taken out of the phase")
+    {
+        DelayProcessor processor (37);
+        auto responses = measureFrequencyResponse (processor, 48000.0);
+        REQUIRE (responses[1].delay == 37);
+        REQUIRE (responses[1].phaseAt (1000.0) == Catch::Approx (0.0).margin (1.0));
+        REQUIRE_THAT (responses, hasMagnitudeResponseWithin (ResponseCurve::flat (0.1)));
+    }
+
+    SECTION ("leaves the processor without a playhead, released")
+    {
+        DelayProcessor processor (10);
+        measureFrequencyResponse (processor, 48000.0);
+        REQUIRE (processor.getPlayHead() == nullptr);
+        REQUIRE (processor.numPrepares == 1);
+        REQUIRE (processor.numReleases == 1);
+    }
+}
+
+#endif
@@ -0,0 +1,59 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("Goertzel magnitudes", "[goertzel]")
+{
+    juce::AudioBuffer<float> buffer (2, 4800);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 1000.f, 48000.f, 0.5f);
+    auto left = block.getSingleChannelBlock (0);
+    addSineToBlock (left, 3000.f, 48000.f, 0.25f);
+
+    SECTION ("a sine reads as its amplitude")
+    {
+        REQUIRE (goertzelMagnitude (buffer.getReadPointer (1), 4800, 1000.f, 48000.f) == Catch::Approx (0.5f).margin (0.001));
+        REQUIRE (magnitudeOfFrequency (block, 3000.f, 48000.f) == Catch::Approx (0.25f).margin (0.001));
+    }
+
+    SECTION ("frequencies that aren't there read as nothing")
+    {
+        REQUIRE (magnitudeOfFrequency (block, 2000.f, 48000.f) < 0.001f);
+        REQUIRE (magnitudeOfFrequency (block, 5000.f, 48000.f) < 0.001f);
+        REQUIRE (magnitudeOfFrequency (block, 1234.f, 48000.f) < 0.02f); // not a whole number of samples per cycle
+    }
+
+    SECTION ("many frequencies in one pass match one at a time")
+    {
+        std::vector<float> frequencies { 3000.f, 440.f, 1000.f, 2000.f, 20.f };
+        auto magnitudes = magnitudesOfFrequencies (block, frequencies, 48000.f);
+        for (size_t i = 0; i < frequencies.size(); ++i)
+            REQUIRE (magnitudes[i] == Catch::Approx (magnitudeOfFrequency (block, frequencies[i], 48000.f)).margin (1e-6));
+    }
+}
+
+TEST_CASE ("hasFrequencies", "[goertzel]")
+{
+    juce::AudioBuffer<float> buffer (1, 4800);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 1000.f, 48000.f, 0.5f);
+
+    REQUIRE_THAT (block, hasFrequencies ({ 1000.f }, 48000.f));
+    REQUIRE_THAT (block, hasFrequencies ({ 1000.f }, { 0.5f }, 48000.f));
+
+    SECTION ("rejects a frequency that isn't there")
+    {
+        auto matcher = hasFrequencies ({ 1000.f, 1500.f }, 48000.f);
+        REQUIRE_FALSE (matcher.match (block));
+        REQUIRE (matcher.describe().find ("1500Hz at least 0.1 (was") != std::string::npos);
+    }
+
+    SECTION ("rejects the wrong magnitude")
+    {
+        REQUIRE_FALSE (hasFrequencies ({ 1000.f }, { 0.4f }, 48000.f).match (block));
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("Histogram", "[histogram]")
+{
+    juce::AudioBuffer<float> buffer (1, 8);
+    const float values[] = { -2.f, -1.f, -0.5f, 0.f, 0.25f, 1.f, 3.f, std::numeric_limits<float>::quiet_NaN() };
+    for (int i = 0; i < 8; ++i)
+        buffer.setSample (0, i, values[i]);
+
+    Histogram histogram (4, -1.0, 1.0);
+    histogram.add (buffer);
+
+    REQUIRE (histogram.underflow() == 1);
+    REQUIRE (histogram.count (0) == 1);
+    REQUIRE (histogram.count (1) == 1);
+    REQUIRE (histogram.count (2) == 2);
+    REQUIRE (histogram.count (3) == 1); // the top of the range lands in the last bin
+    REQUIRE (histogram.overflow() == 1);
+    REQUIRE (histogram.numNaNs() == 1);
+    REQUIRE (histogram.total() == 7);
+}
+
+TEST_CASE ("regularizedGammaQ", "[histogram]")
+{
+    SECTION ("closed forms")
+    {
+        // Q(1, x) is e^-x, Q(3, x) is e^-x (1 + x + x^2 / 2) and Q(0.5, x) is erfc (sqrt (x))
+        REQUIRE (regularizedGammaQ (1.0, 1.0) == Catch::Approx (0.36787944117144233).epsilon (1e-12));
+        REQUIRE (regularizedGammaQ (1.0, 5.0) == Catch::Approx (0.006737946999085467).epsilon (1e-12));
+        REQUIRE (regularizedGammaQ (3.0, 2.0) == Catch::Approx (0.6766764161830635).epsilon (1e-12));
+        REQUIRE (regularizedGammaQ (0.5, 2.0) == Catch::Approx (std::erfc (std::sqrt (2.0))).epsilon (1e-12));
+        REQUIRE (regularizedGammaQ (0.5, 0.1) == Catch::Approx (std::erfc (std::sqrt (0.1))).epsilon (1e-12));
+        REQUIRE (regularizedGammaQ (2.0, 0.0) == 1.0);
+    }
+
+    SECTION ("tabulated chi-square critical values")
+    {
+        // p-value of chi-square x with k degrees of freedom is Q(k / 2, x / 2)
+        REQUIRE (regularizedGammaQ (0.5, 3.841458820694124 / 2) == Catch::Approx (0.05).epsilon (1e-9));
+        REQUIRE (regularizedGammaQ (0.5, 0.454936423119572 / 2) == Catch::Approx (0.5).epsilon (1e-9));
+        REQUIRE (regularizedGammaQ (1.0, 9.210340371976184 / 2) == Catch::Approx (0.01).epsilon (1e-9));
+        REQUIRE (regularizedGammaQ (5.0, 18.307038053275146 / 2) == Catch::Approx (0.05).epsilon (1e-9));
+        REQUIRE (regularizedGammaQ (50.0, 124.34211340400407 / 2) == Catch::Approx (0.05).epsilon (1e-9));
+    }
+}
+
+TEST_CASE ("isDistributed", "[histogram]")
+{
+    juce::AudioBuffer<float> uniform (2, 50000), gaussian (2, 50000);
+    juce::Random random (1234);
+    for (int c = 0; c < 2; ++c)
+    {
+        for (int i = 0; i < uniform.getNumSamples(); ++i)
+            uniform.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+
+        // Box-Muller
+        for (int i = 0; i < gaussian.getNumSamples(); ++i)
+        {
+            const auto u1 = juce::jmax (1e-12, random.nextDouble()), u2 = random.nextDouble();
+            gaussian.setSample (c, i, (float) (0.25 * std::sqrt (-2.0 * std::log (u1)) * std::cos (juce::MathConstants<double>::twoPi * u2)));
+        }
+    }
+
+    SECTION ("uniform noise is uniform")
+    {
+        REQUIRE_THAT (uniform, isDistributed (Uniform (-1, 1)));
+        REQUIRE_FALSE (isDistributed (Gaussian (0, 0.25)).match (uniform));
+    }
+
+    SECTION ("gaussian noise is gaussian")
+    {
+        REQUIRE_THAT (gaussian, isDistributed (Gaussian (0, 0.25)));
+        REQUIRE_FALSE (isDistributed (Uniform (-1, 1)).match (gaussian));
+        REQUIRE_FALSE (isDistributed (Gaussian (0, 0.3)).match (gaussian));
+    }
+
+    SECTION ("describes both tests")
+    {
+        auto matcher = isDistributed (Gaussian (0, 0.25));
+        REQUIRE_FALSE (matcher.match (uniform));
+        REQUIRE (matcher.result.numSamples == 100000);
+        REQUIRE (matcher.result.pValue() < 0.01);
+        REQUIRE (matcher.describe().find ("is distributed as Gaussian(0, 0.25)") != std::string::npos);
+    }
+
+    SECTION ("silence fails")
+    {
+        uniform.clear();
+        REQUIRE_FALSE (isDistributed (Uniform (-1, 1)).match (uniform));
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include "test_processors.h"
+
+using namespace melatonin;
+
+TEST_CASE ("measureLatency", "[latency_measurement]")
+{
+    SECTION ("chirp")
+    {
+        DelayProcessor processor (100);
+        auto latency = measureLatency (processor, 48000.0, 64);
+        REQUIRE (latency.reported == 100);
+        REQUIRE (latency.measured == Catch::Approx (100).margin (0.01));
+    }
+
+    SECTION ("impulse")
+    {
+        DelayProcessor processor (333);
+        auto latency = measureLatency (processor, 96000.0, 480, LatencyProbe::impulse);
+        REQUIRE (latency.measured == Catch::Approx (333).margin (0.01));
+    }
+
+    SECTION ("no latency")
+    {
+        TestProcessor processor;
+        REQUIRE (measureLatency (processor).measured == Catch::Approx (0).margin (0.01));
+    }
+
+    SECTION ("leaves the processor without a playhead")
+    {
+        DelayProcessor processor (10);
+        measureLatency (processor);
+        REQUIRE (processor.getPlayHead() == nullptr);
+        REQUIRE (processor.numReleases == 1);
+    }
+}
+
+TEST_CASE ("reportsCorrectLatency", "[latency_measurement]")
+{
+    SECTION ("passes when the reported latency is right")
+    {
+        DelayProcessor processor (100);
+        REQUIRE_THAT (processor, reportsCorrectLatency());
+    }
+
+    SECTION ("fails when it isn't")
+    {
+        DelayProcessor processor (100, 90);
+        auto matcher = reportsCorrectLatency();
+        REQUIRE_FALSE (matcher.match (processor));
+        REQUIRE (matcher.describe().find ("up to 65536 samples of latency") != std::string::npos);
+        REQUIRE (matcher.describe().find ("Reported 90 samples, measured 100") != std::string::npos);
+    }
+
+    SECTION ("double precision")
+    {
+        DelayProcessor processor (100);
+        REQUIRE_THAT (processor, reportsCorrectLatency<double> (0.01, 48000.0, 128));
+        DelayProcessor wrong (100, 101);
+        REQUIRE_FALSE (reportsCorrectLatency<double> (0.01, 48000.0, 128, LatencyProbe::impulse).match (wrong));
+    }
+}
+
+#endif
@@ -0,0 +1,120 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("LoudnessMeter", "[loudness]")
+{
+    // BS.1770's known answer: a 997Hz sine at -20dBFS on one channel reads -23 LUFS
+    juce::AudioBuffer<float> buffer (1, 48000 * 10);
+    auto block = AudioBlock<float> (buffer);
+    fillWithSine (block, 997.f, 48000.f, 0.1f);
+
+    SECTION ("997Hz at -20dBFS reads -23 LUFS")
+    {
+        LoudnessMeter meter (48000);
+        meter.push (buffer);
+        REQUIRE (meter.integratedLoudness() == Catch::Approx (-23.0).margin (0.05));
+        REQUIRE (meter.momentaryLoudness() == Catch::Approx (-23.0).margin (0.05));
+        REQUIRE (meter.shortTermLoudness() == Catch::Approx (-23.0).margin (0.05));
+        REQUIRE (meter.truePeakInDB() == Catch::Approx (-20.0).margin (0.1));
+        REQUIRE_THAT (meter, hasIntegratedLoudness (-23.0, 0.1, 48000));
+    }
+
+    SECTION ("a second channel adds 3 LU")
+    {
+        juce::AudioBuffer<float> stereo (2, buffer.getNumSamples());
+        auto stereoBlock = AudioBlock<float> (stereo);
+        fillWithSine (stereoBlock, 997.f, 48000.f, 0.1f);
+        REQUIRE_THAT (stereo, hasIntegratedLoudness (-20.0, 0.05, 48000));
+    }
+
+    SECTION ("block size doesn't change the answer")
+    {
+        LoudnessMeter whole (48000), inPieces (48000);
+        whole.push (block);
+        for (size_t start = 0, size = 1; start < block.getNumSamples(); start += size, size = size * 3 % 4099 + 1)
+            inPieces.push (block.getSubBlock (start, juce::jmin (size, block.getNumSamples() - start)));
+
+        REQUIRE (inPieces.getNumSamples() == whole.getNumSamples());
+        REQUIRE (inPieces.integratedLoudness() == Catch::Approx (whole.integratedLoudness()).margin (1e-9));
+        REQUIRE (inPieces.maxMomentaryLoudness() == Catch::Approx (whole.maxMomentaryLoudness()).margin (1e-9));
+        REQUIRE (inPieces.truePeak() == whole.truePeak());
+    }
+
+    SECTION ("silence is gated out")
+    {
+        LoudnessMeter meter (48000);
+        meter.push (buffer);
+        block.clear();
+        meter.push (buffer);
+
+        // the 3 blocks straddling the edge pass the gates, pulling it down by 0.07 LU
+        REQUIRE (meter.integratedLoudness() == Catch::Approx (-23.07).margin (0.02));
+        REQUIRE (meter.momentaryLoudness() == LoudnessMeter::silence);
+        REQUIRE (meter.maxMomentaryLoudness() == Catch::Approx (-23.0).margin (0.05));
+    }
+
+    SECTION ("anything 10 LU under the rest is gated out")
+    {
+        LoudnessMeter meter (48000);
+        meter.push (buffer);
+        block.multiplyBy (0.1f); // -43 LUFS
+        meter.push (buffer);
+        REQUIRE (meter.integratedLoudness() == Catch::Approx (-23.0).margin (0.1));
+    }
+
+    SECTION ("nothing at all")
+    {
+        LoudnessMeter meter (48000);
+        REQUIRE (meter.integratedLoudness() == LoudnessMeter::silence);
+        REQUIRE (meter.truePeakInDB() == LoudnessMeter::silence);
+    }
+}
+
+TEST_CASE ("true peak", "[loudness]")
+{
+    // a quarter of the sample rate, sampled 45 degrees off its peaks, never has a sample above -3dB
+    juce::AudioBuffer<float> buffer (1, 4800);
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+        buffer.setSample (0, i, (float) std::sin (juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4));
+    REQUIRE (buffer.getMagnitude (0, buffer.getNumSamples()) < 0.71f);
+
+    SECTION ("finds the peaks between the samples")
+    {
+        REQUIRE_FALSE (truePeakBelow (-0.5, 48000).match (buffer));
+        REQUIRE_THAT (buffer, truePeakBelow (0.5, 48000));
+    }
+
+    SECTION ("describes what it found")
+    {
+        auto matcher = truePeakBelow (-1.0, 48000);
+        REQUIRE_FALSE (matcher.match (buffer));
+        REQUIRE (matcher.describe().find ("has a true peak below -1 dBTP") != std::string::npos);
+    }
+
+    SECTION ("counts a peak in the last samples of the block")
+    {
+        // the oversampling filter lags by 8 samples, so these are only reached by reading what's pending
+        for (int fromEnd = 1; fromEnd <= 8; ++fromEnd)
+        {
+            buffer.clear();
+            buffer.setSample (0, buffer.getNumSamples() - fromEnd, 1.0f);
+
+            LoudnessMeter meter (48000), unread (48000);
+            meter.push (buffer);
+            unread.push (buffer);
+            REQUIRE (meter.truePeakInDB() == Catch::Approx (0.0).margin (0.01));
+            REQUIRE_FALSE (truePeakBelow (-1.0, 48000).match (buffer));
+
+            // reading it leaves the history for the next push alone
+            buffer.clear();
+            meter.push (buffer);
+            unread.push (buffer);
+            REQUIRE (meter.truePeak() == unread.truePeak());
+        }
+    }
+}
+
+#endif
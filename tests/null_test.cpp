@@ -0,0 +1,90 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+namespace
+{
+    // a windowed burst, evaluated at any (fractional) time so it can be delayed exactly
+    double burst (double t, double centre)
+    {
+        const auto x = (t - centre) / 40.0;
+        return std::exp (-x * x) * std::sin (0.3 * t);
+    }
+
+    juce::AudioBuffer<float> renderBursts (size_t numSamples, double delay, const std::vector<double>& centres)
+    {
+        juce::AudioBuffer<float> buffer (2, (int) numSamples);
+        buffer.clear();
+        for (auto centre : centres)
+            for (auto i = (size_t) juce::jmax (0.0, centre + delay - 400); i < juce::jmin (numSamples, (size_t) (centre + delay + 400)); ++i)
+                for (int c = 0; c < 2; ++c)
+                    buffer.getWritePointer (c)[i] += (float) burst ((double) i - delay, centre);
+        return buffer;
+    }
+
+    double latencyBetween (juce::AudioBuffer<float>& signal, juce::AudioBuffer<float>& reference, size_t maxLag = 65536)
+    {
+        return estimateLatency (AudioBlock<const float> (AudioBlock<float> (signal)), AudioBlock<const float> (AudioBlock<float> (reference)), maxLag);
+    }
+}
+
+TEST_CASE ("estimateLatency", "[null_test]")
+{
+    auto reference = renderBursts (4000, 0, { 1000, 1300, 2500 });
+
+    SECTION ("whole samples late")
+    {
+        auto signal = renderBursts (4000, 37, { 1000, 1300, 2500 });
+        REQUIRE (latencyBetween (signal, reference) == Catch::Approx (37).margin (0.01));
+    }
+
+    SECTION ("early")
+    {
+        auto signal = renderBursts (4000, -20, { 1000, 1300, 2500 });
+        REQUIRE (latencyBetween (signal, reference) == Catch::Approx (-20).margin (0.01));
+    }
+
+    SECTION ("a fraction of a sample")
+    {
+        auto signal = renderBursts (4000, 10.25, { 1000, 1300, 2500 });
+        REQUIRE (latencyBetween (signal, reference) == Catch::Approx (10.25).margin (0.01));
+    }
+
+    SECTION ("long renders only correlate a segment")
+    {
+        // 2 minutes at 48kHz, which used to need a 2^24 point transform
+        constexpr size_t length = 48000 * 120;
+        auto longReference = renderBursts (length, 0, { 300000, 300500, 301000, 5000000 });
+        auto longSignal = renderBursts (length, 1234, { 300000, 300500, 301000, 5000000 });
+        REQUIRE (latencyBetween (longSignal, longReference) == Catch::Approx (1234).margin (0.01));
+    }
+
+    SECTION ("lags beyond the default need a bigger maxLag")
+    {
+        constexpr size_t length = 400000;
+        auto farReference = renderBursts (length, 0, { 1000, 1300 });
+        auto farSignal = renderBursts (length, 100000, { 1000, 1300 });
+        REQUIRE (latencyBetween (farSignal, farReference, 131072) == Catch::Approx (100000).margin (0.01));
+    }
+}
+
+TEST_CASE ("nullTest", "[null_test]")
+{
+    auto reference = renderBursts (4000, 0, { 1000, 1300, 2500 });
+    auto signal = renderBursts (4000, 64, { 1000, 1300, 2500 });
+
+    auto result = nullTest (AudioBlock<const float> (AudioBlock<float> (signal)), AudioBlock<const float> (AudioBlock<float> (reference)));
+    REQUIRE (result.latency == 64);
+    REQUIRE (result.numComparedSamples == 4000 - 64);
+    REQUIRE (result.residualRMSInDB() < -120);
+
+    REQUIRE_THAT (signal, nullsAgainst (reference, -100.0));
+
+    auto different = renderBursts (4000, 64, { 1000, 1300 });
+    auto matcher = nullsAgainst (reference, -100.0);
+    REQUIRE_FALSE (matcher.match (different));
+}
+
+#endif
@@ -0,0 +1,114 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+namespace
+{
+    // worst difference from std::sin (or cos) over a long render, streamed in odd sized blocks
+    template <typename SampleType>
+    double worstErrorOverLongRender (float frequency, bool cosine, size_t totalSamples)
+    {
+        constexpr double rate = 48000.0;
+        auto osc = Oscillator<SampleType> (frequency, (float) rate, 0.5f);
+        juce::AudioBuffer<SampleType> buffer (1, 1001);
+        double worst = 0;
+
+        for (size_t done = 0; done < totalSamples; done += 1001)
+        {
+            auto block = AudioBlock<SampleType> (buffer);
+            cosine ? osc.renderCosine (block) : osc.renderSine (block);
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                // phase computed from the sample count in long double, so it's exact enough to be the reference
+                const auto n = (long double) (done + i);
+                const auto angle = (double) std::fmod (n * (long double) frequency / (long double) rate, 1.0L) * juce::MathConstants<double>::twoPi;
+                const auto expected = 0.5 * (cosine ? std::cos (angle) : std::sin (angle));
+                worst = std::max (worst, std::abs ((double) block.getSample (0, (int) i) - expected));
+            }
+        }
+        return worst;
+    }
+}
+
+TEST_CASE ("Oscillator sines stay accurate over long renders", "[oscillators]")
+{
+    // 10 minutes at 48kHz, so the phasors get reseeded (every 256 samples) over 100,000 times
+    constexpr size_t tenMinutes = 48000 * 600;
+
+    // the double phase accumulator drifts by a few 1e-9 radians over this long, well below -160dB
+    SECTION ("double")
+    {
+        REQUIRE (worstErrorOverLongRender<double> (997.f, false, tenMinutes) < 1e-8);
+        REQUIRE (worstErrorOverLongRender<double> (20000.f, true, tenMinutes) < 1e-8);
+    }
+
+    SECTION ("float")
+    {
+        REQUIRE (worstErrorOverLongRender<float> (440.f, false, tenMinutes) < 1e-6);
+        REQUIRE (worstErrorOverLongRender<float> (13.f, true, tenMinutes) < 1e-6);
+    }
+}
+
+TEST_CASE ("Oscillator carries phase across blocks", "[oscillators]")
+{
+    juce::AudioBuffer<float> whole (2, 1000), pieces (2, 1000);
+    auto osc = Oscillator<float> (440.f, 48000.f);
+    auto wholeBlock = AudioBlock<float> (whole);
+    osc.renderSine (wholeBlock);
+
+    osc.reset();
+    auto piecesBlock = AudioBlock<float> (pieces);
+    auto first = piecesBlock.getSubBlock (0, 300);
+    auto second = piecesBlock.getSubBlock (300, 700);
+    osc.renderSine (first);
+    osc.renderSine (second);
+
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE (pieces.getSample (c, i) == Catch::Approx (whole.getSample (c, i)).margin (1e-6));
+}
+
+TEST_CASE ("Oscillator naive waveforms", "[oscillators]")
+{
+    juce::AudioBuffer<float> buffer (1, 48);
+    auto block = AudioBlock<float> (buffer);
+    auto osc = Oscillator<float> (1000.f, 48000.f); // 48 samples per cycle
+
+    SECTION ("square follows the sine's sign")
+    {
+        osc.renderSquare (block);
+        REQUIRE (buffer.getSample (0, 1) == 1.0f);
+        REQUIRE (buffer.getSample (0, 23) == 1.0f);
+        REQUIRE (buffer.getSample (0, 25) == -1.0f);
+        REQUIRE (buffer.getSample (0, 47) == -1.0f);
+    }
+
+    SECTION ("saw rises from -1 to 1")
+    {
+        osc.reset (-juce::MathConstants<double>::pi);
+        osc.renderSaw (block);
+        REQUIRE (buffer.getSample (0, 0) == Catch::Approx (-1.0f));
+        REQUIRE (buffer.getSample (0, 24) == Catch::Approx (0.0f).margin (1e-6));
+        REQUIRE (buffer.getSample (0, 47) == Catch::Approx (46.0f / 48.0f).margin (1e-5));
+    }
+
+    SECTION ("noise repeats for a seed")
+    {
+        juce::AudioBuffer<float> other (1, 48);
+        auto otherBlock = AudioBlock<float> (other);
+        osc.setNoiseSeed (42);
+        osc.renderNoise (block);
+        osc.setNoiseSeed (42);
+        osc.renderNoise (otherBlock);
+        for (int i = 0; i < 48; ++i)
+        {
+            REQUIRE (buffer.getSample (0, i) == other.getSample (0, i));
+            REQUIRE (std::abs (buffer.getSample (0, i)) <= 1.0f);
+        }
+    }
+}
+
+#endif
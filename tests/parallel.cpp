@@ -0,0 +1,83 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("parallelFor", "[parallel]")
+{
+    SECTION ("calls every item exactly once")
+    {
+        std::vector<std::atomic<int>> calls (10007);
+        parallelFor (calls.size(), [&] (size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i)
+                ++calls[i];
+        });
+        for (auto& count : calls)
+            REQUIRE (count == 1);
+    }
+
+    SECTION ("respects the minimum job size")
+    {
+        std::atomic<int> numRanges { 0 };
+        parallelFor (100, [&] (size_t, size_t) { ++numRanges; }, 100);
+        REQUIRE (numRanges == 1);
+    }
+
+    SECTION ("waits for every range before rethrowing")
+    {
+        std::atomic<int> finished { 0 };
+        auto throwInTheFirstRange = [&] {
+            parallelFor (1024, [&] (size_t begin, size_t) {
+                if (begin == 0)
+                    throw std::runtime_error ("first range");
+                std::this_thread::sleep_for (std::chrono::milliseconds (20));
+                ++finished;
+            });
+        };
+        REQUIRE_THROWS_AS (throwInTheFirstRange(), std::runtime_error);
+        const auto numRanges = juce::jmin (1024, analysisThreadPool().getNumThreads() + 1);
+        REQUIRE (finished == numRanges - 1);
+    }
+
+    SECTION ("rethrows an exception from a pool thread on the caller")
+    {
+        auto throwInTheLastRange = [&] {
+            parallelFor (64, [&] (size_t, size_t end) {
+                if (end == 64)
+                    throw std::logic_error ("last range");
+            });
+        };
+        REQUIRE_THROWS_AS (throwInTheLastRange(), std::logic_error);
+    }
+}
+
+TEST_CASE ("parallelForEach", "[parallel]")
+{
+    SECTION ("calls every item exactly once")
+    {
+        std::vector<std::atomic<int>> calls (500);
+        parallelForEach (calls.size(), [&] (size_t i) { ++calls[i]; });
+        for (auto& count : calls)
+            REQUIRE (count == 1);
+    }
+
+    SECTION ("stops handing out items after a throw")
+    {
+        std::atomic<size_t> started { 0 };
+        auto throwOnTheFirstItem = [&] {
+            parallelForEach (500, [&] (size_t i) {
+                ++started;
+                if (i == 0)
+                    throw std::runtime_error ("first item");
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+            });
+        };
+        REQUIRE_THROWS_AS (throwOnTheFirstItem(), std::runtime_error);
+
+        // at most the items that were already running on the other workers
+        REQUIRE (started <= (size_t) analysisThreadPool().getNumThreads() + 1);
+    }
+}
+
+#endif
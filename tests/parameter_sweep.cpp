@@ -0,0 +1,91 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include "test_processors.h"
+
+using namespace melatonin;
+
+namespace
+{
+    ParameterSweep<float> gainSweep()
+    {
+        return ParameterSweep<float> ([] { return std::make_unique<GainProcessor>(); })
+            .sampleRates ({ 44100, 48000 })
+            .blockSizes ({ 32, 512 })
+            .parameter ("gain", { 0.5f, 1.0f, 2.0f })
+            .input ([] (auto& block, double rate) { Oscillator<float> (441.f, (float) rate, 0.5f).renderSine (block); });
+    }
+}
+
+TEST_CASE ("ParameterSweep", "[parameter_sweep]")
+{
+    SECTION ("visits the grid in order")
+    {
+        auto sweep = gainSweep();
+        REQUIRE (sweep.getNumPoints() == 12);
+
+        auto results = sweep.run (0.1);
+        REQUIRE (results.size() == 12);
+        REQUIRE (results.getParameterIDs() == std::vector<juce::String> { "gain" });
+
+        REQUIRE (results[0].sampleRate == 44100);
+        REQUIRE (results[0].blockSize == 32);
+        REQUIRE (results.valueOf (0, "gain") == 0.5f);
+        REQUIRE (results.valueOf (1, "gain") == 1.0f);
+        REQUIRE (results[3].blockSize == 512);
+        REQUIRE (results[6].sampleRate == 48000);
+        REQUIRE (results.valueOf (11, "gain") == 2.0f);
+        REQUIRE (results.describePoint (4) == "44100Hz, 512 samples, gain=1");
+    }
+
+    SECTION ("measures every point")
+    {
+        auto results = gainSweep()
+                           .measure ([] (auto& output, const SweepResult& point) { return (double) output.getNumSamples() / point.sampleRate; })
+                           .run (0.1);
+
+        REQUIRE (results.allValid());
+        for (auto& result : results)
+        {
+            // 441Hz is a whole number of cycles in 0.1s at either rate
+            REQUIRE (result.rms == Catch::Approx (0.5 * result.parameterValues[0] / std::sqrt (2.0)).epsilon (0.001));
+            REQUIRE (result.peak == Catch::Approx (0.5 * result.parameterValues[0]).epsilon (0.01));
+            REQUIRE (result.measurement == Catch::Approx (0.1));
+        }
+    }
+
+    SECTION ("groups points along a parameter")
+    {
+        auto results = gainSweep().run (0.01);
+        auto series = results.seriesAlong ("gain");
+        REQUIRE (series.size() == 4);
+        for (auto& points : series)
+        {
+            REQUIRE (points.size() == 3);
+            REQUIRE (results.valueOf (points[0], "gain") == 0.5f);
+            REQUIRE (results.valueOf (points[2], "gain") == 2.0f);
+            REQUIRE (results[points[0]].blockSize == results[points[2]].blockSize);
+        }
+
+        REQUIRE_THAT (results, isMonotonicWith ("gain"));
+        REQUIRE_THAT (results, isMonotonicWith ("gain", [] (auto& r) { return r.peak; }, true, true));
+
+        auto decreasing = isMonotonicWith ("gain", [] (auto& r) { return r.rms; }, false);
+        REQUIRE_FALSE (decreasing.match (results));
+        REQUIRE (decreasing.describe().find ("went from") != std::string::npos);
+    }
+
+    SECTION ("rethrows a measure that throws on a pool thread")
+    {
+        std::atomic<int> measured { 0 };
+        auto sweep = gainSweep().measure ([&] (auto&, const SweepResult&) -> double {
+            ++measured;
+            throw std::runtime_error ("measure failed");
+        });
+
+        REQUIRE_THROWS_AS (sweep.run (0.01), std::runtime_error);
+        REQUIRE (measured <= analysisThreadPool().getNumThreads() + 1);
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+// Paul Kellet's refined pink filter, within 0.05dB of -3dB per octave above 10Hz at 44.1kHz
+static void fillWithPinkNoise (juce::AudioBuffer<float>& buffer, juce::Random& random)
+{
+    for (int c = 0; c < buffer.getNumChannels(); ++c)
+    {
+        double b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            const auto white = random.nextDouble() * 2.0 - 1.0;
+            b0 = 0.99886 * b0 + white * 0.0555179;
+            b1 = 0.99332 * b1 + white * 0.0750759;
+            b2 = 0.96900 * b2 + white * 0.1538520;
+            b3 = 0.86650 * b3 + white * 0.3104856;
+            b4 = 0.55000 * b4 + white * 0.5329522;
+            b5 = -0.7616 * b5 - white * 0.0168980;
+            buffer.setSample (c, i, (float) ((b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362) * 0.1));
+            b6 = white * 0.115926;
+        }
+    }
+}
+
+TEST_CASE ("PowerSpectralDensity", "[power_spectral_density]")
+{
+    juce::AudioBuffer<float> white (2, 44100 * 10);
+    juce::Random random (99);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < white.getNumSamples(); ++i)
+            white.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+    auto block = AudioBlock<float> (white);
+
+    SECTION ("densities add up to the mean square")
+    {
+        PowerSpectralDensity<float> psd (block, 44100.0);
+        REQUIRE (psd.getNumSegments() == (size_t) (white.getNumSamples() - 8192) / 4096 + 1);
+
+        // uniform noise between -1 and 1 has a mean square of 1/3, spread evenly up to nyquist
+        REQUIRE (psd.bandPower (0, 22051) == Catch::Approx (1.0 / 3.0).epsilon (0.01));
+        REQUIRE (psd.bandPower (1000, 2000) == Catch::Approx (1.0 / 3.0 * 1000.0 / 22050.0).epsilon (0.03));
+    }
+
+    SECTION ("the same every time, however the segments are split between threads")
+    {
+        PowerSpectralDensity<float> first (block, 44100.0), second (block, 44100.0, 13, 0.75);
+        PowerSpectralDensity<float> again (block, 44100.0);
+        for (size_t k = 0; k < first.getNumBins(); ++k)
+            REQUIRE (again.getDensity (k) == Catch::Approx (first.getDensity (k)).epsilon (1e-9));
+        REQUIRE (second.getNumSegments() > first.getNumSegments());
+    }
+
+    SECTION ("too short for a single segment")
+    {
+        PowerSpectralDensity<float> psd (block.getSubBlock (0, 1000), 44100.0);
+        REQUIRE (psd.getNumSegments() == 0);
+        REQUIRE (psd.bandPower (0, 22050) == 0);
+    }
+}
+
+TEST_CASE ("spectral matchers", "[power_spectral_density]")
+{
+    juce::Random random (7);
+    juce::AudioBuffer<float> white (2, 44100 * 10), pink (2, 44100 * 10);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < white.getNumSamples(); ++i)
+            white.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+    fillWithPinkNoise (pink, random);
+
+    SECTION ("white noise has no slope")
+    {
+        auto shape = spectralShape (PowerSpectralDensity<float> (AudioBlock<float> (white), 44100.0), 50.0, 17640.0);
+        REQUIRE (shape.slope == Catch::Approx (0.0).margin (0.1));
+        REQUIRE_THAT (white, hasSpectralSlope (0_dB_per_octave, 0.1, 44100));
+        REQUIRE_THAT (white, isSpectrallyFlat (1.0, 44100));
+        REQUIRE_FALSE (hasSpectralSlope (-3_dB_per_octave, 0.5, 44100).match (white));
+    }
+
+    SECTION ("pink noise falls 3dB an octave")
+    {
+        auto shape = spectralShape (PowerSpectralDensity<float> (AudioBlock<float> (pink), 44100.0), 50.0, 17640.0);
+        REQUIRE (shape.slope == Catch::Approx (-3.0).margin (0.1));
+        REQUIRE (shape.deviation < 1.0);
+        REQUIRE_THAT (pink, hasSpectralSlope (-3_dB_per_octave, 0.1, 44100));
+        REQUIRE_FALSE (isSpectrallyFlat (1.0, 44100).match (pink));
+    }
+
+    SECTION ("describes what it measured")
+    {
+        auto matcher = hasSpectralSlope (0_dB_per_octave, 0.5, 44100);
+        REQUIRE_FALSE (matcher.match (pink));
+        REQUIRE (matcher.describe().find ("from 50Hz to 17640Hz") != std::string::npos);
+        REQUIRE (matcher.shape.slope == Catch::Approx (-3.0).margin (0.1));
+        REQUIRE (matcher.describe().find ("Slope is -") != std::string::npos);
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include "test_processors.h"
+
+using namespace melatonin;
+
+TEST_CASE ("ProcessorHarness", "[processor_harness]")
+{
+    TestProcessor processor ([] (auto& buffer) {
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+            juce::FloatVectorOperations::add (buffer.getWritePointer (c), 0.25f, buffer.getNumSamples());
+    });
+
+    SECTION ("renders in blocks with an advancing playhead")
+    {
+        auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        auto& output = harness.render (0.1);
+        REQUIRE (output.getNumSamples() == 4800);
+        REQUIRE (output.getSample (1, 4799) == 0.25f);
+        REQUIRE (processor.numPrepares == 1);
+        REQUIRE (harness.getTimings().getNumBlocks() == 75);
+        REQUIRE (processor.lastBlockTimeInSamples == 4800 - 64);
+    }
+
+    SECTION ("each render starts the playhead from 0")
+    {
+        auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        harness.render (0.1);
+        harness.render (0.1);
+        REQUIRE (processor.lastBlockTimeInSamples == 4800 - 64);
+        REQUIRE (processor.numPrepares == 1);
+    }
+
+    SECTION ("renders input through the processor")
+    {
+        auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        juce::AudioBuffer<float> input (2, 100);
+        input.clear();
+        input.setSample (0, 3, 1.0f);
+        auto& output = harness.render (AudioBlock<float> (input));
+        REQUIRE (output.getNumSamples() == 100);
+        REQUIRE (output.getSample (0, 3) == 1.25f);
+        REQUIRE (harness.getTimings().getNumBlocks() == 2);
+    }
+
+    SECTION ("lets go of the processor when it's destroyed")
+    {
+        {
+            auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+            harness.render (0.01);
+            REQUIRE (processor.getPlayHead() != nullptr);
+        }
+        REQUIRE (processor.getPlayHead() == nullptr);
+        REQUIRE (processor.numReleases == 1);
+    }
+
+    SECTION ("doesn't release a processor it never prepared")
+    {
+        {
+            auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        }
+        REQUIRE (processor.numReleases == 0);
+    }
+}
+
+TEST_CASE ("RenderTimings", "[processor_harness]")
+{
+    RenderTimings timings (48000.0, 480);
+    for (int i = 1; i <= 100; ++i)
+        timings.add (i * 1e-5, 480);
+
+    REQUIRE (timings.audioSeconds() == Catch::Approx (1.0));
+    REQUIRE (timings.totalSeconds() == Catch::Approx (0.0505));
+    REQUIRE (timings.realtimeFactor() == Catch::Approx (1.0 / 0.0505));
+    REQUIRE (timings.median() == Catch::Approx (50e-5));
+    REQUIRE (timings.percentile (99) == Catch::Approx (99e-5));
+    REQUIRE (timings.worstBlock() == Catch::Approx (100e-5));
+    REQUIRE (timings.blockBudget() == Catch::Approx (0.01));
+
+    REQUIRE_THAT (timings, rendersFasterThanRealtime (19));
+    REQUIRE_FALSE (rendersFasterThanRealtime (20).match (timings));
+    REQUIRE_THAT (timings, worstBlockUnder (1001));
+    REQUIRE_FALSE (worstBlockUnder (1000).match (timings));
+}
+
+#endif
@@ -0,0 +1,107 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include "test_processors.h"
+
+using namespace melatonin;
+
+#if MELATONIN_REALTIME_GUARD
+
+TEST_CASE ("RealtimeGuard", "[realtime_guard]")
+{
+    REQUIRE (RealtimeGuard::hooksAreInstalled());
+
+    SECTION ("catches an allocation")
+    {
+        std::vector<float> scratch;
+        RealtimeGuard guard;
+        scratch.resize (100);
+        guard.disarm();
+
+        REQUIRE (guard.getNumAllocations() == 1);
+        REQUIRE_FALSE (isRealtimeSafe().match (guard));
+    }
+
+    SECTION ("passes code that doesn't allocate")
+    {
+        std::vector<float> scratch (100);
+        RealtimeGuard guard;
+        std::fill (scratch.begin(), scratch.end(), 1.0f);
+        guard.disarm();
+
+        REQUIRE_THAT (guard, isRealtimeSafe());
+    }
+
+    SECTION ("only watches the thread that armed it")
+    {
+        RealtimeGuard guard;
+        std::thread ([] { std::vector<float> elsewhere (100); }).join();
+        guard.disarm();
+
+        // starting the thread may allocate here, but not 100 floats
+        for (auto& violation : guard.getViolations())
+            REQUIRE (violation.size != 100 * sizeof (float));
+    }
+
+    SECTION ("the innermost guard gets the violations")
+    {
+        RealtimeGuard inner (false); // constructed first, so its own storage isn't counted
+        RealtimeGuard outer;
+        inner.arm();
+        auto p = std::make_unique<std::vector<float>> (10);
+        inner.disarm();
+        p.reset();
+        outer.disarm();
+
+        REQUIRE (inner.getNumAllocations() == 2);
+        REQUIRE (inner.getNumDeallocations() == 0);
+        REQUIRE (outer.getNumAllocations() == 0);
+        REQUIRE (outer.getNumDeallocations() == 2);
+    }
+}
+
+TEST_CASE ("ProcessorHarness watches processBlock", "[realtime_guard]")
+{
+    SECTION ("reports an allocation inside processBlock")
+    {
+        std::vector<float> scratch;
+        TestProcessor processor ([&] (auto& buffer) {
+            scratch.clear();
+            scratch.shrink_to_fit();
+            scratch.resize ((size_t) buffer.getNumSamples());
+        });
+        auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        harness.render (0.01);
+
+        auto matcher = isRealtimeSafe();
+        REQUIRE_FALSE (matcher.match (harness));
+        REQUIRE (harness.getRealtimeGuard().getNumAllocations() == 8);
+        REQUIRE (matcher.describe().find ("allocated 256 bytes") != std::string::npos);
+    }
+
+    SECTION ("passes a clean processBlock")
+    {
+        TestProcessor processor ([] (auto& buffer) {
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                juce::FloatVectorOperations::multiply (buffer.getWritePointer (c), 0.5f, buffer.getNumSamples());
+        });
+        auto harness = ProcessorHarness<float> (processor, 48000.0, 64);
+        harness.render (0.01);
+        REQUIRE_THAT (harness, isRealtimeSafe());
+    }
+}
+
+#else
+
+TEST_CASE ("isRealtimeSafe says when the hooks are missing", "[realtime_guard]")
+{
+    RealtimeGuard guard;
+    guard.disarm();
+    auto matcher = isRealtimeSafe();
+    REQUIRE_FALSE (matcher.match (guard));
+    REQUIRE (matcher.describe().find ("aren't installed") != std::string::npos);
+}
+
+#endif
+
+#endif
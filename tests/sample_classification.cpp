@@ -0,0 +1,98 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("classifySample", "[sample_classification]")
+{
+    REQUIRE (classifySample (0.5f) == SampleClass::normal);
+    REQUIRE (classifySample (-0.0f) == SampleClass::zero);
+    REQUIRE (classifySample (std::numeric_limits<float>::denorm_min()) == SampleClass::subnormal);
+    REQUIRE (classifySample (-std::numeric_limits<float>::infinity()) == SampleClass::infinite);
+    REQUIRE (classifySample (std::numeric_limits<float>::quiet_NaN()) == SampleClass::nan);
+    REQUIRE (classifySample (std::numeric_limits<double>::min()) == SampleClass::normal);
+    REQUIRE (classifySample (std::numeric_limits<double>::min() / 2) == SampleClass::subnormal);
+    REQUIRE (classifySample (std::numeric_limits<double>::signaling_NaN()) == SampleClass::nan);
+}
+
+TEST_CASE ("classifySamples", "[sample_classification]")
+{
+    std::vector<float> values (1000, 0.25f);
+    values[0] = 0.f;
+    values[1] = -0.f;
+    values[100] = std::numeric_limits<float>::denorm_min();
+    values[500] = std::numeric_limits<float>::infinity();
+    values[998] = std::numeric_limits<float>::quiet_NaN();
+    values[999] = std::numeric_limits<float>::quiet_NaN();
+
+    auto counts = classifySamples (values.data(), values.size());
+    REQUIRE (counts.zero == 2);
+    REQUIRE (counts.subnormal == 1);
+    REQUIRE (counts.infinite == 1);
+    REQUIRE (counts.nan == 2);
+    REQUIRE (counts.normal == 994);
+    REQUIRE (counts.invalid() == 4);
+}
+
+TEST_CASE ("findFirstInvalidSample", "[sample_classification]")
+{
+    // 64 sample chunks, so 150 samples ends in a partial chunk of 22
+    std::vector<float> values (150, 0.5f);
+
+    SECTION ("valid samples return numSamples")
+    {
+        values[3] = 0.f;
+        REQUIRE (findFirstInvalidSample (values.data(), values.size()) == 150);
+    }
+
+    SECTION ("a NaN in the last partial chunk")
+    {
+        values[149] = std::numeric_limits<float>::quiet_NaN();
+        REQUIRE (findFirstInvalidSample (values.data(), values.size()) == 149);
+    }
+
+    SECTION ("the earliest bad sample in a chunk wins")
+    {
+        values[70] = std::numeric_limits<float>::denorm_min();
+        values[66] = std::numeric_limits<float>::infinity();
+        values[140] = std::numeric_limits<float>::quiet_NaN();
+        REQUIRE (findFirstInvalidSample (values.data(), values.size()) == 66);
+    }
+
+    SECTION ("on the first sample of a chunk")
+    {
+        values[64] = std::numeric_limits<float>::quiet_NaN();
+        REQUIRE (findFirstInvalidSample (values.data(), values.size()) == 64);
+    }
+
+    SECTION ("in a block, with its channel and class")
+    {
+        juce::AudioBuffer<double> buffer (2, 150);
+        auto block = AudioBlock<double> (buffer);
+        block.fill (0.5);
+        block.setSample (1, 130, std::numeric_limits<double>::infinity());
+
+        auto invalid = findFirstInvalidSample (block);
+        REQUIRE (invalid.has_value());
+        REQUIRE (invalid->channel == 1);
+        REQUIRE (invalid->sample == 130);
+        REQUIRE (invalid->sampleClass == SampleClass::infinite);
+        REQUIRE_FALSE (validAudio (block));
+    }
+}
+
+TEST_CASE ("isValidAudio describes what it found", "[sample_classification]")
+{
+    juce::AudioBuffer<float> buffer (1, 100);
+    auto block = AudioBlock<float> (buffer);
+    block.fill (0.1f);
+    block.setSample (0, 99, std::numeric_limits<float>::quiet_NaN());
+
+    auto matcher = isValidAudio();
+    REQUIRE_FALSE (matcher.match (block));
+    REQUIRE (matcher.describe().find ("NaN") != std::string::npos);
+    REQUIRE (matcher.describe().find ("99") != std::string::npos);
+}
+
+#endif
@@ -0,0 +1,149 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+namespace
+{
+    template <typename SampleType>
+    bool samplesMatch (SampleType actual, SampleType expected, Tolerance tolerance)
+    {
+        return findFirstMismatch (&actual, &expected, 1, tolerance) == 1;
+    }
+}
+
+TEST_CASE ("Tolerance modes at their boundaries", "[sample_comparison]")
+{
+    SECTION ("absolute")
+    {
+        REQUIRE (samplesMatch (0.5f, 0.75f, Tolerance::absolute (0.25)));
+        REQUIRE_FALSE (samplesMatch (0.5f, 0.75f, Tolerance::absolute (std::nextafter (0.25, 0.0))));
+        REQUIRE (samplesMatch (-0.5, -0.75, Tolerance::absolute (0.25)));
+        REQUIRE_FALSE (samplesMatch (-0.5, -0.75, Tolerance::absolute (std::nextafter (0.25, 0.0))));
+    }
+
+    SECTION ("relative to the larger magnitude")
+    {
+        REQUIRE (samplesMatch (0.75f, 1.0f, Tolerance::relative (0.25)));
+        REQUIRE (samplesMatch (1.0f, 0.75f, Tolerance::relative (0.25)));
+        REQUIRE_FALSE (samplesMatch (1.0f, 0.75f, Tolerance::relative (std::nextafter (0.25, 0.0))));
+        REQUIRE (samplesMatch (-3.0, -4.0, Tolerance::relative (0.25)));
+        REQUIRE_FALSE (samplesMatch (-3.0, -4.0, Tolerance::relative (0.2499)));
+    }
+
+    SECTION ("ULPs")
+    {
+        const auto threeUp = std::nextafter (std::nextafter (std::nextafter (1.0f, 2.0f), 2.0f), 2.0f);
+        REQUIRE (deviationOf<Tolerance::Mode::ulps> (threeUp, 1.0f) == 3);
+        REQUIRE (samplesMatch (threeUp, 1.0f, Tolerance::ulps (3)));
+        REQUIRE_FALSE (samplesMatch (threeUp, 1.0f, Tolerance::ulps (2)));
+
+        // the smallest subnormals either side of zero are 2 ULPs apart
+        const auto tiny = std::numeric_limits<double>::denorm_min();
+        REQUIRE (deviationOf<Tolerance::Mode::ulps> (tiny, -tiny) == 2);
+        REQUIRE (samplesMatch (tiny, -tiny, Tolerance::ulps (2)));
+        REQUIRE_FALSE (samplesMatch (tiny, -tiny, Tolerance::ulps (1)));
+
+        REQUIRE (samplesMatch (0.0f, -0.0f, Tolerance::ulps (0)));
+    }
+
+    SECTION ("NaN never matches, not even NaN")
+    {
+        const auto nan = std::numeric_limits<float>::quiet_NaN();
+        for (auto tolerance : { Tolerance::absolute (1e30), Tolerance::relative (1e30), Tolerance::ulps (std::numeric_limits<uint32_t>::max()) })
+        {
+            REQUIRE_FALSE (samplesMatch (nan, nan, tolerance));
+            REQUIRE_FALSE (samplesMatch (nan, 0.0f, tolerance));
+            REQUIRE_FALSE (samplesMatch (0.0f, nan, tolerance));
+        }
+        REQUIRE (deviationOf<Tolerance::Mode::ulps> (nan, nan) == std::numeric_limits<double>::infinity());
+    }
+
+    SECTION ("matching infinities are equal")
+    {
+        const auto infinity = std::numeric_limits<double>::infinity();
+        REQUIRE (samplesMatch (infinity, infinity, Tolerance::absolute (0)));
+        REQUIRE (samplesMatch (-infinity, -infinity, Tolerance::ulps (0)));
+        REQUIRE_FALSE (samplesMatch (infinity, -infinity, Tolerance::absolute (1e300)));
+    }
+}
+
+TEST_CASE ("findFirstMismatch", "[sample_comparison]")
+{
+    std::vector<float> expected (200, 0.5f), actual (200, 0.5f);
+    REQUIRE (findFirstMismatch (actual.data(), expected.data(), 200, Tolerance::absolute (0)) == 200);
+
+    // past the first 64 sample chunk, and the earliest of two in the same chunk
+    actual[150] = 0.6f;
+    actual[130] = 0.4f;
+    REQUIRE (findFirstMismatch (actual.data(), expected.data(), 200, Tolerance::absolute (0.05)) == 130);
+    REQUIRE (findFirstMismatch (actual.data(), expected.data(), 200, Tolerance::absolute (0.2)) == 200);
+}
+
+TEST_CASE ("isEqualTo", "[sample_comparison]")
+{
+    juce::AudioBuffer<float> expectedBuffer (2, 100), actualBuffer (2, 100);
+    auto expected = AudioBlock<float> (expectedBuffer);
+    auto actual = AudioBlock<float> (actualBuffer);
+    fillWithSine (expected, 1000.f, 48000.f);
+    actual.copyFrom (expected);
+
+    SECTION ("captures nothing while it passes")
+    {
+        auto matcher = isEqualTo<float> (expected, Tolerance::ulps (0));
+        REQUIRE (matcher.match (actual));
+        REQUIRE_FALSE (matcher.mismatch.has_value());
+        REQUIRE (matcher.describeMismatch().empty());
+    }
+
+    SECTION ("describes the first and worst mismatches when it fails")
+    {
+        actual.setSample (1, 5, actual.getSample (1, 5) + 0.5f);
+        actual.setSample (1, 60, actual.getSample (1, 60) - 0.75f);
+
+        auto matcher = isEqualTo<float> (expected, 0.1f);
+        REQUIRE_FALSE (matcher.match (actual));
+        REQUIRE (matcher.mismatch.has_value());
+        REQUIRE (matcher.mismatch->channel == 1);
+        REQUIRE (matcher.mismatch->sample == 5);
+        REQUIRE (matcher.mismatch->windowStart == 0);
+        REQUIRE (matcher.mismatch->actualWindow.size() == 14);
+        REQUIRE (matcher.mismatch->worstSample == 60);
+        REQUIRE (matcher.mismatch->worstDeviation == Catch::Approx (0.75));
+
+        const auto description = matcher.describeMismatch();
+        REQUIRE (description.find ("Channel 1 sample 5 was") != std::string::npos);
+        REQUIRE (description.find ("2 samples out of tolerance (channel 0: 0, channel 1: 2)") != std::string::npos);
+        REQUIRE (description.find ("at channel 1 sample 60") != std::string::npos);
+        REQUIRE (matcher.describe().find ("is equal to (within 0.1") != std::string::npos);
+
+        // matching again forgets the last failure
+        REQUIRE (matcher.match (expected));
+        REQUIRE_FALSE (matcher.mismatch.has_value());
+    }
+
+    SECTION ("reports ULPs in ULPs")
+    {
+        actual.setSample (0, 50, std::nextafter (std::nextafter (actual.getSample (0, 50), 2.0f), 2.0f));
+        auto matcher = isEqualTo<float> (expected, Tolerance::ulps (1));
+        REQUIRE_FALSE (matcher.match (actual));
+        REQUIRE (matcher.describeMismatch().find ("Worst deviation 2 ULPs") != std::string::npos);
+        REQUIRE (isEqualTo<float> (expected, Tolerance::ulps (2)).match (actual));
+    }
+
+    SECTION ("different sizes")
+    {
+        auto matcher = isEqualTo<float> (expected);
+        REQUIRE_FALSE (matcher.match (actual.getSubBlock (0, 99)));
+        REQUIRE (matcher.describeMismatch() == "Expected 2 channels of 100 samples, got 2 channels of 99");
+    }
+
+    SECTION ("vectors")
+    {
+        REQUIRE_THAT (std::vector<float> ({ 0.0f, 1.0f }), isEqualTo (std::vector<float> ({ 0.0f, 1.0f }), 0.0f));
+        REQUIRE_FALSE (isEqualTo (std::vector<float> ({ 0.0f, 1.0f })).match (std::vector<float> ({ 0.0f, 1.1f })));
+    }
+}
+
+#endif
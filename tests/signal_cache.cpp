@@ -0,0 +1,84 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+TEST_CASE ("SignalCache", "[signal_cache]")
+{
+    auto& cache = SignalCache::getInstance();
+    cache.clear();
+    cache.setMemoryBudget (SignalCache::defaultMemoryBudget);
+    const auto hits = cache.getNumHits();
+    const auto misses = cache.getNumMisses();
+
+    SECTION ("serves repeat requests from memory")
+    {
+        auto first = cache.get<float> (Waveform::sine, 440.f, 48000.f, 1000);
+        auto second = cache.get<float> (Waveform::sine, 440.f, 48000.f, 1000);
+        REQUIRE (first.getData() == second.getData());
+        REQUIRE (cache.getNumMisses() == misses + 1);
+        REQUIRE (cache.getNumHits() == hits + 1);
+        REQUIRE (cache.getBytesUsed() == 1000 * sizeof (float));
+
+        // a different type, gain or length is a different signal
+        REQUIRE (cache.get<double> (Waveform::sine, 440.f, 48000.f, 1000).getData() != (const void*) first.getData());
+        REQUIRE (cache.get<float> (Waveform::sine, 440.f, 48000.f, 1000, 0.5f).getData() != first.getData());
+        REQUIRE (cache.get<float> (Waveform::sine, 440.f, 48000.f, 999).getData() != first.getData());
+    }
+
+    SECTION ("matches a freshly rendered signal")
+    {
+        auto cached = cache.get<float> (Waveform::sine, 440.f, 48000.f, 1000, 0.5f);
+        juce::AudioBuffer<float> buffer (1, 1000);
+        auto block = AudioBlock<float> (buffer);
+        Oscillator<float> (440.f, 48000.f, 0.5f).renderSine (block);
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE (cached.getData()[i] == buffer.getSample (0, i));
+    }
+
+    SECTION ("doesn't keep signals larger than an eighth of the budget")
+    {
+        const size_t tooBig = SignalCache::defaultMemoryBudget / 8 / sizeof (float) + 1;
+        auto big = cache.get<float> (Waveform::sine, 440.f, 48000.f, tooBig);
+        REQUIRE (big.getNumSamples() == tooBig);
+        REQUIRE (cache.getBytesUsed() == 0);
+
+        cache.get<float> (Waveform::sine, 440.f, 48000.f, tooBig - 1);
+        REQUIRE (cache.getBytesUsed() == (tooBig - 1) * sizeof (float));
+    }
+
+    SECTION ("evicts the least recently used signal")
+    {
+        cache.setMemoryBudget (8 * 4000 * sizeof (float));
+        auto a = cache.get<float> (Waveform::sine, 100.f, 48000.f, 4000);
+        cache.get<float> (Waveform::sine, 200.f, 48000.f, 4000);
+        cache.get<float> (Waveform::sine, 100.f, 48000.f, 4000); // 100Hz is now the most recent
+        for (int i = 0; i < 7; ++i)
+            cache.get<float> (Waveform::saw, 300.f + (float) i, 48000.f, 4000);
+
+        REQUIRE (cache.getBytesUsed() == 8 * 4000 * sizeof (float));
+        const auto missesBefore = cache.getNumMisses();
+        REQUIRE (cache.get<float> (Waveform::sine, 100.f, 48000.f, 4000).getData() == a.getData());
+        REQUIRE (cache.getNumMisses() == missesBefore);
+        cache.get<float> (Waveform::sine, 200.f, 48000.f, 4000);
+        REQUIRE (cache.getNumMisses() == missesBefore + 1);
+    }
+
+    SECTION ("a budget of 0 turns caching off")
+    {
+        cache.setMemoryBudget (0);
+        auto signal = cache.get<float> (Waveform::sine, 440.f, 48000.f, 1000);
+        REQUIRE (cache.getBytesUsed() == 0);
+
+        // handles stay valid after eviction
+        cache.clear();
+        REQUIRE (signal.getData()[0] == 0.0f);
+        REQUIRE (signal.getData()[12] != 0.0f);
+    }
+
+    cache.clear();
+    cache.setMemoryBudget (SignalCache::defaultMemoryBudget);
+}
+
+#endif
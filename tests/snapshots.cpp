@@ -0,0 +1,130 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+    #include <fstream>
+
+using namespace melatonin;
+
+namespace
+{
+    juce::File snapshotTestDirectory()
+    {
+        return juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("melatonin_snapshot_tests");
+    }
+
+    // overwrites part of a recorded snapshot's header
+    template <typename FieldType>
+    void patchHeader (const juce::File& file, size_t offset, FieldType value)
+    {
+        std::fstream stream (file.getFullPathName().toStdString(), std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp ((std::streamoff) offset);
+        stream.write (reinterpret_cast<const char*> (&value), sizeof (value));
+    }
+}
+
+TEST_CASE ("Snapshots round trip", "[snapshots]")
+{
+    snapshotTestDirectory().deleteRecursively();
+    setSnapshotDirectory (snapshotTestDirectory());
+
+    SECTION ("float")
+    {
+        juce::AudioBuffer<float> buffer (3, 1001); // not a multiple of the 64 byte alignment
+        auto block = AudioBlock<float> (buffer);
+        Oscillator<float> (440.f, 48000.f).renderNoise (block);
+        buffer.setSample (2, 1000, -0.25f);
+
+        REQUIRE (writeSnapshot (getSnapshotFile ("float"), block, 48000.0));
+        auto snapshot = Snapshot<float> (getSnapshotFile ("float"));
+        REQUIRE (snapshot.isValid());
+        REQUIRE (snapshot.getNumChannels() == 3);
+        REQUIRE (snapshot.getNumSamples() == 1001);
+        REQUIRE (snapshot.getSampleRate() == 48000.0);
+        REQUIRE (reinterpret_cast<uintptr_t> (snapshot.getBlock().getChannelPointer (1)) % SnapshotHeader::alignment == 0);
+        REQUIRE_THAT (block, isEqualTo<float> (snapshot.getBlock(), 0.0f));
+        REQUIRE (snapshot.getBlock().getSample (2, 1000) == -0.25f);
+
+        REQUIRE_THAT (buffer, matchesSnapshot ("float", 0.0f, 48000.0));
+        REQUIRE_THAT (buffer, matchesSnapshot ("float", Tolerance::ulps (0)));
+    }
+
+    SECTION ("double")
+    {
+        juce::AudioBuffer<double> buffer (2, 64);
+        auto block = AudioBlock<double> (buffer);
+        Oscillator<double> (1000.f, 48000.f).renderSine (block);
+
+        REQUIRE (writeSnapshot (getSnapshotFile ("double"), block));
+        REQUIRE_THAT (buffer, matchesSnapshot ("double", Tolerance::ulps (0)));
+
+        auto asFloat = Snapshot<float> (getSnapshotFile ("double"));
+        REQUIRE_FALSE (asFloat.isValid());
+        REQUIRE (asFloat.getError() == "snapshot was recorded as double");
+    }
+
+    SECTION ("mismatches")
+    {
+        juce::AudioBuffer<float> buffer (1, 100);
+        auto block = AudioBlock<float> (buffer);
+        fillWithSine (block, 1000.f, 48000.f);
+        REQUIRE (writeSnapshot (getSnapshotFile ("sine"), block, 48000.0));
+
+        auto wrongRate = matchesSnapshot ("sine", 0.0f, 44100.0);
+        REQUIRE_FALSE (wrongRate.match (buffer));
+        REQUIRE (wrongRate.describe().find ("recorded at 48000Hz") != std::string::npos);
+
+        buffer.setSample (0, 50, buffer.getSample (0, 50) * 1.001f);
+        REQUIRE_FALSE (matchesSnapshot ("sine", Tolerance::relative (0.0005)).match (buffer));
+        REQUIRE_THAT (buffer, matchesSnapshot ("sine", Tolerance::relative (0.002)));
+
+        auto missing = matchesSnapshot ("nope");
+        REQUIRE_FALSE (missing.match (buffer));
+        REQUIRE (missing.describe().find ("MELATONIN_UPDATE_SNAPSHOTS=1") != std::string::npos);
+    }
+
+    setSnapshotDirectory ({});
+    snapshotTestDirectory().deleteRecursively();
+}
+
+TEST_CASE ("Snapshots reject corrupt headers", "[snapshots]")
+{
+    const auto file = snapshotTestDirectory().getChildFile ("corrupt.melsnap");
+    juce::AudioBuffer<float> buffer (2, 100);
+    buffer.clear();
+    REQUIRE (writeSnapshot (file, AudioBlock<float> (buffer)));
+
+    SECTION ("a stride shorter than a channel")
+    {
+        patchHeader (file, offsetof (SnapshotHeader, channelStride), (uint64_t) 50);
+        auto snapshot = Snapshot<float> (file);
+        REQUIRE_FALSE (snapshot.isValid());
+        REQUIRE (snapshot.getError().find ("overlap") != std::string::npos);
+        REQUIRE (snapshot.getNumSamples() == 0);
+    }
+
+    SECTION ("sizes that would overflow")
+    {
+        patchHeader (file, offsetof (SnapshotHeader, numSamples), (uint64_t) 1 << 62);
+        patchHeader (file, offsetof (SnapshotHeader, channelStride), (uint64_t) 1 << 62);
+        patchHeader (file, offsetof (SnapshotHeader, numChannels), (uint32_t) 4);
+        auto snapshot = Snapshot<float> (file);
+        REQUIRE_FALSE (snapshot.isValid());
+        REQUIRE (snapshot.getError() == "snapshot is truncated");
+    }
+
+    SECTION ("more channels than the file holds")
+    {
+        patchHeader (file, offsetof (SnapshotHeader, numChannels), (uint32_t) 3);
+        REQUIRE (Snapshot<float> (file).getError() == "snapshot is truncated");
+    }
+
+    SECTION ("not a snapshot")
+    {
+        patchHeader (file, 0, 'X');
+        REQUIRE (Snapshot<float> (file).getError() == "not a snapshot file");
+    }
+
+    snapshotTestDirectory().deleteRecursively();
+}
+
+#endif
@@ -0,0 +1,122 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+namespace
+{
+    // noise with stretches of silence, lone zeros and the odd invalid sample
+    void fillWithPatchySignal (juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+        {
+            auto data = buffer.getWritePointer (c);
+            for (int i = 0; i < buffer.getNumSamples();)
+            {
+                const auto length = juce::jmin (1 + random.nextInt (300), buffer.getNumSamples() - i);
+                const auto silent = random.nextInt (3) == 0;
+                for (int j = 0; j < length; ++j, ++i)
+                    data[i] = silent ? 0.0f : (random.nextInt (50) == 0 ? 0.0f : random.nextFloat() - 0.5f);
+            }
+        }
+    }
+}
+
+TEST_CASE ("StreamingStats matches the whole block helpers", "[streaming_stats]")
+{
+    juce::Random random (9);
+
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        juce::AudioBuffer<float> buffer (2, 5000);
+        fillWithPatchySignal (buffer, random);
+        if (trial % 4 == 1)
+            buffer.setSample (random.nextInt (2), 1000 + random.nextInt (3000), std::numeric_limits<float>::quiet_NaN());
+        if (trial % 4 == 2)
+            buffer.setSample (1, 100 + random.nextInt (3000), std::numeric_limits<float>::denorm_min());
+        auto block = AudioBlock<float> (buffer);
+
+        StreamingStats<float> stream;
+        for (size_t start = 0; start < block.getNumSamples();)
+        {
+            const auto length = juce::jmin ((size_t) random.nextInt (700), block.getNumSamples() - start);
+            stream.push (block.getSubBlock (start, length));
+            start += length;
+        }
+
+        REQUIRE (stream.getNumSamples() == 5000);
+
+        SampleClassCounts expectedCounts;
+        for (int c = 0; c < 2; ++c)
+            expectedCounts += classifySamples (buffer.getReadPointer (c), 5000);
+        REQUIRE (stream.getClassCounts().normal == expectedCounts.normal);
+        REQUIRE (stream.getClassCounts().zero == expectedCounts.zero);
+        REQUIRE (stream.getClassCounts().subnormal == expectedCounts.subnormal);
+        REQUIRE (stream.getClassCounts().nan == expectedCounts.nan);
+
+        // the first invalid sample in push order: earliest push, then lowest channel
+        std::optional<size_t> expectedInvalid;
+        for (int c = 0; c < 2; ++c)
+        {
+            auto index = findFirstInvalidSample (buffer.getReadPointer (c), 5000);
+            if (index < 5000 && (!expectedInvalid.has_value() || index < *expectedInvalid))
+                expectedInvalid = index;
+        }
+        REQUIRE (stream.getFirstInvalidSample().has_value() == expectedInvalid.has_value());
+        if (expectedInvalid.has_value())
+            REQUIRE (stream.getFirstInvalidSample()->sample == *expectedInvalid);
+
+        if (expectedCounts.invalid() == 0)
+        {
+            auto stats = BlockStats<float> (block);
+            REQUIRE (stream.peak() == stats.peak());
+            REQUIRE (stream.rms() == Catch::Approx (stats.rms()).epsilon (1e-9));
+        }
+
+        auto expectedGap = findFirstZeroRun (block, 2);
+        REQUIRE (stream.getFirstGap().has_value() == expectedGap.has_value());
+        if (expectedGap.has_value())
+        {
+            REQUIRE (stream.getFirstGap()->start == expectedGap->start);
+            REQUIRE (stream.getFirstGap()->length == expectedGap->length);
+        }
+
+        size_t expectedFirst = 5000, expectedLast = 0;
+        for (int c = 0; c < 2; ++c)
+            for (size_t i = 0; i < 5000; ++i)
+                if (buffer.getSample (c, (int) i) != 0.0f)
+                {
+                    expectedFirst = juce::jmin (expectedFirst, i);
+                    expectedLast = juce::jmax (expectedLast, i);
+                }
+        REQUIRE (stream.getFirstNonZeroSample()->sample == expectedFirst);
+        REQUIRE (stream.getLastNonZeroSample()->sample == expectedLast);
+    }
+}
+
+TEST_CASE ("StreamingStats stitches silence across pushes", "[streaming_stats]")
+{
+    juce::AudioBuffer<float> buffer (1, 100);
+    auto block = AudioBlock<float> (buffer);
+    StreamingStats<float> stream;
+
+    fillWithSine (block, 1000.f, 48000.f);
+    block.setSample (0, 0, 0.1f); // the sine starts on a zero
+    stream.push (block);
+    block.clear();
+    stream.push (block);
+    stream.push (block);
+    REQUIRE (stream.getFirstGap()->start == 100);
+    REQUIRE (stream.getFirstGap()->length == 200);
+    REQUIRE_THAT (stream, isEmptyAfter (100));
+
+    fillWithSine (block, 1000.f, 48000.f);
+    block.setSample (0, 0, 0.1f);
+    stream.push (block);
+    REQUIRE (stream.getFirstGap()->length == 200);
+    REQUIRE (stream.getLastNonZeroSample()->sample == 399);
+    REQUIRE_FALSE (isEmptyAfter (100).match (stream));
+}
+
+#endif
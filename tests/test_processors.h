@@ -0,0 +1,106 @@
+#pragma once
+
+// Everything juce::AudioProcessor asks for, so a test only has to say what processBlock does
+struct TestProcessor : juce::AudioProcessor
+{
+    std::function<void (juce::AudioBuffer<float>&)> onProcess;
+    std::function<void (juce::AudioBuffer<double>&)> onProcessDouble; // double precision is supported when this is set
+    int numPrepares = 0;
+    int numReleases = 0;
+    juce::int64 lastBlockTimeInSamples = -1;
+
+    TestProcessor() = default;
+    explicit TestProcessor (std::function<void (juce::AudioBuffer<float>&)> f) : onProcess (std::move (f)) {}
+
+    const juce::String getName() const override { return "TestProcessor"; }
+    void prepareToPlay (double, int) override { ++numPrepares; }
+    void releaseResources() override { ++numReleases; }
+
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) override
+    {
+        if (auto playhead = getPlayHead())
+            lastBlockTimeInSamples = *playhead->getPosition()->getTimeInSamples();
+
+        if (onProcess)
+            onProcess (buffer);
+    }
+
+    void processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&) override
+    {
+        if (onProcessDouble)
+            onProcessDouble (buffer);
+    }
+
+    bool supportsDoublePrecisionProcessing() const override { return onProcessDouble != nullptr; }
+
+    double getTailLengthSeconds() const override { return 0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram (int) override {}
+    const juce::String getProgramName (int) override { return {}; }
+    void changeProgramName (int, const juce::String&) override {}
+    void getStateInformation (juce::MemoryBlock&) override {}
+    void setStateInformation (const void*, int) override {}
+};
+
+// Multiplies its input by a "gain" parameter (0 to 2)
+struct GainProcessor : TestProcessor
+{
+    juce::AudioParameterFloat* gain = nullptr;
+
+    GainProcessor()
+    {
+        addParameter (gain = new juce::AudioParameterFloat ("gain", "Gain", 0.0f, 2.0f, 1.0f));
+        onProcess = [this] (juce::AudioBuffer<float>& buffer) {
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                juce::FloatVectorOperations::multiply (buffer.getWritePointer (c), gain->get(), buffer.getNumSamples());
+        };
+    }
+};
+
+// Delays its input by a number of samples, optionally reporting a different latency
+struct DelayProcessor : TestProcessor
+{
+    int delay;
+    int reportedLatency;
+    std::vector<std::vector<double>> lines;
+    size_t position = 0;
+
+    explicit DelayProcessor (int d) : DelayProcessor (d, d) {}
+
+    DelayProcessor (int d, int reported) : delay (d), reportedLatency (reported)
+    {
+        onProcess = [this] (juce::AudioBuffer<float>& buffer) { process (buffer); };
+        onProcessDouble = [this] (juce::AudioBuffer<double>& buffer) { process (buffer); };
+    }
+
+    void prepareToPlay (double rate, int size) override
+    {
+        TestProcessor::prepareToPlay (rate, size);
+        lines.assign (2, std::vector<double> ((size_t) delay + 1, 0.0));
+        position = 0;
+        setLatencySamples (reportedLatency);
+    }
+
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer)
+    {
+        const auto startPosition = position;
+        for (int c = 0; c < juce::jmin (2, buffer.getNumChannels()); ++c)
+        {
+            auto& line = lines[(size_t) c];
+            auto data = buffer.getWritePointer (c);
+            position = startPosition;
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                line[position] = (double) data[i];
+                position = (position + 1) % line.size();
+                data[i] = (SampleType) line[position];
+            }
+        }
+    }
+};
@@ -0,0 +1,157 @@
+#if RUN_MELATONIN_TESTS
+
+    #include "../melatonin_test_helpers.h"
+
+using namespace melatonin;
+
+// every run of at least minLength exact zeros, one sample at a time
+static std::vector<ZeroRun> zeroRunsByHand (const AudioBlock<float>& block, size_t minLength)
+{
+    std::vector<ZeroRun> runs;
+    for (size_t c = 0; c < block.getNumChannels(); ++c)
+    {
+        size_t i = 0;
+        while (i < block.getNumSamples())
+        {
+            if (block.getSample ((int) c, (int) i) != 0)
+            {
+                ++i;
+                continue;
+            }
+            auto runStart = i;
+            while (i < block.getNumSamples() && block.getSample ((int) c, (int) i) == 0)
+                ++i;
+            if (i - runStart >= minLength)
+                runs.push_back ({ c, runStart, i - runStart });
+        }
+    }
+    return runs;
+}
+
+TEST_CASE ("findZeroRuns", "[zero_runs]")
+{
+    juce::AudioBuffer<float> buffer (2, 300);
+    auto block = AudioBlock<float> (buffer);
+    block.fill (0.5f);
+
+    SECTION ("finds runs across chunk boundaries and at the ends")
+    {
+        block.setSample (0, 0, 0.f);
+        block.setSample (0, 1, 0.f);
+        for (int i = 60; i < 70; ++i)
+            block.setSample (0, i, 0.f);
+        block.setSample (1, 150, 0.f);
+        block.setSample (1, 298, 0.f);
+        block.setSample (1, 299, 0.f);
+
+        auto runs = findZeroRuns (block, 1);
+        REQUIRE (runs.size() == 4);
+        REQUIRE (runs[0].start == 0);
+        REQUIRE (runs[0].length == 2);
+        REQUIRE (runs[1].start == 60);
+        REQUIRE (runs[1].length == 10);
+        REQUIRE (runs[2].channel == 1);
+        REQUIRE (runs[2].start == 150);
+        REQUIRE (runs[3].end() == 300);
+
+        REQUIRE (findZeroRuns (block, 2).size() == 3);
+        REQUIRE (numberOfConsecutiveZeros (block) == 14);
+    }
+
+    SECTION ("a threshold counts small samples as zero")
+    {
+        block.setSample (0, 100, 0.001f);
+        block.setSample (0, 101, -0.001f);
+        REQUIRE (findZeroRuns (block, 2).empty());
+        REQUIRE (findZeroRuns (block, 2, 0.01f).size() == 1);
+    }
+
+    SECTION ("matches a sample by sample scan")
+    {
+        juce::Random random (42);
+        for (int trial = 0; trial < 20; ++trial)
+        {
+            for (size_t c = 0; c < 2; ++c)
+                for (size_t i = 0; i < 300; ++i)
+                    block.setSample ((int) c, (int) i, random.nextInt (3) == 0 ? 0.f : 1.f);
+
+            auto expected = zeroRunsByHand (block, 2);
+            auto runs = findZeroRuns (block, 2);
+            REQUIRE (runs.size() == expected.size());
+            for (size_t r = 0; r < runs.size(); ++r)
+            {
+                REQUIRE (runs[r].channel == expected[r].channel);
+                REQUIRE (runs[r].start == expected[r].start);
+                REQUIRE (runs[r].length == expected[r].length);
+            }
+        }
+    }
+}
+
+TEST_CASE ("findFirstZeroRun", "[zero_runs]")
+{
+    juce::AudioBuffer<float> buffer (3, 500);
+    auto block = AudioBlock<float> (buffer);
+    block.fill (0.5f);
+
+    SECTION ("returns the earliest run on any channel")
+    {
+        for (int i = 400; i < 410; ++i)
+            block.setSample (0, i, 0.f);
+        for (int i = 200; i < 300; ++i)
+            block.setSample (2, i, 0.f);
+
+        auto run = findFirstZeroRun (block, 2);
+        REQUIRE (run.has_value());
+        REQUIRE (run->channel == 2);
+        REQUIRE (run->start == 200);
+        REQUIRE (run->length == 100); // not cut short by the scan bound
+    }
+
+    SECTION ("the lowest channel wins a tie")
+    {
+        block.setSample (1, 50, 0.f);
+        block.setSample (1, 51, 0.f);
+        block.setSample (2, 50, 0.f);
+        block.setSample (2, 51, 0.f);
+        auto run = findFirstZeroRun (block, 2);
+        REQUIRE (run->channel == 1);
+    }
+
+    SECTION ("respects start and end")
+    {
+        block.setSample (0, 10, 0.f);
+        block.setSample (0, 11, 0.f);
+        block.setSample (1, 100, 0.f);
+        block.setSample (1, 101, 0.f);
+        REQUIRE (findFirstZeroRun (block, 2, 0.f, 12)->start == 100);
+        REQUIRE_FALSE (findFirstZeroRun (block, 2, 0.f, 12, 101).has_value());
+    }
+}
+
+TEST_CASE ("fill and empty predicates", "[zero_runs]")
+{
+    juce::AudioBuffer<float> buffer (1, 256);
+    auto block = AudioBlock<float> (buffer);
+    block.clear();
+    for (int i = 100; i < 200; ++i)
+        block.setSample (0, i, 0.5f);
+
+    REQUIRE (blockIsEmptyUntil (block, 100));
+    REQUIRE_FALSE (blockIsEmptyUntil (block, 101));
+    REQUIRE (blockIsEmptyAfter (block, 200));
+    REQUIRE_FALSE (blockIsEmptyAfter (block, 199));
+    REQUIRE (blockIsFilledBetween (block, 100, 200));
+    REQUIRE_FALSE (blockIsFilledBetween (block, 98, 200));
+    REQUIRE (blockIsFilledBetween (block, 150, 201)); // a single zero is allowed
+    REQUIRE_FALSE (blockIsFilled (block));
+
+    auto matcher = isFilledBetween (150, 250);
+    REQUIRE_FALSE (matcher.match (block));
+    REQUIRE (matcher.describe().find ("Found 50 consecutive zeros on channel 0 starting at sample 200") != std::string::npos);
+
+    auto nonZero = findFirstNonZeroSample (block);
+    REQUIRE (nonZero->sample == 100);
+}
+
+#endif